@@ -0,0 +1,15 @@
+#
+# ovd_bench, the end-to-end construction/post-processing benchmark.
+# Build with CMAKE_BUILD_TYPE=Release for meaningful numbers.
+#
+MESSAGE(STATUS "configuring benchmark: ovd_bench")
+
+add_executable(ovd_bench ${CMAKE_SOURCE_DIR}/bench/ovd_bench.cpp)
+add_dependencies(ovd_bench libopenvoronoi)
+target_link_libraries(ovd_bench libopenvoronoi)
+
+# a small run, to check that the benchmark itself works
+if( ${BUILD_CPP_TESTS} MATCHES ON)
+  ADD_TEST(ovd_bench_smoke ovd_bench --sizes 20,60 --format json)
+  ADD_TEST(ovd_bench_memory ovd_bench --sizes 20,60 --memory)
+endif()
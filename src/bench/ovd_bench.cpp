@@ -0,0 +1,639 @@
+/*
+ *  Copyright (c) 2010-2012 Anders Wallin (anders.e.e.wallin "at" gmail.com).
+ *
+ *  This file is part of Openvoronoi
+ *  (see https://github.com/aewallin/openvoronoi).
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// ovd_bench - end-to-end construction and post-processing benchmark.
+//
+// Generates deterministic workloads (seeded), builds the diagram and runs the
+// post-processing stages on it. Run-times are reported both in seconds and
+// normalised by n*log2(n), where n is the number of input sites (points+segments).
+// Output is CSV (default) or JSON, so results from different builds and
+// graph-container choices (see graph.hpp) can be compared.
+//
+// The "arcs" workload is a polygon of circular arcs and lines, inserted with
+// insert_arc_site(). "arcs_tessellated" is the same polygon with each arc replaced
+// by 16 line-segments, for comparison.
+//
+// With --memory, the diagram is only built, and VoronoiDiagram::memory_usage()
+// is reported instead of run-times, including bytes per input site.
+//
+// With --trace file.json, trace events are written to file.json in Chrome trace
+// format (open in chrome://tracing or ui.perfetto.dev). The library only records
+// events when built with -DOVD_TRACE=ON, see trace.hpp.
+//
+// usage: ovd_bench [--format csv|json] [--sizes 100,1000,..] [--seed s]
+//                  [--workloads uniform,clustered,...] [--repeat r] [--memory]
+//                  [--trace file.json]
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <chrono>
+
+#include <boost/foreach.hpp>
+#include <boost/preprocessor/stringize.hpp>
+#include <boost/random/mersenne_twister.hpp>
+#include <boost/random/uniform_real_distribution.hpp>
+#include <boost/random/normal_distribution.hpp>
+
+#include "voronoidiagram.hpp"
+#include "polygon_interior_filter.hpp"
+#include "medial_axis_filter.hpp"
+#include "medial_axis_walk.hpp"
+#include "medial_axis_pocket.hpp"
+#include "medial_axis_graph.hpp"
+#include "offset.hpp"
+#include "offset_sorter.hpp"
+#include "offset_polylines.hpp"
+#include "contour_toolpath.hpp"
+#include "zigzag_pocket.hpp"
+#include "toolpath_order.hpp"
+#include "parallel_offset.hpp"
+#include "version.hpp"
+#include "trace.hpp"
+#include "utility/polygon_generator.hpp"
+
+namespace {
+
+/// a circular arc, between two points of a Workload
+struct Arc {
+    int start;         ///< start point index
+    int end;           ///< end point index
+    ovd::Point center; ///< arc center
+    bool cw;           ///< clockwise arc
+};
+
+/// input geometry for one benchmark run
+struct Workload {
+    std::string name;                           ///< workload type
+    std::vector<ovd::Point> points;             ///< point sites
+    std::vector< std::pair<int,int> > segments; ///< line sites, as indices into points
+    std::vector<Arc> arcs;                      ///< arc sites
+    bool closed;                                ///< segments and arcs form closed CCW polygons
+    Workload() : closed(false) {}
+};
+
+/// wall-clock stopwatch
+class Timer {
+public:
+    Timer() { reset(); }
+    void reset() { start = std::chrono::steady_clock::now(); }
+    double seconds() const {
+        return std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+    }
+private:
+    std::chrono::steady_clock::time_point start;
+};
+
+/// \brief offset visitor that only counts elements, like a streaming toolpath writer
+class CountingVisitor : public ovd::OffsetVisitor {
+public:
+    CountingVisitor() : elements(0) {}
+    virtual void begin_loop(double) {}
+    virtual void line(const ovd::Point&, const ovd::Point&, ovd::HEFace) { elements++; }
+    virtual void arc(const ovd::Point&, const ovd::Point&, const ovd::Point&, double, bool, ovd::HEFace) { elements++; }
+    virtual void end_loop() {}
+    long elements; ///< number of offset-elements seen
+};
+
+/// one timed phase of one run
+struct Result {
+    std::string workload;
+    int n_points;
+    int n_segments;
+    int n_arcs;
+    std::string phase;
+    double seconds;
+};
+
+typedef boost::random::mt19937 RNG;
+
+double uniform(RNG& rng, double lo, double hi) {
+    boost::random::uniform_real_distribution<double> d(lo,hi);
+    return d(rng);
+}
+
+// all workloads fit inside a square of half-width 0.7, i.e. within the unit far-circle
+
+/// n uniformly distributed random points
+Workload uniform_points(int n, unsigned int seed) {
+    Workload w;
+    w.name = "uniform";
+    RNG rng(seed);
+    for (int i=0;i<n;i++)
+        w.points.push_back( ovd::Point( uniform(rng,-0.7,0.7), uniform(rng,-0.7,0.7) ) );
+    return w;
+}
+
+/// n points in gaussian clusters of roughly 50 points each
+Workload clustered_points(int n, unsigned int seed) {
+    Workload w;
+    w.name = "clustered";
+    RNG rng(seed);
+    int nclusters = std::max(1, n/50);
+    std::vector<ovd::Point> centers;
+    for (int i=0;i<nclusters;i++)
+        centers.push_back( ovd::Point( uniform(rng,-0.6,0.6), uniform(rng,-0.6,0.6) ) );
+    boost::random::normal_distribution<double> gauss(0.0, 0.02);
+    while ( (int)w.points.size() < n ) {
+        ovd::Point p = centers[ w.points.size() % nclusters ] + ovd::Point( gauss(rng), gauss(rng) );
+        if ( std::fabs(p.x) < 0.7 && std::fabs(p.y) < 0.7 )
+            w.points.push_back(p);
+    }
+    return w;
+}
+
+/// a random simple polygon with n vertices, from PolygonGenerator
+Workload random_polygon(const std::string& name, ovd::PolygonGenerator::Method m, int n, int n_islands, unsigned int seed) {
+    Workload w;
+    w.name = name;
+    ovd::PolygonGenerator gen(seed);
+    ovd::PolygonSet ps = gen.polygon(m, n, n_islands);
+    w.points = ps.points;
+    w.segments = ps.segments;
+    w.closed = true;
+    return w;
+}
+
+/// a grid of small random star-shaped polygons with roughly n vertices in total
+Workload small_polygons(int n, unsigned int seed) {
+    Workload w;
+    w.name = "small_polygons";
+    ovd::PolygonGenerator gen(seed);
+    ovd::PolygonSet ps;
+    int npoly = std::max(1, n/6);
+    int side = (int)ceil( sqrt( (double)npoly ) );
+    double cell = 1.4/side;
+    for (int i=0;i<npoly;i++) {
+        ovd::Point c( -0.7 + cell*(i%side + 0.5), -0.7 + cell*(i/side + 0.5) );
+        ps.add_loop( gen.star(6, c, 0.4*cell) );
+    }
+    w.points = ps.points;
+    w.segments = ps.segments;
+    w.closed = true;
+    return w;
+}
+
+/// one long horizontal chain of n-1 collinear segments with random lengths.
+/// (several parallel chains, or a chain that is not exactly axis-aligned, run into
+/// degenerate cases in the parallel line-line bisector code and are not used here)
+Workload collinear_chain(int n, unsigned int seed) {
+    Workload w;
+    w.name = "collinear";
+    RNG rng(seed);
+    std::vector<double> xs;
+    for (int i=0;i<n;i++)
+        xs.push_back( uniform(rng,-0.7,0.7) );
+    std::sort( xs.begin(), xs.end() );
+    for (int i=0;i<n;i++) {
+        w.points.push_back( ovd::Point(xs[i], 0.1) );
+        if (i>0)
+            w.segments.push_back( std::make_pair(i-1, i) );
+    }
+    return w;
+}
+
+/// a polygon with n vertices, where the edges are in turn an outward arc, an inward arc and a line.
+/// with \a tessellate each arc is replaced by 16 line-segments.
+Workload arc_polygon(int n, bool tessellate, unsigned int seed) {
+    Workload w;
+    w.name = tessellate ? "arcs_tessellated" : "arcs";
+    w.closed = true;
+    RNG rng(seed);
+    std::vector<ovd::Point> corners;
+    double chord = 0.6*2*M_PI/n;
+    for (int i=0;i<n;i++) {
+        double a = 2*M_PI*i/n;
+        double r = 0.6 + uniform(rng,-0.1,0.1)*chord; // small jitter, so that inward arcs do not intersect
+        corners.push_back( ovd::Point( r*cos(a), r*sin(a) ) );
+    }
+    const int segs = 16;
+    for (int i=0;i<n;i++) {
+        int type = i%3; // 0: outward arc, 1: inward arc, 2: line
+        ovd::Point p1 = corners[i];
+        ovd::Point p2 = corners[(i+1)%n];
+        int start = w.points.size();
+        w.points.push_back(p1);
+        int end = start+1; // index of the next corner
+        if (tessellate && type!=2)
+            end += segs-1;
+        if (i+1==n)
+            end = 0;
+        if (type==2) {
+            w.segments.push_back( std::make_pair(start, end) );
+            continue;
+        }
+        Arc arc;
+        arc.start = start;
+        arc.end = end;
+        ovd::Point left = (p2-p1).xy_perp(); // into the polygon
+        arc.center = 0.5*(p1+p2) + (type==0 ? 0.6 : -0.6)*left;
+        arc.cw = (type==1);
+        if (!tessellate) {
+            w.arcs.push_back(arc);
+            continue;
+        }
+        ovd::Point u = p1 - arc.center;
+        ovd::Point v = p2 - arc.center;
+        double sweep = atan2( u.cross(v), u.dot(v) ); // these arcs are less than a half-circle
+        for (int k=1;k<segs;k++) {
+            double a = sweep*k/segs;
+            w.points.push_back( arc.center + ovd::Point( cos(a)*u.x - sin(a)*u.y, sin(a)*u.x + cos(a)*u.y ) );
+        }
+        for (int k=0;k<segs;k++)
+            w.segments.push_back( std::make_pair( start+k, (k+1<segs) ? start+k+1 : end ) );
+    }
+    return w;
+}
+
+Workload make_workload(const std::string& name, int n, unsigned int seed) {
+    if (name=="uniform")
+        return uniform_points(n,seed);
+    else if (name=="clustered")
+        return clustered_points(n,seed);
+    else if (name=="polygon")
+        return random_polygon(name, ovd::PolygonGenerator::SPACE_PARTITIONING, n, 0, seed);
+    else if (name=="koch")
+        return random_polygon(name, ovd::PolygonGenerator::KOCH, n, 0, seed);
+    else if (name=="islands")
+        return random_polygon(name, ovd::PolygonGenerator::STAR, n/2, n/16, seed); // islands have 8 vertices each
+    else if (name=="small_polygons")
+        return small_polygons(n,seed);
+    else if (name=="collinear")
+        return collinear_chain(n,seed);
+    else if (name=="arcs")
+        return arc_polygon(n,false,seed);
+    else if (name=="arcs_tessellated")
+        return arc_polygon(n,true,seed);
+    std::cout << "ovd_bench: unknown workload " << name << "\n";
+    exit(-1);
+}
+
+/// build the diagram for Workload w and time each stage.
+/// the interior filter, medial-axis and pocketing stages only run on closed polygons.
+void run(const Workload& w, std::vector<Result>& results) {
+    Result r;
+    r.workload = w.name;
+    r.n_points = w.points.size();
+    r.n_segments = w.segments.size();
+    r.n_arcs = w.arcs.size();
+
+    ovd::VoronoiDiagram* vd = new ovd::VoronoiDiagram(1);
+    vd->set_silent(true);
+    Timer t;
+    std::vector<int> ids;
+    BOOST_FOREACH(const ovd::Point& p, w.points) {
+        ids.push_back( vd->insert_point_site(p) );
+    }
+    r.phase = "insert_point_site"; r.seconds = t.seconds(); results.push_back(r);
+    if ( w.segments.empty() && w.arcs.empty() ) {
+        delete vd;
+        return;
+    }
+
+    t.reset();
+    for (unsigned int i=0;i<w.segments.size();i++)
+        vd->insert_line_site( ids[w.segments[i].first], ids[w.segments[i].second] );
+    r.phase = "insert_line_site"; r.seconds = t.seconds(); results.push_back(r);
+
+    if ( !w.arcs.empty() ) {
+        t.reset();
+        BOOST_FOREACH(const Arc& a, w.arcs) {
+            vd->insert_arc_site( ids[a.start], ids[a.end], a.center, a.cw );
+        }
+        r.phase = "insert_arc_site"; r.seconds = t.seconds(); results.push_back(r);
+    }
+
+    if (w.closed) {
+        t.reset();
+        ovd::polygon_interior_filter pi(true);
+        vd->filter(&pi);
+        r.phase = "filter_interior"; r.seconds = t.seconds(); results.push_back(r);
+    }
+
+    ovd::HEGraph& g = vd->get_graph_reference();
+    t.reset();
+    ovd::Offset of(g);
+    for (int i=1;i<=10;i++)
+        of.offset( 0.002*i );
+    r.phase = "offset"; r.seconds = t.seconds(); results.push_back(r);
+
+    // the same distances in one call
+    t.reset();
+    std::vector<double> ts;
+    for (int i=1;i<=10;i++)
+        ts.push_back( 0.002*i );
+    std::vector<ovd::OffsetLoops> levels = of.offset(ts);
+    r.phase = "offset_multi"; r.seconds = t.seconds(); results.push_back(r);
+
+    // the same distances, streamed without storing the loops
+    t.reset();
+    CountingVisitor counter;
+    of.offset(ts, counter);
+    r.phase = "offset_stream"; r.seconds = t.seconds(); results.push_back(r);
+
+    // the same distances, as polylines in flat arrays
+    t.reset();
+    ovd::OffsetPolylines polylines(1e-4);
+    of.offset(ts, polylines);
+    r.phase = "offset_polylines"; r.seconds = t.seconds(); results.push_back(r);
+
+    // the same distances, on the region of the first loop only
+    if ( !levels.empty() && !levels[0].empty() ) {
+        ovd::Offset region_offset(g);
+        region_offset.clearance_cache(); // built as for "offset" above, not timed here
+        t.reset();
+        region_offset.set_region( (++levels[0].front().vertices.begin())->f );
+        region_offset.offset(ts);
+        r.phase = "offset_region"; r.seconds = t.seconds(); results.push_back(r);
+    }
+
+    // the same distances on all hardware threads
+    t.reset();
+    ovd::ParallelOffset pof(g);
+    pof.offset(ts);
+    r.phase = "offset_parallel"; r.seconds = t.seconds(); results.push_back(r);
+
+    // nest the loops into a machining-graph
+    t.reset();
+    ovd::OffsetSorter sorter(g, of.clearance_cache());
+    BOOST_FOREACH(const ovd::OffsetLoops& loops, levels) {
+        sorter.add_loops(loops);
+    }
+    sorter.sort_loops();
+    r.phase = "offset_sort"; r.seconds = t.seconds(); results.push_back(r);
+
+    // link the nested loops into a contour-parallel toolpath
+    t.reset();
+    ovd::ContourToolpath toolpath(sorter);
+    toolpath.run();
+    r.phase = "contour_toolpath"; r.seconds = t.seconds(); results.push_back(r);
+    if (!w.closed) {
+        delete vd;
+        return;
+    }
+
+    // zig-zag toolpath inside the pocket
+    t.reset();
+    ovd::ZigZagPocket zz(g);
+    zz.run(0.004, 0.003);
+    r.phase = "zigzag_pocket"; r.seconds = t.seconds(); results.push_back(r);
+
+    t.reset();
+    ovd::medial_axis_filter ma;
+    vd->filter(&ma);
+    r.phase = "filter_medial_axis"; r.seconds = t.seconds(); results.push_back(r);
+
+    t.reset();
+    ovd::MedialAxisGraph mag = ovd::extract_medial_axis(g);
+    r.phase = "extract_medial_axis"; r.seconds = t.seconds(); results.push_back(r);
+
+    // pocketing does not modify the graph, but MedialAxisWalk invalidates the edges it walks, so pocket first.
+    t.reset();
+    ovd::medial_axis_pocket map(g);
+    map.set_width(0.005);
+    map.run();
+    r.phase = "medial_axis_pocket"; r.seconds = t.seconds(); results.push_back(r);
+
+    t.reset();
+    ovd::MedialAxisWalk maw(g);
+    ovd::MedialChainList chains = maw.walk();
+    r.phase = "medial_axis_walk"; r.seconds = t.seconds(); results.push_back(r);
+
+    t.reset();
+    ovd::ToolpathOrder order;
+    order.run(chains);
+    r.phase = "toolpath_order"; r.seconds = t.seconds(); results.push_back(r);
+
+    delete vd;
+}
+
+/// memory used by the diagram of one workload
+struct MemoryResult {
+    std::string workload;
+    int n_points;
+    int n_segments;
+    int n_arcs;
+    ovd::MemoryUsage m;
+};
+
+/// build the diagram for Workload w and record its memory usage
+void measure_memory(const Workload& w, std::vector<MemoryResult>& results) {
+    MemoryResult r;
+    r.workload = w.name;
+    r.n_points = w.points.size();
+    r.n_segments = w.segments.size();
+    r.n_arcs = w.arcs.size();
+    ovd::VoronoiDiagram* vd = new ovd::VoronoiDiagram(1);
+    vd->set_silent(true);
+    std::vector<int> ids;
+    BOOST_FOREACH(const ovd::Point& p, w.points) {
+        ids.push_back( vd->insert_point_site(p) );
+    }
+    for (unsigned int i=0;i<w.segments.size();i++)
+        vd->insert_line_site( ids[w.segments[i].first], ids[w.segments[i].second] );
+    BOOST_FOREACH(const Arc& a, w.arcs) {
+        vd->insert_arc_site( ids[a.start], ids[a.end], a.center, a.cw );
+    }
+    r.m = vd->memory_usage();
+    results.push_back(r);
+    delete vd;
+}
+
+/// run-time normalised by n*log2(n), in microseconds
+double normalised_us(const Result& r) {
+    double n = r.n_points + r.n_segments + r.n_arcs;
+    if (n<2)
+        return 0;
+    return 1e6*r.seconds/( n*log2(n) );
+}
+
+std::vector<std::string> split(const std::string& s) {
+    std::vector<std::string> out;
+    std::stringstream ss(s);
+    std::string item;
+    while ( std::getline(ss,item,',') )
+        out.push_back(item);
+    return out;
+}
+
+std::string build_notes() {
+#ifdef NDEBUG
+    return "NDEBUG";
+#else
+    return "assertions enabled, timings include diagram validity checks";
+#endif
+}
+
+void write_csv(const std::vector<Result>& results) {
+    std::cout << "# ovd_bench " << ovd::version() << " " << ovd::build_type() << " (" << build_notes() << ")\n";
+    std::cout << "# containers: out-edge " << BOOST_PP_STRINGIZE(OUT_EDGE_CONTAINER)
+              << ", vertex " << BOOST_PP_STRINGIZE(VERTEX_CONTAINER)
+              << ", edge-list " << BOOST_PP_STRINGIZE(EDGE_LIST_CONTAINER) << "\n";
+    std::cout << "workload,n_points,n_segments,n_arcs,phase,seconds,us_per_nlogn\n";
+    BOOST_FOREACH(const Result& r, results) {
+        std::cout << r.workload << "," << r.n_points << "," << r.n_segments << "," << r.n_arcs << ","
+                  << r.phase << "," << r.seconds << "," << normalised_us(r) << "\n";
+    }
+}
+
+void write_json(const std::vector<Result>& results) {
+    std::cout << "{\n";
+    std::cout << "  \"version\": \"" << ovd::version() << "\",\n";
+    std::cout << "  \"build_type\": \"" << ovd::build_type() << "\",\n";
+    std::cout << "  \"notes\": \"" << build_notes() << "\",\n";
+    std::cout << "  \"containers\": { \"out_edge\": \"" << BOOST_PP_STRINGIZE(OUT_EDGE_CONTAINER)
+              << "\", \"vertex\": \"" << BOOST_PP_STRINGIZE(VERTEX_CONTAINER)
+              << "\", \"edge_list\": \"" << BOOST_PP_STRINGIZE(EDGE_LIST_CONTAINER) << "\" },\n";
+    std::cout << "  \"results\": [\n";
+    for (unsigned int i=0;i<results.size();i++) {
+        const Result& r = results[i];
+        std::cout << "    { \"workload\": \"" << r.workload << "\", \"n_points\": " << r.n_points
+                  << ", \"n_segments\": " << r.n_segments << ", \"n_arcs\": " << r.n_arcs
+                  << ", \"phase\": \"" << r.phase
+                  << "\", \"seconds\": " << r.seconds << ", \"us_per_nlogn\": " << normalised_us(r) << " }"
+                  << ( i+1<results.size() ? ",\n" : "\n" );
+    }
+    std::cout << "  ]\n}\n";
+}
+
+void write_memory_csv(const std::vector<MemoryResult>& results) {
+    std::cout << "# ovd_bench --memory " << ovd::version() << " " << ovd::build_type() << "\n";
+    std::cout << "# containers: out-edge " << BOOST_PP_STRINGIZE(OUT_EDGE_CONTAINER)
+              << ", vertex " << BOOST_PP_STRINGIZE(VERTEX_CONTAINER)
+              << ", edge-list " << BOOST_PP_STRINGIZE(EDGE_LIST_CONTAINER) << "\n";
+    std::cout << "workload,n_points,n_segments,n_arcs,vertices,half_edges,out_edge_lists,faces,sites,"
+              << "kdtree,vertex_map,scratch,total,bytes_per_site\n";
+    BOOST_FOREACH(const MemoryResult& r, results) {
+        std::cout << r.workload << "," << r.n_points << "," << r.n_segments << "," << r.n_arcs << ","
+                  << r.m.vertices << "," << r.m.half_edges << "," << r.m.out_edge_lists << ","
+                  << r.m.faces << "," << r.m.sites << "," << r.m.kdtree << "," << r.m.vertex_map << ","
+                  << r.m.scratch << "," << r.m.total() << "," << r.m.bytes_per_site << "\n";
+    }
+}
+
+void write_memory_json(const std::vector<MemoryResult>& results) {
+    std::cout << "{\n";
+    std::cout << "  \"version\": \"" << ovd::version() << "\",\n";
+    std::cout << "  \"build_type\": \"" << ovd::build_type() << "\",\n";
+    std::cout << "  \"containers\": { \"out_edge\": \"" << BOOST_PP_STRINGIZE(OUT_EDGE_CONTAINER)
+              << "\", \"vertex\": \"" << BOOST_PP_STRINGIZE(VERTEX_CONTAINER)
+              << "\", \"edge_list\": \"" << BOOST_PP_STRINGIZE(EDGE_LIST_CONTAINER) << "\" },\n";
+    std::cout << "  \"memory\": [\n";
+    for (unsigned int i=0;i<results.size();i++) {
+        const MemoryResult& r = results[i];
+        std::cout << "    { \"workload\": \"" << r.workload << "\", \"n_points\": " << r.n_points
+                  << ", \"n_segments\": " << r.n_segments << ", \"n_arcs\": " << r.n_arcs
+                  << ", \"vertices\": " << r.m.vertices << ", \"half_edges\": " << r.m.half_edges
+                  << ", \"out_edge_lists\": " << r.m.out_edge_lists << ", \"faces\": " << r.m.faces
+                  << ", \"sites\": " << r.m.sites << ", \"kdtree\": " << r.m.kdtree
+                  << ", \"vertex_map\": " << r.m.vertex_map << ", \"scratch\": " << r.m.scratch
+                  << ", \"total\": " << r.m.total() << ", \"bytes_per_site\": " << r.m.bytes_per_site << " }"
+                  << ( i+1<results.size() ? ",\n" : "\n" );
+    }
+    std::cout << "  ]\n}\n";
+}
+
+void usage() {
+    std::cout << "usage: ovd_bench [--format csv|json] [--sizes 100,1000,...] [--seed s] [--repeat r] [--memory]\n";
+    std::cout << "                 [--trace file.json]\n";
+    std::cout << "                 [--workloads uniform,clustered,polygon,koch,islands,small_polygons,collinear,\n";
+    std::cout << "                              arcs,arcs_tessellated]\n";
+}
+
+} // end anonymous namespace
+
+int main(int argc, char* argv[]) {
+    std::string format = "csv";
+    std::vector<std::string> sizes = split("100,300,1000,3000");
+    std::vector<std::string> workloads = split("uniform,clustered,polygon,koch,islands,small_polygons,collinear,arcs,arcs_tessellated");
+    unsigned int seed = 42;
+    int repeat = 1;
+    bool memory = false;
+    std::string trace_file;
+    for (int i=1;i<argc;i++) {
+        std::string arg(argv[i]);
+        if ( arg=="--help" ) {
+            usage();
+            return 0;
+        }
+        if ( arg=="--memory" ) {
+            memory = true;
+            continue;
+        }
+        if ( i+1 == argc ) {
+            usage();
+            return -1;
+        }
+        std::string val(argv[++i]);
+        if ( arg=="--format" )
+            format = val;
+        else if ( arg=="--sizes" )
+            sizes = split(val);
+        else if ( arg=="--workloads" )
+            workloads = split(val);
+        else if ( arg=="--seed" )
+            seed = atoi( val.c_str() );
+        else if ( arg=="--repeat" )
+            repeat = atoi( val.c_str() );
+        else if ( arg=="--trace" )
+            trace_file = val;
+        else {
+            usage();
+            return -1;
+        }
+    }
+
+    ovd::trace::set_enabled( !trace_file.empty() );
+    ovd::trace::set_buffer_size( 1<<20 );
+
+    std::vector<Result> results;
+    std::vector<MemoryResult> memory_results;
+    BOOST_FOREACH(const std::string& name, workloads) {
+        BOOST_FOREACH(const std::string& size, sizes) {
+            Workload w = make_workload(name, atoi( size.c_str() ), seed);
+            if (memory) {
+                measure_memory(w,memory_results);
+                continue;
+            }
+            for (int rep=0;rep<repeat;rep++)
+                run(w,results);
+        }
+    }
+
+    if (memory && format=="json")
+        write_memory_json(memory_results);
+    else if (memory)
+        write_memory_csv(memory_results);
+    else if (format=="json")
+        write_json(results);
+    else
+        write_csv(results);
+
+    if ( !trace_file.empty() ) {
+        std::ofstream f( trace_file.c_str() );
+        ovd::trace::write_chrome_trace(f);
+    }
+    return 0;
+}
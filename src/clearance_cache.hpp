@@ -0,0 +1,165 @@
+/*
+ *  Copyright (c) 2010-2012 Anders Wallin (anders.e.e.wallin "at" gmail.com).
+ *
+ *  This file is part of Openvoronoi
+ *  (see https://github.com/aewallin/openvoronoi).
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <vector>
+#include <limits>
+#include <algorithm>
+#include <boost/foreach.hpp>
+
+#include "graph.hpp"
+
+namespace ovd
+{
+
+/// \brief clearance data of a vd-graph, in flat arrays
+///
+/// post-processing (offsets, sorting of offset loops) reads the clearance dist() of the
+/// vertices at each end of an edge many times, while walking around faces. here the edges of each face
+/// are stored in face order, with the clearance at both ends, so that a walk around a face reads
+/// consecutive records instead of the vertex- and edge-records of the graph.
+///
+/// edges and vertices are numbered: the edges of face f are begin(f) ... end(f)-1.
+/// each edge record holds the numbers of its next edge, its twin, and its vertices.
+///
+/// the cache is built by build(), and records HEGraph::generation(), so that a changed graph
+/// (a site inserted, or a filter run) is detected with stale().
+class ClearanceCache {
+public:
+    /// \brief one half-edge, with the clearance at its ends
+    struct Edge {
+        double src_t;       ///< clearance at the source vertex
+        double trg_t;       ///< clearance at the target vertex
+        HEEdge e;           ///< the edge in the graph
+        unsigned int next;  ///< next edge on the same face
+        unsigned int twin;  ///< twin edge, on the adjacent face, or NO_EDGE on the outer boundary
+        unsigned int src;   ///< number of the source vertex
+        unsigned int trg;   ///< number of the target vertex
+        HEFace face;        ///< face to the left of the edge
+        bool valid;         ///< EdgeProps::valid, as set by filters
+        bool apex;          ///< an end is an APEX vertex, i.e. the clearance has a minimum there
+        /// smallest clearance on the edge
+        double lo() const { return std::min(src_t,trg_t); }
+        /// largest clearance on the edge
+        double hi() const { return std::max(src_t,trg_t); }
+        /// true if the clearance increases past \a t along the edge
+        bool increasing(double t) const { return src_t < t && t < trg_t; }
+        /// true if the clearance decreases past \a t along the edge
+        bool decreasing(double t) const { return trg_t < t && t < src_t; }
+    };
+    /// twin of an edge that has none
+    static const unsigned int NO_EDGE = 0xFFFFFFFF;
+    /// create an empty cache
+    ClearanceCache() : _generation(0), _built(false) {}
+
+    /// build the cache for \a g
+    void build(const HEGraph& g) {
+        vertex_t.clear();
+        vertex_t.reserve( g.num_vertices() );
+        BOOST_FOREACH( HEVertex v, g.vertices() ) {
+            vertex_t.push_back( g[v].dist() );
+        }
+        std::vector<unsigned int> source; // vertex number of the source of each edge, by EdgeProps::index
+        g.source_numbers(source);
+        // walk the faces, and number the edges in face order
+        edge_number.resize( g.num_edges() );
+        edges.clear();
+        edges.reserve( g.num_edges() );
+        face_begin.resize( g.num_faces()+1 );
+        for (HEFace f=0; f<g.num_faces(); f++) {
+            face_begin[f] = edges.size();
+            HEEdge start = g[f].edge;
+            HEEdge current = start;
+            do {
+                Edge r;
+                unsigned int n = edges.size();
+                r.e = current;
+                r.next = n+1;
+                r.twin = NO_EDGE;
+                r.face = f;
+                r.valid = g[current].valid;
+                r.src = source[ g[current].index ];
+                r.trg = source[ g[ g[current].next ].index ];
+                r.src_t = vertex_t[r.src];
+                r.trg_t = vertex_t[r.trg];
+                r.apex = ( g[ g.source(current) ].type == APEX || g[ g.target(current) ].type == APEX );
+                edge_number[ g[current].index ] = n;
+                edges.push_back(r);
+                current = g[current].next;
+            } while ( current!=start );
+            edges.back().next = face_begin[f];
+        }
+        face_begin[ g.num_faces() ] = edges.size();
+        for (unsigned int n=0;n<edges.size();n++) {
+            HEEdge twin = g[ edges[n].e ].twin;
+            if ( twin != HEEdge() )
+                edges[n].twin = edge_number[ g[twin].index ];
+        }
+        face_lo.resize( g.num_faces() );
+        face_hi.resize( g.num_faces() );
+        for (HEFace f=0; f<g.num_faces(); f++) {
+            face_lo[f] = std::numeric_limits<double>::max();
+            face_hi[f] = -std::numeric_limits<double>::max();
+            for (unsigned int n=begin(f); n<end(f); n++) {
+                face_lo[f] = std::min( face_lo[f], edges[n].src_t );
+                face_hi[f] = std::max( face_hi[f], edges[n].src_t );
+            }
+        }
+        _generation = g.generation();
+        _built = true;
+    }
+    /// true if build() has not been called for the current state of \a g
+    bool stale(const HEGraph& g) const { return !_built || _generation != g.generation(); }
+    /// HEGraph::generation() when the cache was built
+    unsigned long generation() const { return _generation; }
+
+    /// number of faces
+    unsigned int num_faces() const { return face_lo.size(); }
+    /// number of vertices
+    unsigned int num_vertices() const { return vertex_t.size(); }
+    /// number of (half-)edges
+    unsigned int num_edges() const { return edges.size(); }
+    /// first edge of face \a f
+    unsigned int begin(HEFace f) const { return face_begin[f]; }
+    /// one past the last edge of face \a f
+    unsigned int end(HEFace f) const { return face_begin[f+1]; }
+    /// edge number \a n
+    const Edge& edge(unsigned int n) const { return edges[n]; }
+    /// the number of edge \a e
+    unsigned int index(HEEdge e, const HEGraph& g) const { return edge_number[ g[e].index ]; }
+    /// smallest vertex clearance on face \a f
+    double face_min(HEFace f) const { return face_lo[f]; }
+    /// largest vertex clearance on face \a f
+    double face_max(HEFace f) const { return face_hi[f]; }
+    /// clearance of vertex number \a n
+    double vertex_dist(unsigned int n) const { return vertex_t[n]; }
+private:
+    std::vector<Edge> edges;               ///< the edges of all faces, in face order
+    std::vector<unsigned int> face_begin;  ///< first edge of each face, and edges.size() at the end
+    std::vector<double> face_lo;           ///< smallest clearance of each face
+    std::vector<double> face_hi;           ///< largest clearance of each face
+    std::vector<double> vertex_t;          ///< clearance of each vertex
+    std::vector<unsigned int> edge_number; ///< number of each edge of the graph, by EdgeProps::index
+    unsigned long _generation;             ///< HEGraph::generation() when the cache was built
+    bool _built;                           ///< build() has been called
+};
+
+} // end ovd namespace
+// end file clearance_cache.hpp
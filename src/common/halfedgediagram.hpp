@@ -21,6 +21,7 @@
 
 #include <vector>
 #include <list>
+#include <cstddef>
 
 #include <boost/graph/adjacency_list.hpp>
 #include <boost/foreach.hpp> 
@@ -161,8 +162,9 @@ public:
     std::vector< TFaceProperties > faces; // this could maybe be held as a GraphProperty of the BGL-graph?
     /// underlying BGL graph
     BGLGraph g;
-    
-// NOTE: there is no HEDIGraph constructor, we use the default one..
+
+/// ctor
+half_edge_diagram() : _generation(0) {}
 
 /// dtor
 virtual ~half_edge_diagram(){
@@ -183,9 +185,9 @@ virtual ~half_edge_diagram(){
 /// return an invalid face_descriptor
 Face HFace() { return std::numeric_limits<Face>::quiet_NaN(); }
 /// add a blank vertex and return its descriptor
-Vertex add_vertex() { return boost::add_vertex( g ); }
+Vertex add_vertex() { _generation++; return boost::add_vertex( g ); }
 /// add a vertex with given properties, return vertex descriptor
-Vertex add_vertex(const TVertexProperties& prop) { return boost::add_vertex( prop, g ); }
+Vertex add_vertex(const TVertexProperties& prop) { _generation++; return boost::add_vertex( prop, g ); }
 /// return the target vertex of the given edge
 Vertex target(const Edge e ) const { return boost::target( e, g ); }
 /// return the source vertex of the given edge
@@ -198,24 +200,79 @@ unsigned int num_faces() const { return faces.size(); }
 unsigned int num_vertices() const { return boost::num_vertices( g ); }
 /// return number of edges in graph
 unsigned int num_edges() const { return boost::num_edges( g ); }
+/// \brief the edge with index \a i
+///
+/// every edge has an index, TEdgeProperties::index, in [0,num_edges()). the graph gives a new edge the next index,
+/// and when an edge is removed, the edge with the last index takes its index. so per-edge data can be kept
+/// in arrays indexed by g[e].index, as long as no edge is removed.
+Edge indexed_edge(unsigned int i) const { return indexed_edges[i]; }
 /// return number of edges on Face f
 unsigned int num_edges(Face f) { return face_edges(f).size(); }
+/// \brief number of changes to the graph.
+///
+/// incremented whenever a vertex, edge or face is added or removed, or by mark_changed(),
+/// so that data derived from the graph (e.g. an index) can tell if it is out of date.
+unsigned long generation() const { return _generation; }
+/// record a change to the properties of the graph, e.g. valid-flags set by a filter
+void mark_changed() { _generation++; }
+
+// memory accounting.
+// byte counts are computed from the number of stored elements and the size of the records
+// that BGL stores for them. Elements of node-based containers (listS) are counted with two
+// extra link-pointers, heap-allocator overhead is not included.
+
+/// bytes used by vertex records (including vertex properties)
+std::size_t vertex_bytes() const {
+    std::size_t rec = sizeof(typename BGLGraph::stored_vertex);
+    if ( !boost::detail::is_random_access<TVertexList>::value )
+        rec += node_bytes<TVertexList>( sizeof(void*) ); // listS vertices are allocated separately, and listed by pointer
+    return num_vertices()*rec;
+}
+/// bytes used by half-edge records (including edge properties)
+std::size_t half_edge_bytes() const {
+    return num_edges()*node_bytes<TEdgeList>( 2*sizeof(Vertex) + sizeof(TEdgeProperties) ) + indexed_edges.capacity()*sizeof(Edge);
+}
+/// bytes used by the per-vertex out-edge lists (and in-edge lists for a bidirectional graph)
+std::size_t adjacency_bytes() const {
+    std::size_t lists = TDirected::is_bidir_t::value ? 2 : 1;
+    // a stored edge is the target vertex and an iterator into the edge-list
+    return lists*num_edges()*node_bytes<TOutEdgeList>( sizeof(Vertex) + sizeof(void*) );
+}
+/// bytes used by face records
+std::size_t face_bytes() const { return faces.capacity()*sizeof(TFaceProperties); }
+/// bytes used per element of a container with the given BGL selector, for elements of \a value_bytes bytes
+template <class Selector>
+static std::size_t node_bytes(std::size_t value_bytes) {
+    if ( boost::detail::is_random_access<Selector>::value )
+        return value_bytes;
+    return value_bytes + 2*sizeof(void*);
+}
+
 /// add an edge between vertices v1-v2
-Edge add_edge(Vertex v1, Vertex v2) { return boost::add_edge( v1, v2, g).first; }
+Edge add_edge(Vertex v1, Vertex v2) { _generation++; return index_edge( boost::add_edge( v1, v2, g).first ); }
 /// add an edge with given properties between vertices v1-v2
-Edge add_edge( Vertex v1, Vertex  v2, const TEdgeProperties& prop ) { return boost::add_edge( v1, v2, prop, g).first; }
+Edge add_edge( Vertex v1, Vertex  v2, const TEdgeProperties& prop ) { _generation++; return index_edge( boost::add_edge( v1, v2, prop, g).first ); }
 /// return begin/edge iterators for out-edges of Vertex \a v
-std::pair<OutEdgeItr, OutEdgeItr> out_edge_itr( Vertex v ) { return boost::out_edges( v, g ); } // FIXME: change name to out_edges!!
+std::pair<OutEdgeItr, OutEdgeItr> out_edge_itr( Vertex v ) const { return boost::out_edges( v, g ); } // FIXME: change name to out_edges!!
 /// return true if v1-v2 edge exists
 inline bool has_edge( Vertex v1, Vertex v2) { return boost::edge( v1, v2, g ).second; }
 /// return v1-v2 Edge
 Edge edge( Vertex v1, Vertex v2) { assert(has_edge(v1,v2)); return boost::edge( v1, v2, g ).first; }
 /// clear given vertex. this removes all edges connecting to the vertex.
-void clear_vertex( Vertex v ) { boost::clear_vertex( v, g ); }
+void clear_vertex( Vertex v ) {
+    _generation++;
+    OutEdgeItr it, it_end;
+    for ( boost::tie(it, it_end) = boost::out_edges(v, g); it != it_end; ++it )
+        unindex_edge(*it);
+    typename boost::graph_traits< BGLGraph >::in_edge_iterator in, in_end;
+    for ( boost::tie(in, in_end) = boost::in_edges(v, g); in != in_end; ++in )
+        unindex_edge(*in);
+    boost::clear_vertex( v, g );
+}
 /// remove given vertex. call clear_vertex() before this!
-void remove_vertex( Vertex v ) { boost::remove_vertex( v , g ); }
+void remove_vertex( Vertex v ) { _generation++; boost::remove_vertex( v , g ); }
 /// remove given edge
-void remove_edge( Edge e ) { boost::remove_edge( e , g ); }
+void remove_edge( Edge e ) { _generation++; unindex_edge(e); boost::remove_edge( e , g ); }
 /// delete a vertex. clear and remove.
 void delete_vertex(Vertex v) { clear_vertex(v); remove_vertex(v); }
 
@@ -250,14 +307,14 @@ void add_vertex_in_edge( Vertex v, Edge e) {
     assert( g[previous].face == g[e].face );
     assert( g[twin_previous].face == g[e_twin].face );
     
-    Edge e1 = boost::add_edge( esource, v, g).first;
-    Edge te2 = boost::add_edge( v, esource,  g).first;
+    Edge e1 = add_edge( esource, v );
+    Edge te2 = add_edge( v, esource );
     g[e1].twin = te2; g[te2].twin = e1;
     //boost::tie(e1,te2) = add_twin_edges( esource, v ); 
     //Edge e2, te1;
     //boost::tie(e2,te1) = add_twin_edges( v, etarget );    
-    Edge e2 = boost::add_edge( v, etarget, g).first;
-    Edge te1 = boost::add_edge( etarget, v,  g).first;
+    Edge e2 = add_edge( v, etarget );
+    Edge te1 = add_edge( etarget, v );
     g[e2].twin = te1; g[te1].twin = e2;
 
 
@@ -274,8 +331,8 @@ void add_vertex_in_edge( Vertex v, Edge e) {
     faces[twin_face].edge = te1;
     // finally, remove the old edge
     //remove_twin_edges(esource, etarget);
-    boost::remove_edge( e , g );
-    boost::remove_edge( e_twin , g );
+    remove_edge( e );
+    remove_edge( e_twin );
 }
 /// ad two edges, one from \a v1 to \a v2 and one from \a v2 to \a v1
 std::pair<Edge,Edge> add_twin_edges(Vertex v1, Vertex v2) {
@@ -283,8 +340,8 @@ std::pair<Edge,Edge> add_twin_edges(Vertex v1, Vertex v2) {
     //bool b;
     //boost::tie( e1 , b ) = boost::add_edge( v1, v2, g);
     //boost::tie( e2 , b ) = boost::add_edge( v2, v1, g);
-    Edge e1 = boost::add_edge( v1, v2, g).first;
-    Edge e2 = boost::add_edge( v2, v1, g).first;
+    Edge e1 = add_edge( v1, v2 );
+    Edge e2 = add_edge( v2, v1 );
     //twin_edges(e1,e2);
     g[e1].twin = e2;
     g[e2].twin = e1;
@@ -307,6 +364,7 @@ void twin_edges( Edge e1, Edge e2 ) {
 
 /// add a face 
 Face add_face() {
+    _generation++;
     TFaceProperties f_prop;
     faces.push_back( f_prop); 
     Face index = faces.size()-1;
@@ -316,6 +374,7 @@ Face add_face() {
 
 /// add a face, with given properties
 Face add_face(const TFaceProperties& prop) {
+    _generation++;
     faces.push_back( prop ); 
     Face index = faces.size()-1;
     faces[index].idx = index;
@@ -415,6 +474,23 @@ EdgeVector edges() const {
     return ev;
 }
 
+/// \brief number the vertices in the order of vertices(), and set \a source[ g[e].index ] to the number
+/// of the source of each edge \a e
+///
+/// the target of e is the source of g[e].next.
+/// \return the number of vertices
+unsigned int source_numbers(std::vector<unsigned int>& source) const {
+    source.resize( num_edges() );
+    unsigned int n = 0;
+    VertexItr v, v_end;
+    for ( boost::tie(v, v_end) = boost::vertices(g); v != v_end; ++v, ++n ) {
+        OutEdgeItr it, it_end;
+        for ( boost::tie(it, it_end) = boost::out_edges(*v, g); it != it_end; ++it )
+            source[ g[*it].index ] = n;
+    }
+    return n;
+}
+
 /// return the previous edge. traverses all edges in face until previous found.
 Edge previous_edge( Edge e ) const {
     Edge previous = g[e].next;
@@ -495,8 +571,8 @@ void insert_vertex_in_edge(Vertex v, Edge e ) {
     faces[twin_face].edge = te1;
     
     // finally, remove the old edge
-    boost::remove_edge( e   , g);
-    boost::remove_edge( twin, g);
+    remove_edge( e );
+    remove_edge( twin );
 }
 
 /// remove given v1-v2 edge
@@ -504,7 +580,7 @@ void remove_edge( Vertex v1, Vertex v2) {
     assert( has_edge(v1,v2) );
     typedef typename std::pair<Edge, bool> EdgeBool;
     EdgeBool result = boost::edge(v1, v2, g );    
-    boost::remove_edge( result.first , g );
+    remove_edge( result.first );
 }
 
 /// remove given v1-v2 edge and its twin
@@ -514,8 +590,8 @@ void remove_twin_edges( Vertex v1, Vertex v2) {
     typedef typename std::pair<Edge, bool> EdgeBool;
     EdgeBool result1 = boost::edge(v1, v2, g ); 
     EdgeBool result2 = boost::edge(v2, v1, g );    
-    boost::remove_edge( result1.first , g );
-    boost::remove_edge( result2.first , g );
+    remove_edge( result1.first );
+    remove_edge( result2.first );
 }
 
 /// remove a degree-two Vertex from the middle of an Edge
@@ -694,6 +770,24 @@ void print_vertices(VertexVector& q) {
     std::cout << std::endl;
 }
 
+private:
+    /// give the new edge \a e the next index
+    Edge index_edge(Edge e) {
+        g[e].index = indexed_edges.size();
+        indexed_edges.push_back(e);
+        return e;
+    }
+    /// free the index of \a e, which is about to be removed. the edge with the last index takes it.
+    void unindex_edge(Edge e) {
+        Edge last = indexed_edges.back();
+        g[last].index = g[e].index;
+        indexed_edges[ g[e].index ] = last;
+        indexed_edges.pop_back();
+    }
+    /// number of changes, see generation()
+    unsigned long _generation;
+    /// the edge with each index, see indexed_edge()
+    EdgeVector indexed_edges;
 }; // end HEDIGraph class definition
 
 
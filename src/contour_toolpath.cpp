@@ -0,0 +1,174 @@
+/*
+ *  Copyright (c) 2010-2012 Anders Wallin (anders.e.e.wallin "at" gmail.com).
+ *
+ *  This file is part of Openvoronoi
+ *  (see https://github.com/aewallin/openvoronoi).
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <algorithm>
+
+#include <boost/foreach.hpp>
+
+#include "contour_toolpath.hpp"
+
+namespace ovd
+{
+
+ContourToolpath::ContourToolpath(const OffsetSorter& s) : sorter(s) { }
+
+void ContourToolpath::run() {
+    const MachiningGraph& g = sorter.graph();
+    std::size_t n_loops = boost::num_vertices(g);
+    loops.assign( n_loops, Loop() );
+    outer.assign( n_loops, -1 );
+    entry.assign( n_loops, -1 );
+    cuts.clear();
+    // loop_order() is innermost first, so inner loops are listed before the loops outside them
+    BOOST_FOREACH( MGVertex n, sorter.loop_order() ) {
+        prepare(n);
+        boost::graph_traits<MachiningGraph>::out_edge_iterator it, it_end;
+        boost::tie(it, it_end) = boost::out_edges(n, g);
+        if ( it != it_end ) {
+            outer[n] = boost::target(*it, g);
+            loops[ outer[n] ].inner.push_back(n);
+        }
+    }
+    BOOST_FOREACH( MGVertex n, sorter.loop_order() ) {
+        if ( outer[n] == -1 )
+            cut(n, false);
+    }
+}
+
+/// copy loop \a n, and index its vertices by the faces before and after them
+void ContourToolpath::prepare(MGVertex n) {
+    const OffsetLoop& loop = sorter.graph()[n];
+    Loop& l = loops[n];
+    l.v.assign( loop.vertices.begin(), loop.vertices.end() );
+    unsigned int size = l.v.size()-1; // number of offset-elements. v[size] is at the start point v[0]
+    l.length.resize( l.v.size() );
+    l.length[0] = 0;
+    for (unsigned int k=1;k<l.v.size();k++) {
+        l.length[k] = l.length[k-1] + l.v[k].length( l.v[k-1].p );
+        // vertex k is the end of element k, on face v[k].f, and the start of the next element
+        HEFace next = l.v[ k%size + 1 ].f;
+        l.keys.push_back( VertexKey( std::make_pair( l.v[k].f, next ), k ) );
+    }
+    std::sort( l.keys.begin(), l.keys.end() );
+}
+
+/// \brief cut loop \a n, after the loops inside it
+///
+/// with \a link, continue along the loop and link to the loop outside it.
+/// otherwise the current ContourPath ends with this loop.
+void ContourToolpath::cut(MGVertex n, bool link) {
+    Loop& l = loops[n];
+    for (unsigned int i=0;i<l.inner.size();i++)
+        cut( l.inner[i], i+1 == l.inner.size() );
+    unsigned int size = l.v.size()-1;
+    std::pair<unsigned int, unsigned int> exit(size, 0);
+    if (link)
+        exit = find_link( l, loops[ outer[n] ], entry[n] );
+    if ( entry[n] == -1 ) { // start a new path, where it is closest to the loop outside
+        entry[n] = exit.first;
+        cuts.push_back( ContourPath() );
+        cuts.back().moves.push_back( OffsetVertex( l.v[ entry[n] ].p ) );
+    }
+    cuts.back().loops.push_back(n);
+    move_along( l, entry[n], entry[n]+size ); // the whole loop
+    if (link) {
+        move_along( l, entry[n], exit.first );
+        const Loop& out = loops[ outer[n] ];
+        cuts.back().moves.push_back( OffsetVertex( out.v[exit.second].p ) );
+        entry[ outer[n] ] = exit.second;
+    }
+}
+
+/// \brief add the moves along \a loop, from vertex \a from to vertex \a to
+///
+/// \a to may be larger than the number of elements, to move past the start point
+void ContourToolpath::move_along(const Loop& loop, unsigned int from, unsigned int to) {
+    unsigned int size = loop.v.size()-1;
+    if ( to < from )
+        to += size;
+    for (unsigned int k=from+1; k<=to; k++) {
+        unsigned int i = (k-1)%size + 1;
+        OffsetVertex v = loop.v[i];
+        if ( i == size ) // the last element ends at the start point
+            v.p = loop.v[0].p;
+        cuts.back().moves.push_back(v);
+    }
+}
+
+/// length along \a loop from vertex \a from to vertex \a to
+double ContourToolpath::along(const Loop& loop, unsigned int from, unsigned int to) const {
+    double d = loop.length[to] - loop.length[from];
+    if ( d < 0 )
+        d += loop.length.back();
+    return d;
+}
+
+/// \brief the vertices where loop \a in links to loop \a out
+///
+/// vertices on the same vd-edge are linked. when the tool arrives at vertex \a entry (if not -1),
+/// the link with the shortest move along \a in plus link-line is chosen, otherwise the shortest link-line.
+/// if the loops share no vd-edge, \a in is linked from \a entry (or its start point) to the closest vertex of \a out.
+std::pair<unsigned int, unsigned int> ContourToolpath::find_link(const Loop& in, const Loop& out, int entry) const {
+    std::pair<unsigned int, unsigned int> best(0,0);
+    double best_cost = -1;
+    std::vector<VertexKey>::const_iterator o = out.keys.begin();
+    BOOST_FOREACH( const VertexKey& key, in.keys ) { // both key-lists are sorted, so they are merged
+        while ( o != out.keys.end() && o->first < key.first )
+            ++o;
+        for ( std::vector<VertexKey>::const_iterator m = o; m != out.keys.end() && m->first == key.first; ++m ) {
+            double cost = ( in.v[key.second].p - out.v[m->second].p ).norm();
+            if ( entry != -1 )
+                cost += along( in, entry, key.second );
+            if ( best_cost < 0 || cost < best_cost ) {
+                best = std::make_pair( key.second, m->second );
+                best_cost = cost;
+            }
+        }
+    }
+    if ( best_cost < 0 ) {
+        best.first = ( entry != -1 ) ? entry : in.v.size()-1;
+        for (unsigned int k=1;k<out.v.size();k++) {
+            double d = ( in.v[best.first].p - out.v[k].p ).norm();
+            if ( best_cost < 0 || d < best_cost ) {
+                best.second = k;
+                best_cost = d;
+            }
+        }
+    }
+    return best;
+}
+
+double ContourToolpath::cut_length() const {
+    double length = 0;
+    BOOST_FOREACH( const ContourPath& path, cuts ) {
+        for (unsigned int k=1;k<path.moves.size();k++)
+            length += path.moves[k].length( path.moves[k-1].p );
+    }
+    return length;
+}
+
+double ContourToolpath::rapid_length() const {
+    double length = 0;
+    for (unsigned int n=1;n<cuts.size();n++)
+        length += ( cuts[n].moves.front().p - cuts[n-1].moves.back().p ).norm();
+    return length;
+}
+
+} // end ovd namespace
+// end file contour_toolpath.cpp
@@ -0,0 +1,86 @@
+/*
+ *  Copyright (c) 2010-2012 Anders Wallin (anders.e.e.wallin "at" gmail.com).
+ *
+ *  This file is part of Openvoronoi
+ *  (see https://github.com/aewallin/openvoronoi).
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <vector>
+#include <utility>
+
+#include "offset.hpp"
+#include "offset_sorter.hpp"
+
+namespace ovd
+{
+
+/// \brief one continuous cut of a contour-parallel toolpath
+struct ContourPath {
+    /// the start point, followed by lines and arcs, in the format of OffsetLoop::vertices
+    std::vector<OffsetVertex> moves;
+    std::vector<MGVertex> loops; ///< the offset loops cut by this path, in order
+};
+
+/// \brief links the nested offset-loops of an OffsetSorter into a contour-parallel toolpath
+///
+/// loops are cut from the inside out. a loop is cut after all loops inside it,
+/// starting and ending where the tool arrived on the loop. the tool then moves along the loop,
+/// and links to the loop just outside it with a line between two loop-vertices on the same vd-edge.
+/// such vertex-pairs are found where both loops pass between the same two faces.
+/// the exit-vertex is chosen to minimize the move along the loop plus the link.
+///
+/// a loop with several loops inside it is linked from the last of them, and each of the others
+/// ends a ContourPath. the tool makes a rapid move between paths.
+/// a loop with several loops outside it (in a region bounded by islands) is linked to the first of them.
+class ContourToolpath {
+public:
+    /// \param s sorter, after OffsetSorter::sort_loops()
+    ContourToolpath(const OffsetSorter& s);
+    /// build the toolpath
+    void run();
+    /// the continuous cuts, in machining order
+    const std::vector<ContourPath>& paths() const { return cuts; }
+    /// total length of cutting moves: loops, moves along loops, and links
+    double cut_length() const;
+    /// total length of rapid moves between paths
+    double rapid_length() const;
+private:
+    ContourToolpath(); // don't use.
+    /// (face before, face after) of a loop-vertex, and its index in the loop
+    typedef std::pair< std::pair<HEFace,HEFace>, unsigned int > VertexKey;
+    /// \brief an offset loop prepared for linking
+    struct Loop {
+        std::vector<OffsetVertex> v;   ///< the loop-vertices, v[0] is the start point
+        std::vector<double> length;    ///< length[k] is the length along the loop to v[k]
+        std::vector<VertexKey> keys;   ///< the faces of each vertex, sorted
+        std::vector<MGVertex> inner;   ///< loops linked to this loop, from the inside
+    };
+    void prepare(MGVertex n);
+    void cut(MGVertex n, bool link);
+    void move_along(const Loop& loop, unsigned int from, unsigned int to);
+    double along(const Loop& loop, unsigned int from, unsigned int to) const;
+    std::pair<unsigned int, unsigned int> find_link(const Loop& in, const Loop& out, int entry) const;
+
+    const OffsetSorter& sorter; ///< the sorted loops
+    std::vector<Loop> loops;    ///< each loop of the MachiningGraph
+    std::vector<int> outer;     ///< the loop outside each loop, or -1
+    std::vector<int> entry;     ///< the vertex where the tool arrives on each loop, or -1
+    std::vector<ContourPath> cuts; ///< output
+};
+
+} // end ovd namespace
+// end file contour_toolpath.hpp
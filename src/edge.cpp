@@ -21,6 +21,10 @@
 #include "edge.hpp"
 #include "common/numeric.hpp"
 
+#ifdef OVD_EDGE_AVX2
+#include <immintrin.h>
+#endif
+
 using namespace ovd::numeric;
 
 namespace ovd {
@@ -31,6 +35,7 @@ EdgeProps::EdgeProps() {
     y[0]=0;y[1]=0;y[2]=0;y[3]=0;y[4]=0;y[5]=0;y[6]=0;y[7]=0;
     has_null_face = false;
     valid=true;
+    index=0;
 }
 
 #define stringify( name ) # name
@@ -45,7 +50,8 @@ const char* edgeTypeNames[] = {
   stringify( HYPERBOLA ),
   stringify( SEPARATOR ),
   stringify( NULLEDGE ),
-  stringify( LINESITE )
+  stringify( LINESITE ),
+  stringify( ARCSITE )
 };
 
 /// return type of edge as string
@@ -113,6 +119,72 @@ Point EdgeProps::point(double t) const {
     }
 }
 
+/// \brief the points at the \a n offset-distances \a t, in \a out
+///
+/// gives the same points as point(), for many t at once. the discriminants are clamped to zero
+/// with a select instead of branches, and with OVD_AVX2 four points are evaluated at a time
+/// when the cpu supports AVX2. a point that comes out as NaN is evaluated again with point(),
+/// which reports the error, so the error path is outside the loop.
+void EdgeProps::points(const double* t, std::size_t n, Point* out) const {
+    std::size_t k = 0;
+#ifdef OVD_EDGE_AVX2
+    if ( __builtin_cpu_supports("avx2") )
+        k = points_avx2(t, n, out);
+#endif
+    double psig = sign ? +1 : -1;
+    double nsig = sign ? -1 : +1;
+    for ( ; k<n; k++) {
+        double discr1 = sq(x[4]+x[5]*t[k]) - sq(x[6]+x[7]*t[k]);
+        double discr2 = sq(y[4]+y[5]*t[k]) - sq(y[6]+y[7]*t[k]);
+        discr1 = (discr1 < 1e-14) ? 0 : discr1; // as chop() followed by the clamp in point()
+        discr2 = (discr2 < 1e-14) ? 0 : discr2;
+        out[k].x = x[0] - x[1] - x[2]*t[k] + psig * x[3] * sqrt( discr1 );
+        out[k].y = y[0] - y[1] - y[2]*t[k] + nsig * y[3] * sqrt( discr2 );
+    }
+    for (k=0;k<n;k++) {
+        if ( out[k].x != out[k].x || out[k].y != out[k].y ) // NaN
+            out[k] = point(t[k]);
+    }
+}
+
+#ifdef OVD_EDGE_AVX2
+/// \brief points() for the first n - n%4 offset-distances, with AVX2
+/// \return the number of points evaluated
+__attribute__((target("avx2")))
+std::size_t EdgeProps::points_avx2(const double* t, std::size_t n, Point* out) const {
+    const __m256d eps = _mm256_set1_pd(1e-14);
+    const __m256d x0 = _mm256_set1_pd(x[0]-x[1]), y0 = _mm256_set1_pd(y[0]-y[1]);
+    const __m256d x2 = _mm256_set1_pd(x[2]), y2 = _mm256_set1_pd(y[2]);
+    const __m256d x3 = _mm256_set1_pd( (sign ? +1 : -1) * x[3] );
+    const __m256d y3 = _mm256_set1_pd( (sign ? -1 : +1) * y[3] );
+    const __m256d x4 = _mm256_set1_pd(x[4]), x5 = _mm256_set1_pd(x[5]), x6 = _mm256_set1_pd(x[6]), x7 = _mm256_set1_pd(x[7]);
+    const __m256d y4 = _mm256_set1_pd(y[4]), y5 = _mm256_set1_pd(y[5]), y6 = _mm256_set1_pd(y[6]), y7 = _mm256_set1_pd(y[7]);
+    std::size_t k = 0;
+    for ( ; k+4<=n; k+=4) {
+        __m256d tk = _mm256_loadu_pd(t+k);
+        __m256d a = _mm256_add_pd( x4, _mm256_mul_pd(x5,tk) );
+        __m256d b = _mm256_add_pd( x6, _mm256_mul_pd(x7,tk) );
+        __m256d discr1 = _mm256_sub_pd( _mm256_mul_pd(a,a), _mm256_mul_pd(b,b) );
+        a = _mm256_add_pd( y4, _mm256_mul_pd(y5,tk) );
+        b = _mm256_add_pd( y6, _mm256_mul_pd(y7,tk) );
+        __m256d discr2 = _mm256_sub_pd( _mm256_mul_pd(a,a), _mm256_mul_pd(b,b) );
+        // zero where discr < 1e-14. NaN compares false, and is kept, as in the scalar loop
+        discr1 = _mm256_andnot_pd( _mm256_cmp_pd(discr1, eps, _CMP_LT_OQ), discr1 );
+        discr2 = _mm256_andnot_pd( _mm256_cmp_pd(discr2, eps, _CMP_LT_OQ), discr2 );
+        __m256d xc = _mm256_add_pd( _mm256_sub_pd( x0, _mm256_mul_pd(x2,tk) ), _mm256_mul_pd( x3, _mm256_sqrt_pd(discr1) ) );
+        __m256d yc = _mm256_add_pd( _mm256_sub_pd( y0, _mm256_mul_pd(y2,tk) ), _mm256_mul_pd( y3, _mm256_sqrt_pd(discr2) ) );
+        double xs[4], ys[4];
+        _mm256_storeu_pd(xs, xc);
+        _mm256_storeu_pd(ys, yc);
+        for (int i=0;i<4;i++) {
+            out[k+i].x = xs[i];
+            out[k+i].y = ys[i];
+        }
+    }
+    return k;
+}
+#endif
+
 /// dispatch to setter functions based on type of \a s1 and \a s2
 void EdgeProps::set_parameters(Site* s1, Site* s2, bool sig) {
     sign = sig; // sqrt() sign for edge-parametrization
@@ -133,11 +205,13 @@ void EdgeProps::set_parameters(Site* s1, Site* s2, bool sig) {
         
     } else if (s1->isLine() && s2->isArc() ) // LA
         set_la_parameters(s1,s2);
-    else if (s2->isLine() && s1->isArc() ) // AL
+    else if (s2->isLine() && s1->isArc() ) { // AL
         set_la_parameters(s2,s1);
+        sign = !sign;
+    } else if (s1->isArc() && s2->isArc() ) // AA
+        set_aa_parameters(s1,s2);
     else
         assert(0);
-        // AA
 }
 
 /// assignment of edge-parameters
@@ -167,7 +241,7 @@ EdgeProps& EdgeProps::operator=(const EdgeProps &other) {
     k=other.k; 
     type = other.type;
     valid = other.valid;
-    // NOTE we do *not* set: twin, next    
+    // NOTE we do *not* set: twin, next, index
     return *this;
 }
 
@@ -344,7 +418,7 @@ void EdgeProps::set_pa_parameters(Site* s1, Site* s2) {
     assert( s1->isPoint() && s2->isArc() );
     //std::cout << "set_pa_parameters()\n";
     
-    type = HYPERBOLA; // hyperbola or ellipse?
+    type = HYPERBOLA; // or ELLIPSE, see below
     double lamb2(1.0);
     //if (s2->cw())
     //    lamb2 = +1.0;
@@ -354,9 +428,10 @@ void EdgeProps::set_pa_parameters(Site* s1, Site* s2) {
     // distance between centers
     double d = sqrt( (s1->x() - s2->x())*(s1->x() - s2->x()) + (s1->y()-s2->y())*(s1->y()-s2->y()) );
     assert( d > 0 );
-    if (d<=s2->r()) {
+    if (d<=s2->r()) { // point inside the circle, the edge is on the inside of the arc
         lamb2=-1.0;
         sign=!sign;
+        type = ELLIPSE;
     }
         
     //if (s2->cw()) {
@@ -390,27 +465,22 @@ void EdgeProps::set_pa_parameters(Site* s1, Site* s2) {
 }
 
 
-/// set edge parameters when s1 is ArcSite and s2 is LineSite
+/// \brief set ::PARABOLA edge parameters between LineSite \a s1 and ArcSite \a s2
+///
+/// the offset of the LineSite is towards its face, -(a1 x + b1 y + c1) = t,
+/// and the offset of the ArcSite is to the side given by its k(), |p-c2| = r2 + k2*t.
+/// with p = c2 + w the component of w along the line-normal is -(alfa3+t) 
+/// with alfa3 = a1*x2 + b1*y2 + c1 the signed distance from the line to the center,
+/// and the perpendicular component is +/- sqrt( (r2+k2*t)^2 - (alfa3+t)^2 ).
 void EdgeProps::set_la_parameters(Site* s1, Site* s2) { 
     assert( s1->isLine() && s2->isArc() );
-    std::cout << "set_la_parameters() sign= " << sign << " cw= " << s2->cw() << "\n";
     type = PARABOLA;
-    double lamb2;
-    if (s2->cw())
-        lamb2 = +1.0;
-    else
-        lamb2 = -1.0;
+    double lamb2 = s2->k(); // +1 outside, -1 inside the arc
     double alfa1 = s1->a(); //a2
     double alfa2 = s1->b(); //b2
     double alfa3 = ( s1->a()*s2->x() + s1->b()*s2->y() + s1->c() );
     double alfa4 = s2->r();
-    double kk = +1; // # positive line-offset
-    //if (alfa3 > 0) {
-    //    kk = -1;
-    //    assert(0);
-    //}
-    //sign = false;
-    // figure out sign?
+    double kk = +1; // positive line-offset
     
     x[0] = s2->x();
     x[1] = alfa1*alfa3;
@@ -429,9 +499,46 @@ void EdgeProps::set_la_parameters(Site* s1, Site* s2) {
     y[5] = lamb2;
     y[6] = alfa3;
     y[7] = kk;
-    print_params();
 }
 
+/// \brief set edge parameters between ArcSite \a s1 and ArcSite \a s2
+///
+/// this is the general circle-circle bisector, |p-c1| = r1 + k1*t and |p-c2| = r2 + k2*t,
+/// of which set_pa_parameters() is the special case r1=0, k1=1.
+/// with u=(alfa1,alfa2) the unit vector from c1 to c2 and d the distance between the centers,
+/// the component of p-c1 along u is -(alfa3+alfa4*t) with
+/// alfa3 = (r2^2-r1^2-d^2)/(2d) and alfa4 = (k2*r2-k1*r1)/d.
+/// The edge is a ::HYPERBOLA when |alfa4|<1 and an ::ELLIPSE otherwise.
+void EdgeProps::set_aa_parameters(Site* s1, Site* s2) {
+    assert( s1->isArc() && s2->isArc() );
+    double lamb1 = s1->k();
+    double lamb2 = s2->k();
+    double d = sqrt( sq(s2->x() - s1->x()) + sq(s2->y() - s1->y()) );
+    assert( d > 0 ); // concentric arcs are not supported
+    double alfa1 = ( s2->x() - s1->x() ) / d;
+    double alfa2 = ( s2->y() - s1->y() ) / d;
+    double alfa3 = ( sq(s2->r()) - sq(s1->r()) - d*d ) / (2*d);
+    double alfa4 = ( lamb2*s2->r() - lamb1*s1->r() ) / d;
+    type = ( fabs(alfa4) < 1 ) ? HYPERBOLA : ELLIPSE;
+    
+    x[0] = s1->x();
+    x[1] = alfa1*alfa3;
+    x[2] = alfa1*alfa4;
+    x[3] = alfa2;
+    x[4] = s1->r();
+    x[5] = lamb1;
+    x[6] = alfa3;
+    x[7] = alfa4;
+    
+    y[0] = s1->y();
+    y[1] = alfa2*alfa3;
+    y[2] = alfa2*alfa4;
+    y[3] = alfa1;
+    y[4] = s1->r();
+    y[5] = lamb1;
+    y[6] = alfa3;
+    y[7] = alfa4;
+}
 
 /// \return minimum t-value for this edge
 /// this function dispatches to a helper-function based on the Site:s \a s1 and \a s2
@@ -449,9 +556,14 @@ double EdgeProps::minimum_t( Site* s1, Site* s2) {
         return minimum_pa_t(s1,s2);
     else if (s2->isPoint() && s1->isArc() ) // AP
         return minimum_pa_t(s2,s1);
+    else if (s1->isLine() && s2->isArc() ) // LA
+        return minimum_la_t(s1,s2);
+    else if (s2->isLine() && s1->isArc() ) // AL
+        return minimum_la_t(s2,s1);
+    else if (s1->isArc() && s2->isArc() ) // AA
+        return minimum_aa_t(s1,s2);
     else
         assert(0);
-    // todo:  AP, AL, AA
     return -1;
 }
 /// minimum t-value for LINE edge between PointSite and PointSite
@@ -470,9 +582,47 @@ double EdgeProps::minimum_pl_t(Site* , Site* ) {
 /// minimum t-value for edge between PointSite and ArcSite
 double EdgeProps::minimum_pa_t(Site* s1, Site* s2) {
     assert( s1->isPoint() && s2->isArc() );
-    double p1p2 = (s1->position() - s2->apex_point(s1->position()) ).norm(); // - s2->r() ;
-    assert( p1p2 >=0 );
-    return p1p2/2; // this splits point-point edges at APEX
+    // distance from the point to the circle of the arc
+    double p1p2 = fabs( (s1->position() - Point(s2->x(),s2->y()) ).norm() - s2->r() );
+    return p1p2/2; // this splits point-arc edges at APEX
+}
+/// minimum t-value for the edge between LineSite and ArcSite
+double EdgeProps::minimum_la_t(Site* , Site* ) {
+    double roots[2];
+    int n = apex_roots(roots);
+    assert( n>0 );
+    double mint = (n==2) ? std::max(roots[0],roots[1]) : roots[0]; // a PARABOLA exists above its apex
+    return std::max(mint,0.0);
+}
+/// minimum t-value for the edge between ArcSite and ArcSite
+double EdgeProps::minimum_aa_t(Site* , Site* ) {
+    double roots[2];
+    int n = apex_roots(roots);
+    assert( n>0 );
+    double mint = roots[0];
+    if (n==2) // a HYPERBOLA exists for t above the larger root, an ELLIPSE between the roots.
+        mint = (type==HYPERBOLA) ? std::max(roots[0],roots[1]) : std::min(roots[0],roots[1]);
+    return std::max(mint,0.0);
+}
+/// \return maximum t-value of an ::ELLIPSE edge
+/// \details an ellipse has two apex-points, one at its minimum and one at its maximum t-value
+double EdgeProps::maximum_t() const {
+    assert( type == ELLIPSE );
+    double roots[2];
+    int n = apex_roots(roots);
+    assert( n==2 );
+    return std::max(roots[0],roots[1]);
+}
+/// \brief t-values at the apex-points, where the square-root in the parametrization vanishes,
+/// i.e. where (x4+x5*t)^2 = (x6+x7*t)^2.
+/// \return number of roots written to \a roots
+int EdgeProps::apex_roots(double roots[2]) const {
+    int n=0;
+    if ( x[5] != x[7] ) // x4+x5*t =   x6+x7*t
+        roots[n++] = (x[6]-x[4])/(x[5]-x[7]);
+    if ( x[5] != -x[7] ) // x4+x5*t = -(x6+x7*t)
+        roots[n++] = -(x[6]+x[4])/(x[5]+x[7]);
+    return n;
 }
 /// print out edge parametrization
 void EdgeProps::print_params() const {
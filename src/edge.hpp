@@ -22,6 +22,7 @@
 
 #include <cassert>
 #include <cmath>
+#include <cstddef>
 #include <boost/array.hpp>
 
 #include <boost/graph/adjacency_list.hpp>
@@ -30,6 +31,11 @@
 #include "site.hpp"
 #include "solvers/solution.hpp"
 
+// EdgeProps::points() has an AVX2 kernel, chosen at run-time, with gcc or clang on x86 (cmake option OVD_AVX2)
+#if defined(OVD_AVX2) && defined(__GNUC__) && ( defined(__x86_64__) || defined(__i386__) )
+#define OVD_EDGE_AVX2
+#endif
+
 namespace ovd {
 
 #define OUT_EDGE_CONTAINER boost::listS 
@@ -51,12 +57,12 @@ enum EdgeType {
     PARA_LINELINE, /*!< Line edge between LineSite and LineSite (parallel case) */ 
     OUTEDGE,       /*!< special outer edge set by initialize() */ 
     PARABOLA,      /*!< Parabolic edge between PointSite and LineSite */ 
-    ELLIPSE, 
-    HYPERBOLA, 
+    ELLIPSE,       /*!< Elliptic edge between ArcSite and PointSite or ArcSite */ 
+    HYPERBOLA,     /*!< Hyperbolic edge between ArcSite and PointSite or ArcSite */ 
     SEPARATOR,     /*!< Separator edge between PointSite (endpoint) and LineSite or ArcSite */ 
     NULLEDGE,      /*!< zero-length null-edge around a PointSite which is and endpoint */ 
     LINESITE,       /*!< pseudo-edge corresponding to a LineSite */ 
-    ARCSITE       /*!< pseudo-edge corresponding to a LineSite */ 
+    ARCSITE       /*!< pseudo-edge corresponding to a ArcSite */ 
     };
 /*
 * bisector formulas
@@ -77,9 +83,9 @@ class EdgeProps {
 public:
     EdgeProps();
     /// create edge with given next and face
-    EdgeProps(HEEdge n, HEFace f): next(n), face(f), has_null_face(false), valid(true) {}
+    EdgeProps(HEEdge n, HEFace f): next(n), face(f), has_null_face(false), valid(true), index(0) {}
     /// create edge with given next, twin, and face
-    EdgeProps(HEEdge n, HEEdge t, HEFace f): next(n), twin(t), face(f), has_null_face(false), valid(true) {}
+    EdgeProps(HEEdge n, HEEdge t, HEFace f): next(n), twin(t), face(f), has_null_face(false), valid(true), index(0) {}
     
     HEEdge next;     ///< the next edge, counterclockwise on the face, from this edge
     HEEdge twin; ///< the twin edge
@@ -95,18 +101,29 @@ public:
     bool sign; ///< flag to choose either +/- in front of sqrt()
 
     Point point(double t) const; 
+    void points(const double* t, std::size_t n, Point* out) const;
     double minimum_t( Site* s1, Site* s2);
+    double maximum_t() const;
        
     void set_parameters(Site* s1, Site* s2, bool sig);
     void set_sep_parameters(Point& endp, Point& p);
     EdgeProps &operator=(const EdgeProps &p);
     bool valid; ///< flag set by Filter, for use by downstream algorithms
     bool inserted_direction; ///< true if ::LINESITE-edge inserted in this direction
+    /// index of the edge, in [0,num_edges()), kept by the graph (see half_edge_diagram::indexed_edge()).
+    /// not copied by operator=
+    unsigned int index;
     std::string type_str() const;
 private:
     double minimum_pp_t(Site* s1, Site* s2);
     double minimum_pl_t(Site* s1, Site* s2);
     double minimum_pa_t(Site* s1, Site* s2);
+    double minimum_la_t(Site* s1, Site* s2);
+    double minimum_aa_t(Site* s1, Site* s2);
+    int apex_roots(double roots[2]) const;
+#ifdef OVD_EDGE_AVX2
+    std::size_t points_avx2(const double* t, std::size_t n, Point* out) const;
+#endif
 
     void set_pp_parameters(Site* s1, Site* s2);
     void set_pl_parameters(Site* s1, Site* s2);
@@ -114,6 +131,7 @@ private:
     void set_ll_para_parameters(Site* s1, Site* s2);
     void set_pa_parameters(Site* s1, Site* s2);
     void set_la_parameters(Site* s1, Site* s2);
+    void set_aa_parameters(Site* s1, Site* s2);
     void print_params() const;
 };
 
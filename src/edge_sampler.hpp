@@ -0,0 +1,150 @@
+/*
+ *  Copyright (c) 2010-2012 Anders Wallin (anders.e.e.wallin "at" gmail.com).
+ *
+ *  This file is part of Openvoronoi
+ *  (see https://github.com/aewallin/openvoronoi).
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <list>
+#include <cmath>
+#include <algorithm>
+#include <limits>
+
+#include <boost/math/tools/minima.hpp> // brent_find_minima
+
+#include "graph.hpp"
+
+namespace ovd
+{
+
+/// \brief Medial-axis point and associated clearance-disc radius.
+struct MedialPoint {
+    Point p; ///< position
+    double clearance_radius; ///< clearance-disk radius
+    /// \param pi position
+    /// \param r radius
+    MedialPoint(Point pi, double r): p(pi), clearance_radius(r) {}
+};
+typedef std::list<MedialPoint> MedialPointList; ///< list of points on the medial-axis
+
+/// \brief polyline approximation of vd-edges, with a bounded error
+///
+/// an edge is sampled by subdivision: a part of the edge is split at its middle
+/// while some point of the part is further than the chord tolerance from the line between the ends of the part,
+/// or, with a radius tolerance, while the clearance at some point differs by more than the tolerance
+/// from the clearance interpolated along that line.
+/// so short or nearly straight edges get few points, and long strongly curved edges many.
+/// the largest error of a part is found with brent_find_minima(): the edges are conics, which bend one way only,
+/// so the distance of a part from its chord grows to a single maximum and falls again.
+/// (a ::LINE edge sampled with only a chord tolerance is straight, and is not split.)
+///
+/// curved edges (::PARABOLA, ::ELLIPSE, ::HYPERBOLA) and ::LINE edges are evaluated with EdgeProps::point().
+/// the parameter is u in [0,1], with the clearance t = t_min + (t_max-t_min)*u^2, as the point moves
+/// fastest near t_min, where a quadratic edge has its apex. other edges are drawn from vertex to vertex.
+class EdgeSampler {
+public:
+    /// \param chord_tolerance largest distance between the edge and the polyline
+    /// \param radius_tolerance largest error in the interpolated clearance-disk radius, or 0 to ignore the radius
+    EdgeSampler(double chord_tolerance, double radius_tolerance = 0)
+        : chord_tol(chord_tolerance), radius_tol(radius_tolerance), max_depth(24) {}
+
+    /// \brief add the points of edge \a e to \a out, from the source to the target of \a e
+    void sample(const HEGraph& g, HEEdge e, MedialPointList& out) const {
+        const VoronoiVertex& src = g[ g.source(e) ];
+        const VoronoiVertex& trg = g[ g.target(e) ];
+        if ( !evaluated( g[e].type ) ) {
+            out.push_back( MedialPoint( src.position, src.dist() ) );
+            out.push_back( MedialPoint( trg.position, trg.dist() ) );
+            return;
+        }
+        Part a( 0, g[e], src.dist(), trg.dist() );
+        Part b( 1, g[e], src.dist(), trg.dist() );
+        out.push_back( MedialPoint( a.p, a.t ) );
+        if ( g[e].type != LINE || radius_tol > 0 )
+            subdivide( g[e], src.dist(), trg.dist(), a, b, 0, out );
+        out.push_back( MedialPoint( b.p, b.t ) );
+    }
+    /// true for the edge-types that are evaluated with EdgeProps::point(), false for those drawn from vertex to vertex
+    static bool evaluated(EdgeType type) {
+        return ( type == PARABOLA || type == ELLIPSE || type == HYPERBOLA || type == LINE );
+    }
+private:
+    EdgeSampler(); // don't use.
+    /// a point of an edge, with its parameter u and clearance t
+    struct Part {
+        double u; ///< parameter, 0 at the source and 1 at the target
+        double t; ///< clearance
+        Point p;  ///< position
+        /// the point at \a ui on \a e, from source clearance \a t_src to target clearance \a t_trg
+        Part(double ui, const EdgeProps& e, double t_src, double t_trg) : u(ui) {
+            double t_min = std::min(t_src, t_trg);
+            double t_max = std::max(t_src, t_trg);
+            double w = (t_src <= t_trg) ? u : 1-u; // w=0 at t_min
+            t = t_min + (t_max-t_min)*w*w;
+            p = e.point(t);
+        }
+    };
+    /// \brief the error at a point of the part from \a a to \a b, negated for brent_find_minima()
+    struct Error {
+        const EdgeProps& e; ///< the edge
+        double t_src;       ///< source clearance
+        double t_trg;       ///< target clearance
+        const Part& a;      ///< start of the part
+        const Part& b;      ///< end of the part
+        bool radius;        ///< the clearance error if true, else the distance from the chord
+        /// \param ei edge \param src source clearance \param trg target clearance
+        /// \param ai start of the part \param bi end of the part \param r true for the clearance error
+        Error(const EdgeProps& ei, double src, double trg, const Part& ai, const Part& bi, bool r)
+            : e(ei), t_src(src), t_trg(trg), a(ai), b(bi), radius(r) {}
+        /// minus the error at \a u
+        double operator()(double u) const {
+            Part m( u, e, t_src, t_trg );
+            Point chord = b.p - a.p;
+            double length2 = chord.dot(chord);
+            double lambda = (length2 > 0) ? std::max( 0.0, std::min( 1.0, (m.p-a.p).dot(chord)/length2 ) ) : 0;
+            if ( radius )
+                return -fabs( m.t - (a.t + lambda*(b.t-a.t)) );
+            return -( m.p - (a.p + lambda*chord) ).norm();
+        }
+    };
+    /// the largest error on the part from \a a to \a b, of the clearance if \a radius is true, else of the position
+    double max_error(const EdgeProps& e, double t_src, double t_trg, const Part& a, const Part& b, bool radius) const {
+        Error error( e, t_src, t_trg, a, b, radius );
+        std::pair<double, double> r = boost::math::tools::brent_find_minima( error, a.u, b.u, std::numeric_limits<double>::digits/2 );
+        return -r.second;
+    }
+    /// \brief add the points strictly between \a a and \a b, at depth \a depth of the subdivision
+    void subdivide(const EdgeProps& e, double t_src, double t_trg, const Part& a, const Part& b,
+                   int depth, MedialPointList& out) const {
+        if ( depth >= max_depth )
+            return;
+        // a ::LINE edge is straight, and only its clearance can be off
+        if ( ( e.type == LINE || max_error( e, t_src, t_trg, a, b, false ) <= chord_tol ) &&
+             ( radius_tol <= 0 || max_error( e, t_src, t_trg, a, b, true ) <= radius_tol ) )
+            return;
+        Part m( 0.5*(a.u+b.u), e, t_src, t_trg );
+        subdivide( e, t_src, t_trg, a, m, depth+1, out );
+        out.push_back( MedialPoint( m.p, m.t ) );
+        subdivide( e, t_src, t_trg, m, b, depth+1, out );
+    }
+    double chord_tol;  ///< largest distance between the edge and the polyline
+    double radius_tol; ///< largest clearance error, or 0
+    int max_depth;     ///< the subdivision stops at parts of length 2^-max_depth in u
+};
+
+} // end ovd namespace
+// end file edge_sampler.hpp
@@ -0,0 +1,135 @@
+/*
+ *  Copyright (c) 2010-2012 Anders Wallin (anders.e.e.wallin "at" gmail.com).
+ *
+ *  This file is part of Openvoronoi
+ *  (see https://github.com/aewallin/openvoronoi).
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <vector>
+#include <algorithm>
+
+#include <boost/foreach.hpp>
+
+#include "graph.hpp"
+#include "clearance_cache.hpp"
+
+namespace ovd
+{
+
+/// \brief index of the clearance-interval of each face
+///
+/// the clearance-interval of a face is [min,max] of the clearance-disk radius dist()
+/// of its vertices. an offset at distance t can only pass through faces with min < t < max.
+///
+/// the intervals are sorted by min, and stored as an implicit balanced binary tree
+/// (the middle interval of a range is the root of the range) where each node also holds the
+/// largest max in its subtree. a query for t visits O(log F + k) nodes, for k faces found.
+///
+/// the index is built from a ClearanceCache by build(). HEGraph::generation() is recorded, so that
+/// a changed graph (e.g. after inserting a site) is detected with stale().
+class FaceIntervalIndex {
+public:
+    /// one face and its clearance-interval
+    struct Interval {
+        double lo;  ///< smallest vertex clearance on the face
+        double hi;  ///< largest vertex clearance on the face
+        HEFace f;   ///< the face
+        /// sort by lo
+        bool operator<(const Interval& other) const { return lo < other.lo; }
+    };
+    /// create an empty index
+    FaceIntervalIndex() : _generation(0), _built(false) {}
+
+    /// build the index from the face clearances in \a c
+    void build(const ClearanceCache& c) {
+        intervals.clear();
+        for(HEFace f=0; f<c.num_faces() ; f++) {
+            Interval iv;
+            iv.lo = c.face_min(f);
+            iv.hi = c.face_max(f);
+            iv.f = f;
+            if (iv.lo < iv.hi)
+                intervals.push_back(iv);
+        }
+        build_tree( c.generation() );
+    }
+    /// build the index from the face clearances in \a c, for \a faces only
+    void build(const ClearanceCache& c, const std::vector<HEFace>& faces) {
+        intervals.clear();
+        BOOST_FOREACH(HEFace f, faces) {
+            Interval iv;
+            iv.lo = c.face_min(f);
+            iv.hi = c.face_max(f);
+            iv.f = f;
+            if (iv.lo < iv.hi)
+                intervals.push_back(iv);
+        }
+        build_tree( c.generation() );
+    }
+    /// true if build() has not been called for the current state of \a g
+    bool stale(const HEGraph& g) const { return !_built || _generation != g.generation(); }
+
+    /// append to \a out the faces with lo < t < hi, in no particular order
+    void query(double t, std::vector<HEFace>& out) const {
+        if ( !intervals.empty() )
+            query(0, intervals.size(), t, out);
+    }
+    /// the intervals, sorted by lo
+    const std::vector<Interval>& sorted() const { return intervals; }
+private:
+    /// sort the intervals and build the tree, for the graph at \a generation
+    void build_tree(unsigned long generation) {
+        std::sort( intervals.begin(), intervals.end() );
+        max_hi.resize( intervals.size() );
+        if ( !intervals.empty() )
+            build_max(0, intervals.size());
+        _generation = generation;
+        _built = true;
+    }
+    /// set max_hi for the subtree of range [begin,end), return it
+    double build_max(std::size_t begin, std::size_t end) {
+        std::size_t mid = begin + (end-begin)/2;
+        double m = intervals[mid].hi;
+        if (begin < mid)
+            m = std::max(m, build_max(begin,mid) );
+        if (mid+1 < end)
+            m = std::max(m, build_max(mid+1,end) );
+        max_hi[mid] = m;
+        return m;
+    }
+    /// query the subtree of range [begin,end)
+    void query(std::size_t begin, std::size_t end, double t, std::vector<HEFace>& out) const {
+        std::size_t mid = begin + (end-begin)/2;
+        if ( max_hi[mid] <= t ) // no interval in this subtree reaches above t
+            return;
+        if (begin < mid)
+            query(begin, mid, t, out);
+        if ( intervals[mid].lo >= t ) // this and all intervals to the right start above t
+            return;
+        if ( t < intervals[mid].hi )
+            out.push_back( intervals[mid].f );
+        if (mid+1 < end)
+            query(mid+1, end, t, out);
+    }
+    std::vector<Interval> intervals; ///< face intervals, sorted by lo
+    std::vector<double> max_hi;      ///< largest hi in the subtree rooted at each interval
+    unsigned long _generation;       ///< HEGraph::generation() when the index was built
+    bool _built;                     ///< build() has been called
+};
+
+} // end ovd namespace
+// end file face_interval_index.hpp
@@ -36,6 +36,7 @@ namespace ovd {
 // vecS is slightly faster than listS
 // vecS   5.72us * n log(n)
 // listS  6.18 * n log(n)
+// (run bench/ovd_bench to measure current numbers)
 #define OUT_EDGE_CONTAINER boost::listS 
 #define VERTEX_CONTAINER boost::listS
 #define EDGE_LIST_CONTAINER boost::listS
@@ -20,6 +20,7 @@
 #pragma once
 
 #include <vector>
+#include <cstddef>
 
 namespace kdtree {
 
@@ -76,7 +77,7 @@ template<class point_type>
 class KDTree {
 public:
     /// ctor
-    KDTree(int dim = 3) : dim_(dim), root_(0), rect_(0) {
+    KDTree(int dim = 3) : dim_(dim), root_(0), rect_(0), num_nodes_(0) {
     }
     virtual ~KDTree() {
         if (rect_)
@@ -104,6 +105,12 @@ public:
     }
     /// for debug, return the number of function calls made during a search
     int get_num_calls() {return num_nearest_i_calls;}
+    /// return the number of nodes in the tree
+    unsigned int size() const {return num_nodes_;}
+    /// return the number of bytes allocated for nodes and the bounding hyperrectangle
+    std::size_t memory_usage() const {
+        return num_nodes_*sizeof(kd_node<point_type>) + (rect_ ? sizeof(kd_hyperrect<point_type>) : 0);
+    }
     /// print output of tree
     void print_tree() {
         if (root_)
@@ -128,6 +135,7 @@ private:
     int insert_rec( kd_node<point_type>*& node, const point_type pos, int dir) {
         if (node == 0) {
             node = new kd_node<point_type>(pos,dir,0,0);
+            num_nodes_++;
             if (root_==0) {
                 root_=node;
             }
@@ -274,6 +282,7 @@ private:
     int dim_; ///< number of dimensions 
     kd_node<point_type>* root_; ///< root of the tree
     kd_hyperrect<point_type>* rect_; ///< hyperrectangle
+    unsigned int num_nodes_; ///< number of nodes allocated
 };
 
 } // kdtree namespace
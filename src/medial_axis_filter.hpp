@@ -43,8 +43,8 @@ struct medial_axis_filter : public Filter {
     
     /// predicate that decides if an edge is to be included or not.
     bool operator()(const HEEdge& e) const {
-        if ( (*g)[e].type == LINESITE || (*g)[e].type == NULLEDGE) 
-            return true; // we keep linesites and nulledges
+        if ( (*g)[e].type == LINESITE || (*g)[e].type == ARCSITE || (*g)[e].type == NULLEDGE) 
+            return true; // we keep linesites, arcsites and nulledges
         if ( (*g)[e].type == SEPARATOR)
             return false; // separators are always removed
             
@@ -80,29 +80,36 @@ private:
     
     /// \brief calculate the dot-product between unit vectors aligned along edges e1->e2
     ///
-    /// since e1 and e2 are both line-sites the direction is easy to find
-    /// FIXME: more code needed here for tangent calculation if we have arc-sites
+    /// for line-sites the direction is along the segment. for arc-sites we use the
+    /// tangent at the source of \a e1 and at the target of \a e2, i.e. at the endpoints
+    /// that connect to the medial-axis edge.
     double edge_dotprod(HEEdge e1, HEEdge e2) const {
-        HEVertex src1 = g->source(e1);
-        HEVertex trg1 = g->target(e1);
-        HEVertex src2 = g->source(e2);
-        HEVertex trg2 = g->target(e2);
-        Point sp1 = (*g)[src1].position;
-        Point tp1 = (*g)[trg1].position;
-        Point sp2 = (*g)[src2].position;
-        Point tp2 = (*g)[trg2].position;
-        
-        Point dir1 = tp1-sp1;
-        Point dir2 = tp2-sp2;
+        Point dir1 = edge_direction(e1, g->source(e1) );
+        Point dir2 = edge_direction(e2, g->target(e2) );
         dir1.normalize();
         dir2.normalize();
         return dir1.dot(dir2);
     }
     
-    /// find the LineSite edge that connects to \a v
+    /// direction of the ::LINESITE or ::ARCSITE edge \a e at its endpoint \a v
+    Point edge_direction(HEEdge e, HEVertex v) const {
+        Point sp = (*g)[ g->source(e) ].position;
+        Point tp = (*g)[ g->target(e) ].position;
+        if ( (*g)[e].type == LINESITE )
+            return tp-sp;
+        // the face is to the left of e, so with the outside (k=+1) face
+        // of the arc to the left, e turns clockwise around the center.
+        Site* s = (*g)[ (*g)[e].face ].site;
+        Point tangent = ( (*g)[v].position - Point(s->x(),s->y()) ).xy_perp(); // ccw tangent
+        if ( s->k() == 1 )
+            tangent = -1*tangent;
+        return tangent;
+    }
+    
+    /// find the LineSite or ArcSite edge that connects to \a v
     HEEdge find_segment(HEVertex v) const {
         BOOST_FOREACH(HEEdge e, g->out_edges(v)) {
-            if ( (*g)[e].type == LINESITE )
+            if ( (*g)[e].type == LINESITE || (*g)[e].type == ARCSITE )
                 return e;
         }
         assert(0);
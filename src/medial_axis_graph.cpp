@@ -0,0 +1,153 @@
+/*
+ *  Copyright (c) 2010-2012 Anders Wallin (anders.e.e.wallin "at" gmail.com).
+ *
+ *  This file is part of Openvoronoi
+ *  (see https://github.com/aewallin/openvoronoi).
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <boost/foreach.hpp>
+
+#include "medial_axis_graph.hpp"
+#include "trace.hpp"
+
+namespace ovd
+{
+
+/// true for an edge of the medial-axis: valid, and not a site or null-edge
+static bool medial_axis_edge(const HEGraph& g, HEEdge e) {
+    return ( g[e].valid && g[e].type != LINESITE && g[e].type != ARCSITE &&
+             g[e].type != NULLEDGE && g[e].type != OUTEDGE );
+}
+
+/// \brief build the MedialAxisGraph of \a g, a vd-graph filtered with medial_axis_filter
+///
+/// the half-edges of the medial-axis are numbered in edge-list order, with the number of each kept by its
+/// EdgeProps::index, and listed by source vertex, vertex by vertex. so the graph is read in one pass over its edges.
+/// then each branch is walked once, from a node, along the half-edges not yet walked:
+/// through a vertex of degree two the walk continues on the out-edge that is not the twin of the edge it came by.
+/// the half-edges left after all nodes are on loops without junctions.
+MedialAxisGraph extract_medial_axis(const HEGraph& g) {
+    OVD_TRACE_SCOPE("extract_medial_axis");
+    MedialAxisGraph out;
+    const unsigned int NO_EDGE = 0xFFFFFFFF;
+    std::vector<HEEdge> half; // the half-edges of the medial-axis, in edge-list order
+    std::vector<unsigned int> number( g.num_edges(), NO_EDGE ); // number of each half-edge, by EdgeProps::index
+    BOOST_FOREACH( HEEdge e, g.edges() ) {
+        if ( medial_axis_edge(g,e) && g[e].twin != HEEdge() && medial_axis_edge(g, g[e].twin) ) {
+            number[ g[e].index ] = half.size();
+            half.push_back(e);
+        }
+    }
+    unsigned int n_half = half.size();
+    std::vector<unsigned int> twin( n_half );
+    for (unsigned int n=0;n<n_half;n++)
+        twin[n] = number[ g[ g[ half[n] ].twin ].index ];
+    std::vector<unsigned int> vertex( n_half );  // source vertex of each half-edge
+    std::vector<unsigned int> out_begin;         // first out-edge of each vertex in out_edge
+    std::vector<unsigned int> out_edge;          // the out-edges of each vertex
+    out_edge.reserve( n_half );
+    BOOST_FOREACH( HEVertex v, g.vertices() ) {
+        unsigned int begin = out_edge.size();
+        HEOutEdgeItr it, it_end;
+        for ( boost::tie(it, it_end) = g.out_edge_itr(v); it != it_end; ++it ) {
+            unsigned int h = number[ g[*it].index ];
+            if ( h != NO_EDGE ) {
+                vertex[h] = out_begin.size();
+                out_edge.push_back(h);
+            }
+        }
+        if ( out_edge.size() > begin )
+            out_begin.push_back(begin);
+    }
+    unsigned int n_vertices = out_begin.size();
+    out_begin.push_back( n_half );
+
+    // the nodes: vertices of degree other than two, in the order of their first out-edge in the edge-list
+    const unsigned int NO_NODE = 0xFFFFFFFF;
+    std::vector<unsigned int> node( n_vertices, NO_NODE );
+    std::vector<unsigned int> node_vertex;
+    for (unsigned int n=0;n<n_half;n++) {
+        unsigned int v = vertex[n];
+        if ( node[v] == NO_NODE && out_begin[v+1]-out_begin[v] != 2 ) {
+            node[v] = node_vertex.size();
+            node_vertex.push_back(v);
+        }
+    }
+    // walk the branches from each node, and then the loops
+    std::vector<char> walked( n_half, false );
+    unsigned int first_left = 0; // no half-edge before this is left
+    for (unsigned int k=0;;k++) {
+        if ( k == node_vertex.size() ) { // the half-edges left are on loops. start at the source of the first
+            while ( first_left < n_half && walked[first_left] )
+                first_left++;
+            if ( first_left == n_half )
+                break;
+            node[ vertex[first_left] ] = k;
+            node_vertex.push_back( vertex[first_left] );
+        }
+        unsigned int v = node_vertex[k];
+        for (unsigned int i=out_begin[v];i<out_begin[v+1];i++) {
+            unsigned int h = out_edge[i];
+            if ( walked[h] )
+                continue;
+            MedialAxisGraph::Branch b;
+            b.source = k;
+            b.begin = out.pieces.size();
+            unsigned int u;
+            while (true) {
+                walked[h] = walked[ twin[h] ] = true;
+                MedialAxisGraph::Piece p;
+                p.edge = half[h];
+                p.t_begin = g[ g.source( half[h] ) ].dist();
+                p.t_end = g[ g.target( half[h] ) ].dist();
+                out.pieces.push_back(p);
+                u = vertex[ twin[h] ];
+                if ( node[u] != NO_NODE )
+                    break;
+                unsigned int next = out_edge[ out_begin[u] ];
+                h = ( next == twin[h] ) ? out_edge[ out_begin[u]+1 ] : next;
+            }
+            b.target = node[u];
+            b.end = out.pieces.size();
+            out.branches.push_back(b);
+        }
+    }
+    for (unsigned int k=0;k<node_vertex.size();k++) {
+        MedialAxisGraph::Node n;
+        n.vertex = g.source( half[ out_edge[ out_begin[ node_vertex[k] ] ] ] );
+        n.position = g[n.vertex].position;
+        n.clearance = g[n.vertex].dist();
+        out.nodes.push_back(n);
+    }
+    // the adjacency, in CSR form
+    out.offsets.assign( out.nodes.size()+1, 0 );
+    BOOST_FOREACH( const MedialAxisGraph::Branch& b, out.branches ) {
+        out.offsets[ b.source+1 ]++;
+        out.offsets[ b.target+1 ]++;
+    }
+    for (unsigned int k=0;k<out.nodes.size();k++)
+        out.offsets[k+1] += out.offsets[k];
+    out.adjacency.resize( out.offsets.back() );
+    std::vector<unsigned int> fill( out.offsets.begin(), out.offsets.end()-1 );
+    for (unsigned int b=0;b<out.branches.size();b++) {
+        out.adjacency[ fill[ out.branches[b].source ]++ ] = b;
+        out.adjacency[ fill[ out.branches[b].target ]++ ] = b;
+    }
+    return out;
+}
+
+} // end ovd namespace
+// end file medial_axis_graph.cpp
@@ -0,0 +1,82 @@
+/*
+ *  Copyright (c) 2010-2012 Anders Wallin (anders.e.e.wallin "at" gmail.com).
+ *
+ *  This file is part of Openvoronoi
+ *  (see https://github.com/aewallin/openvoronoi).
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <vector>
+
+#include "graph.hpp"
+
+namespace ovd
+{
+
+/// \brief the medial-axis as a graph of nodes and branches, with the adjacency in compressed sparse row (CSR) form
+///
+/// the nodes are the junctions (degree three or more) and the end-points (degree one) of the medial-axis.
+/// a branch runs between two nodes, through vertices of degree two, and consists of pieces: the vd-edges
+/// it passes, oriented from the source node to the target node. a piece refers to the edge, so that
+/// EdgeProps::point() evaluates its bisector, from clearance t_begin to t_end. (::LINELINE edges are linear
+/// in the clearance, but ::PARA_LINELINE edges have one clearance along their length, and are drawn from vertex to vertex.)
+///
+/// a loop of the medial-axis without junctions gets one node, of degree two, with one branch from the node to itself.
+///
+/// the branches at node n are adjacency[ offsets[n] ] ... adjacency[ offsets[n+1]-1 ]. a branch from a node to
+/// itself is listed twice.
+struct MedialAxisGraph {
+    /// \brief a junction or end-point of the medial-axis
+    struct Node {
+        Point position;   ///< position
+        double clearance; ///< clearance-disk radius
+        HEVertex vertex;  ///< the vertex in the graph
+    };
+    /// \brief one vd-edge of a branch
+    struct Piece {
+        HEEdge edge;    ///< the (half-)edge, in the direction of the branch
+        double t_begin; ///< clearance at the source of the edge
+        double t_end;   ///< clearance at the target of the edge
+    };
+    /// \brief a branch of the medial-axis, from node to node
+    struct Branch {
+        unsigned int source; ///< the node where the branch starts
+        unsigned int target; ///< the node where the branch ends
+        unsigned int begin;  ///< first piece
+        unsigned int end;    ///< one past the last piece
+    };
+    std::vector<Node> nodes;            ///< the nodes
+    std::vector<Branch> branches;       ///< the branches
+    std::vector<Piece> pieces;          ///< the pieces of all branches, branch by branch
+    std::vector<unsigned int> offsets;  ///< first entry in adjacency of each node, and adjacency.size() at the end
+    std::vector<unsigned int> adjacency; ///< the branches at each node
+
+    /// number of nodes
+    unsigned int num_nodes() const { return nodes.size(); }
+    /// number of branches
+    unsigned int num_branches() const { return branches.size(); }
+    /// number of branch-ends at node \a n
+    unsigned int degree(unsigned int n) const { return offsets[n+1]-offsets[n]; }
+    /// the node at the other end of branch \a b, from node \a n
+    unsigned int other(unsigned int b, unsigned int n) const {
+        return ( branches[b].source == n ) ? branches[b].target : branches[b].source;
+    }
+};
+
+MedialAxisGraph extract_medial_axis(const HEGraph& g);
+
+} // end ovd namespace
+// end file medial_axis_graph.hpp
@@ -17,29 +17,61 @@
  *  You should have received a copy of the GNU Lesser General Public License
  *  along with this program. If not, see <http://www.gnu.org/licenses/>.
 */
+#include <algorithm>
+
 #include "medial_axis_pocket.hpp"
+#include "run_tasks.hpp"
+#include "trace.hpp"
 
 namespace ovd
 {
 
 /// the input graph should be a voronoi diagram passed through medial_axis_filter
-medial_axis_pocket::medial_axis_pocket(HEGraph& gi): g(gi) {
+///
+/// the done-flags are in a vector, indexed directly by the EdgeProps::index of an edge.
+/// the medial-axis edges are put in a heap by the clearance at their source, for find_initial_mic().
+medial_axis_pocket::medial_axis_pocket(HEGraph& gi): table(new edge_table), component(-1), last_start(0,0), g(gi) {
     BOOST_FOREACH( HEEdge e, g.edges() ) {
         if ( g[e].valid && 
              g[e].type != LINESITE && 
+             g[e].type != ARCSITE && 
              g[e].type != NULLEDGE && 
              g[e].type != OUTEDGE   ) {
-            ma_edges.push_back(e);
-            edata ed;
-            edge_data.insert( std::make_pair(e, ed ) );
+            starts.push( start_edge( g[ g.source(e) ].dist(), table->ma_edges.size() ) );
+            table->ma_edges.push_back(e);
         }
     }
+    table->done.assign( g.num_edges(), false );
     current_edge = HEEdge();
+    step_edge = HEEdge();
+    step_u = 0;
     max_width = 0.05;
     debug = false;
     //max_mic_count=300; // limit output size in debug mode
 }
 
+/// \brief a worker of run_parallel(), that machines component \a c
+///
+/// \param t the table of the calling medial_axis_pocket
+/// \param edges the medial-axis edges of the component, as indices in edge_table::ma_edges
+medial_axis_pocket::medial_axis_pocket(HEGraph& gi, edge_table* t, int c, const std::vector<unsigned int>& edges)
+    : table(t), component(c), last_start(0,0), g(gi) {
+    BOOST_FOREACH( unsigned int n, edges ) {
+        starts.push( start_edge( g[ g.source( table->ma_edges[n] ) ].dist(), n ) );
+    }
+    current_edge = HEEdge();
+    step_edge = HEEdge();
+    step_u = 0;
+    max_width = 0.05;
+    debug = false;
+}
+
+/// the table is shared with the workers, and deleted with the object that created it
+medial_axis_pocket::~medial_axis_pocket() {
+    if ( component == -1 )
+        delete table;
+}
+
 /// set the maximum cut width
 void medial_axis_pocket::set_width(double w) {max_width=w;}
 /// set debug mode
@@ -48,6 +80,20 @@ void medial_axis_pocket::set_debug(bool b) {debug=b;}
 //medial_axis_pocket::MICList medial_axis_pocket::get_mic_list() {return mic_list;}
 /// return the algorithm output
 std::vector<medial_axis_pocket::MICList> medial_axis_pocket::get_mic_components() {return ma_components;}
+/// return the root-finding counters, summed over the workers after run_parallel()
+medial_axis_pocket::SolverStats medial_axis_pocket::solver_stats() const {return stats;}
+
+/// all counters zero
+medial_axis_pocket::SolverStats::SolverStats()
+    : solves(0), closed_form(0), bracketed(0), iterations(0), evaluations(0) {}
+/// add the counters of \a other
+void medial_axis_pocket::SolverStats::add(const SolverStats& other) {
+    solves += other.solves;
+    closed_form += other.closed_form;
+    bracketed += other.bracketed;
+    iterations += other.iterations;
+    evaluations += other.evaluations;
+}
 
 /*
 /// run the algorithm (single connected component)
@@ -59,6 +105,7 @@ void medial_axis_pocket::run() {
 
 /// many component run
 void medial_axis_pocket::run() {
+    OVD_TRACE_SCOPE("medial_axis_pocket");
     mic_list.clear();
     while ( find_initial_mic() ) {
         while (find_next_mic()) {}
@@ -72,6 +119,95 @@ void medial_axis_pocket::run() {
 
 }
 
+/// \brief run the algorithm on each connected component of the medial-axis, on \a threads threads
+///
+/// \param threads number of threads, 0 for std::thread::hardware_concurrency()
+///
+/// the components are labelled by union-find over the medial-axis edges, and each component
+/// is machined by its own worker, with its own stack of unvisited branches and MIC-list.
+/// the MICLists are output in the order in which run() starts them: the largest clearance-disk first.
+/// so the output does not depend on the number of threads, and is the same as from run(), as long as
+/// each walk stays on its own component.
+void medial_axis_pocket::run_parallel(unsigned int threads) {
+    OVD_TRACE_SCOPE("medial_axis_pocket_parallel");
+    if (threads == 0)
+        threads = std::max( 1u, std::thread::hardware_concurrency() );
+    int n_components = label_components();
+    std::vector< std::vector<unsigned int> > edges( n_components );
+    for (unsigned int n=0;n<table->ma_edges.size();n++)
+        edges[ table->component[ number( table->ma_edges[n] ) ] ].push_back(n);
+    std::vector<ComponentOutput> outputs( n_components );
+    std::vector<SolverStats> worker_stats( n_components );
+    auto work = [&](std::size_t c, unsigned int) {
+        medial_axis_pocket worker(g, table, c, edges[c]);
+        worker.set_width(max_width);
+        worker.set_debug(debug);
+        worker.run_component( outputs[c] );
+        worker_stats[c] = worker.solver_stats();
+    };
+    run_tasks( n_components, threads, work );
+    BOOST_FOREACH( const SolverStats& s, worker_stats ) {
+        stats.add(s);
+    }
+    ComponentOutput all;
+    BOOST_FOREACH( const ComponentOutput& out, outputs ) {
+        all.insert( all.end(), out.begin(), out.end() );
+    }
+    // the start-edges of one component are already in this order, as they come from one heap
+    std::stable_sort( all.begin(), all.end(), later_start() );
+    for (unsigned int n=0;n<all.size();n++)
+        ma_components.push_back( all[n].second );
+    if (debug) std::cout << "medial_axis_pocket::run_parallel() all done. generated " << ma_components.size() << " components \n";
+}
+
+/// \brief label the connected components of the medial-axis, in edge_table::component
+/// \return the number of components
+///
+/// the components are numbered in the order of their first edge in edge_table::ma_edges.
+int medial_axis_pocket::label_components() {
+    // the ends of each edge, as vertex numbers
+    std::vector<unsigned int> source;
+    unsigned int n_vertices = g.source_numbers(source);
+    std::vector<unsigned int> vertex( 2*table->ma_edges.size() );
+    for (unsigned int n=0;n<table->ma_edges.size();n++) {
+        HEEdge e = table->ma_edges[n];
+        vertex[2*n] = source[ g[e].index ];
+        vertex[2*n+1] = source[ g[ g[e].next ].index ];
+    }
+    // union-find, with path-halving
+    std::vector<unsigned int> parent( n_vertices );
+    for (unsigned int v=0;v<parent.size();v++)
+        parent[v] = v;
+    for (unsigned int n=0;n<table->ma_edges.size();n++) {
+        unsigned int a = vertex[2*n], b = vertex[2*n+1];
+        while ( parent[a] != a ) { parent[a] = parent[ parent[a] ]; a = parent[a]; }
+        while ( parent[b] != b ) { parent[b] = parent[ parent[b] ]; b = parent[b]; }
+        parent[ std::max(a,b) ] = std::min(a,b);
+    }
+    table->component.assign( table->done.size(), -1 );
+    std::vector<int> label( parent.size(), -1 );
+    int n_components = 0;
+    for (unsigned int n=0;n<table->ma_edges.size();n++) {
+        unsigned int root = vertex[2*n];
+        while ( parent[root] != root )
+            root = parent[root];
+        if ( label[root] == -1 )
+            label[root] = n_components++;
+        table->component[ number( table->ma_edges[n] ) ] = label[root];
+    }
+    return n_components;
+}
+
+/// \brief machine the component of this worker, and add each MICList to \a output with the edge it started from
+void medial_axis_pocket::run_component(ComponentOutput& output) {
+    mic_list.clear();
+    while ( find_initial_mic() ) {
+        while (find_next_mic()) {}
+        output.push_back( std::make_pair( last_start, mic_list ) );
+        mic_list.clear();
+    }
+}
+
     
 /// find the largest MIC and add it to the output
 bool medial_axis_pocket::find_initial_mic() {
@@ -80,18 +216,14 @@ bool medial_axis_pocket::find_initial_mic() {
     double max_mic_radius(-1);
     Point max_mic_pos(0,0);
     HEVertex max_mic_vertex = HEVertex();
-    bool found(false);
-    BOOST_FOREACH( HEEdge e, ma_edges ) {
-        HEVertex src = g.source(e);
-        if ( !edge_data[e].done && g[src].dist() > max_mic_radius ) {
-            max_mic_radius = g[src].dist();
-            max_mic_pos = g[src].position; 
-            max_mic_vertex = src;
-            found = true;
-        }
-    }
-    if (!found)
+    while ( !starts.empty() && is_done( table->ma_edges[ starts.top().n ] ) ) // edges are only ever marked done, so drop them here
+        starts.pop();
+    if ( starts.empty() )
         return false;
+    last_start = starts.top();
+    max_mic_vertex = g.source( table->ma_edges[ starts.top().n ] );
+    max_mic_radius = g[max_mic_vertex].dist();
+    max_mic_pos = g[max_mic_vertex].position;
         
     if (debug) { std::cout << "find_initial_mic() max mic is c="<< max_mic_pos << " r=" << max_mic_radius << "\n"; }
 
@@ -218,7 +350,7 @@ HEEdge medial_axis_pocket::find_next_branch() {
         current_center = out.current_center;
         current_radius = out.current_radius;
         new_branch = true;
-        if ( !edge_data[ out.next_edge ].done )
+        if ( !is_done( out.next_edge ) )
             return out.next_edge;
         else
             return find_next_branch();
@@ -230,7 +362,7 @@ EdgeVector medial_axis_pocket::find_out_edges() {
     EdgeVector out_edges;
     BOOST_FOREACH(HEEdge e, g.out_edge_itr(trg) ) {
         if ( e != g[current_edge].twin && 
-             g[e].valid && !edge_data[e].done && 
+             g[e].valid && !is_done(e) && 
              g[e].type != NULLEDGE && 
              g[e].type != OUTEDGE ) {
             out_edges.push_back(e);
@@ -301,8 +433,33 @@ std::pair<HEEdge,bool> medial_axis_pocket::find_next_edge() {
 
 /// mark edge and its twin done
 void medial_axis_pocket::mark_done(HEEdge e) {
-    edge_data[ e ].done = true;
-    edge_data[ g[e].twin ].done = true;
+    set_done(e);
+    if ( g[e].twin != HEEdge() )
+        set_done( g[e].twin );
+}
+
+/// \brief set the done-flag of \a e
+///
+/// a worker of run_parallel() keeps the flags of edges outside its component to itself
+void medial_axis_pocket::set_done(HEEdge e) {
+    unsigned int n = number(e);
+    if ( component == -1 || table->component[n] == component )
+        table->done[n] = true;
+    else
+        foreign_done.insert(n);
+}
+
+/// is edge \a e done?
+bool medial_axis_pocket::is_done(HEEdge e) const {
+    unsigned int n = number(e);
+    if ( component == -1 || table->component[n] == component )
+        return table->done[n];
+    return !foreign_done.empty() && foreign_done.count(n) > 0; // usually empty: a component has its own edges
+}
+
+/// the number of edge \a e, its EdgeProps::index
+unsigned int medial_axis_pocket::number(HEEdge e) const {
+    return g[e].index;
 }
 
 /// does HEEdge e have the next MIC we want ?
@@ -328,34 +485,145 @@ bool medial_axis_pocket::has_next_radius(HEEdge e) {
         return false;
 }
 
-/// find the next u-value that produces the desired cut-width
+/// \brief find the next u-value that produces the desired cut-width
+///
+/// on line-type edges the root is found in closed form, by closed_form_u().
+/// on the other edges, or if that fails, toms748 finds it in a bracket from bracketed_u().
 std::pair<double,double> medial_axis_pocket::find_next_u() {
     CutWidthError t(this, current_edge, max_width, current_center, current_radius);
+    stats.solves++;
+    double u;
+    if ( closed_form_u(t,u) ) {
+        stats.closed_form++;
+        if (debug) { std::cout << "find_next_u(): closed-form u = " << u << " on "; g.print_edge(current_edge); }
+    } else {
+        double trg_err = t(1.0);
+        double cur_err = t(current_u);
+        if ( debug ||  ( !(trg_err*cur_err < 0) ) ) {
+            std::cout << "find_next_u():\n";
+            std::cout << " current edge: "; g.print_edge(current_edge);// << current_radius << "\n";
+            std::cout << "    edge type: " << g[current_edge].type_str() << "\n";
+            std::cout << " source c= "<< g[ g.source(current_edge) ].position << " r= " << g[ g.source(current_edge) ].dist() << " err= " <<  t(0.0) <<"\n";
+            std::cout << " target c= "<< g[ g.target(current_edge) ].position << " r= " << g[ g.target(current_edge) ].dist() << " err= " <<  t(1.0) <<"\n";
+            std::cout << " current c1=" << current_center << " r1=" << current_radius << "\n";
+            std::cout << " current u = " << current_u << "\n";
+            std::cout << " error at current = " << t(current_u) << "\n";
+            std::cout << " error at target = " << t(1.0) << "\n";
+        }
+        u = bracketed_u(t, cur_err, trg_err);
+    }
+    step_edge = current_edge;
+    step_u = u - current_u;
+    double rnext;
+    Point pnext;
+    boost::tie( pnext, rnext ) = edge_point( current_edge, u );
+    return std::make_pair( u, rnext );
+}
+
+/// \brief the smallest root in [\a lo, \a hi] of the quadratic a*u^2 + 2*b*u + c, that \a t accepts
+///
+/// the quadratics come from squaring the cut-width equation, so a root may be spurious.
+/// each root is checked with \a t, and accepted if the error is within \a tol.
+template <class Error>
+static bool quadratic_root(double a, double b, double c, double lo, double hi, Error& t, double tol, double& u) {
+    double roots[2];
+    int n = 0;
+    if ( fabs(a) <= 1e-12*( fabs(b) + fabs(c) ) ) { // linear
+        if ( b == 0 )
+            return false;
+        roots[n++] = -c/(2*b);
+    } else {
+        double disc = b*b - a*c;
+        if ( disc < 0 ) {
+            if ( disc < -1e-12*b*b )
+                return false;
+            disc = 0;
+        }
+        double q = -( b + ( b<0 ? -1 : 1 )*sqrt(disc) );
+        roots[n++] = q/a;
+        if ( q != 0 )
+            roots[n++] = c/q;
+    }
+    if ( n == 2 && roots[1] < roots[0] )
+        std::swap( roots[0], roots[1] );
+    double slack = 1e-9*(hi-lo);
+    for (int i=0;i<n;i++) {
+        if ( roots[i] < lo-slack || roots[i] > hi+slack )
+            continue;
+        double r = std::max( lo, std::min( hi, roots[i] ) );
+        if ( fabs( t(r) ) <= tol ) {
+            u = r;
+            return true;
+        }
+    }
+    return false;
+}
+
+/// \brief solve for the next u on ::LINE, ::LINELINE and ::PARA_LINELINE edges, without iteration
+///
+/// the center moves linearly in u, c(u) = c0 + u*d, and the cut-width is |c(u)-c1| + r(u) - r1.
+/// - on ::LINELINE and ::PARA_LINELINE edges r(u) is linear in u, the distance to a line-site,
+///   and squaring |c(u)-c1| = w + r1 - r(u) gives a quadratic in u.
+/// - on ::LINE edges r(u) = |c(u)-s| for the point-site s, and the sum of the two distances
+///   is squared twice to give a quadratic.
+/// \return false on other edges, or if no root is accepted, e.g. where the apex of a line-site is an endpoint
+bool medial_axis_pocket::closed_form_u(CutWidthError& t, double& u) {
+    EdgeType type = g[current_edge].type;
+    if ( type != LINE && type != LINELINE && type != PARA_LINELINE )
+        return false;
+    Point c0 = g[ g.source(current_edge) ].position;
+    Point d = g[ g.target(current_edge) ].position - c0;
+    Point a = c0 - current_center;
+    double tol = 1e-9*( max_width + d.norm() );
+    if ( type == LINE ) {
+        Site* s = g[ g[current_edge].face ].site;
+        Point b = c0 - s->apex_point(c0);
+        double k = max_width + current_radius;
+        double alpha = k*k + b.dot(b) - a.dot(a);
+        double beta = 2*(b-a).dot(d);
+        return quadratic_root( 4*k*k*d.dot(d) - beta*beta, 4*k*k*b.dot(d) - alpha*beta,
+                               4*k*k*b.dot(b) - alpha*alpha, current_u, 1.0, t, tol, u );
+    }
+    double r0 = edge_point(current_edge, 0.0).second;
+    double dr = edge_point(current_edge, 1.0).second - r0;
+    double k = max_width + current_radius - r0;
+    return quadratic_root( d.dot(d) - dr*dr, a.dot(d) + k*dr, a.dot(a) - k*k, current_u, 1.0, t, tol, u );
+}
+
+/// \brief solve for the next u with toms748, given the errors \a cur_err at current_u and \a trg_err at the target
+///
+/// the bracket is [current_u, 1], unless the previous step was on the same edge: then the same step
+/// is tried first, and doubled until the error changes sign. consecutive steps along an edge are of similar length,
+/// so the bracket is usually much smaller than the rest of the edge, and toms748 needs fewer iterations.
+double medial_axis_pocket::bracketed_u(CutWidthError& t, double cur_err, double trg_err) {
     typedef std::pair<double, double> Result;
     boost::uintmax_t max_iter=500;
     boost::math::tools::eps_tolerance<double> tol(30);
-    double trg_err = t(1.0);
-    double cur_err = t(current_u);
-    if ( debug ||  ( !(trg_err*cur_err < 0) ) ) {
-        std::cout << "find_next_u():\n";
-        std::cout << " current edge: "; g.print_edge(current_edge);// << current_radius << "\n";
-        std::cout << "    edge type: " << g[current_edge].type_str() << "\n";
-        std::cout << " source c= "<< g[ g.source(current_edge) ].position << " r= " << g[ g.source(current_edge) ].dist() << " err= " <<  t(0.0) <<"\n";
-        std::cout << " target c= "<< g[ g.target(current_edge) ].position << " r= " << g[ g.target(current_edge) ].dist() << " err= " <<  t(1.0) <<"\n";
-        std::cout << " current c1=" << current_center << " r1=" << current_radius << "\n";
-        std::cout << " current u = " << current_u << "\n";
-        std::cout << " error at current = " << t(current_u) << "\n";
-        std::cout << " error at target = " << t(1.0) << "\n";
+    double lo = current_u, hi = 1.0;
+    double lo_err = cur_err, hi_err = trg_err;
+    if ( current_edge == step_edge && step_u > 0 && cur_err < 0 && trg_err > 0 ) {
+        stats.bracketed++;
+        double step = step_u;
+        while ( lo + step < hi ) {
+            double u = lo + step;
+            double err = t(u);
+            if ( err == 0 )
+                return u;
+            if ( err > 0 ) {
+                hi = u;
+                hi_err = err;
+                break;
+            }
+            lo = u;
+            lo_err = err;
+            step *= 2;
+        }
     }
-    //double min_r = std::min(current_radius, target_radius);
-    //double max_r = std::max(current_radius, target_radius);
-    Result r1 = boost::math::tools::toms748_solve(t, current_u, 1.0, tol, max_iter);
-    double rnext;
-    Point pnext;
-    boost::tie( pnext, rnext ) = edge_point( current_edge, r1.first );
-    return std::make_pair( r1.first, rnext );
+    Result r1 = boost::math::tools::toms748_solve(t, lo, hi, lo_err, hi_err, tol, max_iter);
+    stats.iterations += max_iter;
+    return r1.first;
 }
-    
+
 /// \brief output the next MIC
 ///
 /// based on the output here a downstream algorithm
@@ -479,7 +747,7 @@ std::pair<Point,double> medial_axis_pocket::edge_point(HEEdge e, double u) {
         Site* s = g[f].site;
         Point pa = s->apex_point(p);
         r = (p-pa).norm();
-    } else if ( g[e].type == PARABOLA ) {
+    } else if ( g[e].type == PARABOLA || g[e].type == ELLIPSE || g[e].type == HYPERBOLA ) {
         // use the existing t-parametrisation (?)
         HEVertex src_v = g.source(e);
         HEVertex trg_v = g.target(e);
@@ -512,11 +780,11 @@ double medial_axis_pocket::CutWidthError::operator()(const double x) {
     Point c2; // = m->edge_point(x); //g[e].point(x); // current MIC center
     double r2; // = x; // current MIC radius
     boost::tie(c2,r2) = m->edge_point(e,x);
+    m->stats.evaluations++;
     double w = (c2-c1).norm() + r2 - r1; // this is the cut-width
     return w-w_max; // error compared to desired cut-width
 }
 
-medial_axis_pocket::edata::edata() { done = false; }
 
 } // end namespace
 
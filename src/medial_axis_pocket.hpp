@@ -23,6 +23,9 @@
 #include <string>
 #include <iostream>
 #include <stack>
+#include <queue>
+#include <vector>
+#include <set>
 
 #include <boost/math/tools/roots.hpp>
 
@@ -41,8 +44,10 @@ namespace ovd {
 class medial_axis_pocket {
 public:
     medial_axis_pocket(HEGraph& gi);
+    ~medial_axis_pocket();
     void set_width(double w);
     void run();
+    void run_parallel(unsigned int threads=0);
     //void run2();
     void set_debug(bool b);
     /// \brief Maximal Inscribed Circle. A combination of a Point and a clearance-disk radius.
@@ -65,6 +70,17 @@ public:
         double r_prev;     ///< for a new branch, the previous radius
     };
     typedef std::vector<MIC> MICList; ///< the list of MIC.s from one connected component of the medial-axis
+    /// \brief counters of the root-finding in find_next_u()
+    struct SolverStats {
+        SolverStats();
+        void add(const SolverStats& other);
+        unsigned long solves;      ///< calls of find_next_u()
+        unsigned long closed_form; ///< solves on line-type edges, without iteration
+        unsigned long bracketed;   ///< iterative solves started from the previous step on the same edge
+        unsigned long iterations;  ///< iterations of toms748
+        unsigned long evaluations; ///< evaluations of the cut-width error
+    };
+    SolverStats solver_stats() const;
     //MICList get_mic_list();
     std::vector<MICList> get_mic_components(); // {return ma_components;}
     std::pair<Point,double> edge_point(HEEdge e, double u); // used by the error-functor also. move somewhere else?
@@ -85,10 +101,26 @@ protected:
         double r1;    ///< previous MIC radius
     };
 
-    /// keep track of bool done true/false flag for each edge
-    struct edata {
-        edata();// { done = false; }
-        bool done; ///< is edge done?
+    /// \brief a medial-axis edge that may start a component, ordered by the clearance at its source
+    ///
+    /// the largest clearance first, and for equal clearance the first edge in ma_edges
+    struct start_edge {
+        double radius;  ///< clearance-disk radius at the source
+        unsigned int n; ///< index in ma_edges
+        /// \param r radius \param i index
+        start_edge(double r, unsigned int i) : radius(r), n(i) {}
+        /// priority_queue order: \a other comes before this
+        bool operator<(const start_edge& other) const {
+            return radius < other.radius || ( radius == other.radius && n > other.n );
+        }
+    };
+
+    /// order of the MICLists of run_parallel(): the start-edge that run() would find first
+    struct later_start {
+        /// true if \a a starts before \a b
+        bool operator()(const std::pair<start_edge, MICList>& a, const std::pair<start_edge, MICList>& b) const {
+            return b.first < a.first;
+        }
     };
 
     /// branch-data when we backtrack to machine an un-machined branch
@@ -99,26 +131,56 @@ protected:
         HEEdge next_edge;      ///< edge on which to start machining when we switch to the new branch
     };
 
+    /// \brief edge numbers and done-flags, shared by the workers of run_parallel()
+    ///
+    /// each worker writes the done-flags of the edges of its own component only.
+    struct edge_table {
+        std::vector<HEEdge> ma_edges; ///< the edges of the medial-axis
+        std::vector<char> done; ///< is the edge with this number (EdgeProps::index) done?
+        /// connected component of the medial-axis of each numbered edge, or -1 for other edges
+        std::vector<int> component;
+    };
+    /// the MICLists of one component, with the edge each list started from
+    typedef std::vector< std::pair<start_edge, MICList> > ComponentOutput;
+
+    medial_axis_pocket(HEGraph& gi, edge_table* t, int c, const std::vector<unsigned int>& edges);
+    int label_components();
+    void run_component(ComponentOutput& output);
     bool find_initial_mic();
     bool find_next_mic();
     HEEdge find_next_branch();
     EdgeVector find_out_edges();
     std::pair<HEEdge,bool> find_next_edge();
     void mark_done(HEEdge e);
+    void set_done(HEEdge e);
+    bool is_done(HEEdge e) const;
+    unsigned int number(HEEdge e) const;
     bool has_next_radius(HEEdge e); 
     std::pair<double,double> find_next_u();
+    bool closed_form_u(CutWidthError& t, double& u);
+    double bracketed_u(CutWidthError& t, double cur_err, double trg_err);
     void output_next_mic(double next_u, double next_radius, bool branch);
     std::vector<Point> bitangent_points(Point c1, double r1, Point c2, double r2);
     double cut_width(Point c1, double r1, Point c2, double r2);
+    medial_axis_pocket(const medial_axis_pocket&); // don't use.
+    medial_axis_pocket& operator=(const medial_axis_pocket&); // don't use.
 //DATA
     bool debug; ///< debug output flag
-    std::vector<HEEdge> ma_edges; ///< the edges of the medial-axis
-    std::map<HEEdge, edata> edge_data; ///< map from edge-descriptor to bool-flag
+    edge_table* table; ///< edge numbers and done-flags, owned by this object unless it is a worker
+    int component; ///< for a worker of run_parallel(), the component it machines. -1 for the whole graph
+    /// for a worker, done-flags of the edges outside its component, which it does not share
+    std::set<unsigned int> foreign_done;
+    /// the medial-axis edges that may start a component. may hold edges that are done.
+    std::priority_queue<start_edge> starts;
+    start_edge last_start; ///< the start-edge found by the last find_initial_mic()
     HEGraph& g; ///< VD graph
     std::stack<branch_point> unvisited; ///< stack of unvisited branch_point:s
     HEEdge current_edge; ///< the current edge
     double current_radius; ///< current clearance-disk radius
     double current_u; ///< current position along edge. u is in [0,1]
+    HEEdge step_edge; ///< the edge of the last step of find_next_u()
+    double step_u;    ///< the length in u of the last step of find_next_u()
+    SolverStats stats; ///< root-finding counters
     Point current_center; ///< current position
     bool new_branch;     ///< flag for indicating new branch
     Point previous_branch_center; ///< prev branch position
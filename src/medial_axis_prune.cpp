@@ -0,0 +1,164 @@
+/*
+ *  Copyright (c) 2010-2012 Anders Wallin (anders.e.e.wallin "at" gmail.com).
+ *
+ *  This file is part of Openvoronoi
+ *  (see https://github.com/aewallin/openvoronoi).
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <algorithm>
+#include <limits>
+#include <queue>
+
+#include <boost/foreach.hpp>
+
+#include "medial_axis_prune.hpp"
+#include "edge_sampler.hpp"
+#include "common/numeric.hpp"
+#include "site.hpp"
+#include "trace.hpp"
+
+namespace ovd
+{
+
+/// length of edge \a e. curved edges are measured along eight chords, with the points closer together at small clearance
+static double edge_length(const HEGraph& g, HEEdge e) {
+    const Point& src = g[ g.source(e) ].position;
+    const Point& trg = g[ g.target(e) ].position;
+    if ( !EdgeSampler::evaluated( g[e].type ) || g[e].type == LINE )
+        return ( trg-src ).norm();
+    double t_src = g[ g.source(e) ].dist();
+    double t_trg = g[ g.target(e) ].dist();
+    double t_min = std::min(t_src, t_trg);
+    double t_max = std::max(t_src, t_trg);
+    const int n = 9;
+    double t[n];
+    Point p[n];
+    for (int i=0;i<n;i++)
+        t[i] = t_min + (t_max-t_min)*numeric::sq(i/(n-1.0));
+    g[e].points(t, n, p);
+    double length = 0;
+    for (int i=1;i<n;i++)
+        length += ( p[i]-p[i-1] ).norm();
+    return length;
+}
+
+/// \brief the distance between the nearest boundary points of the sites on either side of \a e, at its source,
+/// and the half-angle between the directions to them
+static std::pair<double,double> spread(HEGraph& g, HEEdge e) {
+    const Point& p = g[ g.source(e) ].position;
+    Point f1 = g[ g[e].face ].site->apex_point(p);
+    Point f2 = g[ g[ g[e].twin ].face ].site->apex_point(p);
+    Point d1 = f1-p;
+    Point d2 = f2-p;
+    double angle = 0;
+    if ( d1.norm() > 0 && d2.norm() > 0 ) {
+        double cos_a = d1.dot(d2) / ( d1.norm()*d2.norm() );
+        angle = 0.5*acos( std::max( -1.0, std::min( 1.0, cos_a ) ) );
+    }
+    return std::make_pair( (f1-f2).norm(), angle );
+}
+
+/// \brief the measures of branch \a b, from \a leaf with burn time \a burn, in measure[b]
+void MedialAxisPrune::measure_branch(HEGraph& g, unsigned int b, unsigned int leaf, double burn) {
+    const MedialAxisGraph::Branch& br = mag.branches[b];
+    Measure& m = measure[b];
+    double r_junction = mag.nodes[ mag.other(b, leaf) ].clearance;
+    m.length = 0;
+    m.lambda = 0;
+    m.angle = 0;
+    for (unsigned int i=br.begin;i<br.end;i++) {
+        HEEdge e = mag.pieces[i].edge;
+        m.length += edge_length(g, e);
+        HEEdge ends[2] = { e, g[e].twin }; // the source and the target of the piece
+        for (int k=0;k<2;k++) {
+            std::pair<double,double> s = spread(g, ends[k]);
+            m.lambda = std::max( m.lambda, s.first );
+            m.angle = std::max( m.angle, s.second );
+        }
+    }
+    m.erosion = burn + m.length - r_junction;
+    m.ratio = (r_junction > 0) ? m.length / r_junction : std::numeric_limits<double>::max();
+    m.leaf = true;
+}
+
+/// true if a measure of \a m is below its threshold
+bool MedialAxisPrune::insignificant(const Measure& m) const {
+    return ( ( erosion_threshold > 0 && m.erosion < erosion_threshold ) ||
+             ( ratio_threshold > 0 && m.ratio < ratio_threshold ) ||
+             ( lambda_threshold > 0 && m.lambda < lambda_threshold ) ||
+             ( angle_threshold > 0 && m.angle < angle_threshold ) );
+}
+
+/// the leaf branches are taken from a queue, first those of the end-points of the medial-axis,
+/// and then those left at a junction when its other branches are pruned.
+unsigned int MedialAxisPrune::prune(HEGraph& g) {
+    OVD_TRACE_SCOPE("medial_axis_prune");
+    mag = extract_medial_axis(g);
+    Measure none = { 0, 0, 0, 0, 0, false, false };
+    measure.assign( mag.num_branches(), none );
+    std::vector<unsigned int> degree( mag.num_nodes() ); // number of branches not pruned
+    std::vector<double> burn( mag.num_nodes(), 0 );      // burn time: the clearance of an end-point
+    for (unsigned int n=0;n<mag.num_nodes();n++) {
+        degree[n] = mag.degree(n);
+        if ( degree[n] == 1 )
+            burn[n] = mag.nodes[n].clearance;
+    }
+    std::vector<char> done( mag.num_branches(), false ); // measured, or the last branch of a component
+    std::queue< std::pair<unsigned int, unsigned int> > leaves; // (branch, end-point)
+    for (unsigned int b=0;b<mag.num_branches();b++) {
+        if ( degree[ mag.branches[b].source ] == 1 )
+            leaves.push( std::make_pair( b, mag.branches[b].source ) );
+        if ( degree[ mag.branches[b].target ] == 1 )
+            leaves.push( std::make_pair( b, mag.branches[b].target ) );
+    }
+    unsigned int pruned = 0;
+    while ( !leaves.empty() ) {
+        unsigned int b = leaves.front().first;
+        unsigned int leaf = leaves.front().second;
+        leaves.pop();
+        if ( done[b] )
+            continue;
+        done[b] = true;
+        unsigned int junction = mag.other(b, leaf);
+        if ( degree[junction] == 1 ) // the last branch of the component
+            continue;
+        measure_branch(g, b, leaf, burn[leaf]);
+        if ( !insignificant( measure[b] ) )
+            continue;
+        measure[b].pruned = true;
+        pruned++;
+        for (unsigned int i=mag.branches[b].begin;i<mag.branches[b].end;i++) {
+            HEEdge e = mag.pieces[i].edge;
+            g[e].valid = false;
+            g[ g[e].twin ].valid = false;
+        }
+        degree[leaf]--;
+        degree[junction]--;
+        // the fire reaches the junction along this branch at the burn time of the leaf plus the length
+        burn[junction] = std::max( burn[junction], burn[leaf] + measure[b].length );
+        if ( degree[junction] == 1 ) { // the junction is now an end-point of its last branch
+            for (unsigned int i=mag.offsets[junction];i<mag.offsets[junction+1];i++) {
+                unsigned int next = mag.adjacency[i];
+                if ( !measure[next].pruned && !done[next] )
+                    leaves.push( std::make_pair( next, junction ) );
+            }
+        }
+    }
+    g.mark_changed();
+    return pruned;
+}
+
+} // end ovd namespace
+// end file medial_axis_prune.cpp
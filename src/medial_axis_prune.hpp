@@ -0,0 +1,89 @@
+/*
+ *  Copyright (c) 2010-2012 Anders Wallin (anders.e.e.wallin "at" gmail.com).
+ *
+ *  This file is part of Openvoronoi
+ *  (see https://github.com/aewallin/openvoronoi).
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <vector>
+
+#include "graph.hpp"
+#include "medial_axis_graph.hpp"
+
+namespace ovd
+{
+
+/// \brief remove insignificant branches from the medial-axis
+///
+/// medial_axis_filter keeps every branch that does not end between nearly parallel segments, so a noisy
+/// boundary leaves a short branch at each small bump. here the branches are pruned by their significance,
+/// from the leaves of the medial-axis inwards. a leaf branch, from an end-point to a junction, is measured by:
+/// - erosion thickness: the burn time at the junction, i.e. the burn time at the end-point (its clearance)
+///   plus the length of the branch, less the clearance at the junction.
+///   a branch from a small bump is not much longer than the growth of the clearance along it.
+/// - length ratio: the length of the branch over the clearance at the junction.
+/// - lambda: the largest distance between the two nearest boundary points, at the vertices of the branch.
+///   points with a smaller distance are not in the lambda-medial-axis.
+/// - object angle: the largest half-angle between the directions to the two nearest boundary points.
+///
+/// a leaf branch is pruned if any measure with a threshold is below it: its edges (and twins) are set invalid.
+/// when all but one branch at a junction are pruned, the junction becomes an end-point, with the latest burn time
+/// of the branches that reached it, and its last branch is measured in turn. so the measures are computed in one
+/// traversal of the medial-axis, from the leaves. the last branch of a component, and loops, are never pruned.
+///
+/// the graph should be filtered with medial_axis_filter first.
+class MedialAxisPrune {
+public:
+    /// the significance of a branch
+    struct Measure {
+        double length;   ///< length of the branch
+        double erosion;  ///< erosion thickness at the junction
+        double ratio;    ///< length over the clearance at the junction
+        double lambda;   ///< largest distance between the nearest boundary points
+        double angle;    ///< largest object angle, in radians
+        bool leaf;       ///< the branch was measured as a leaf branch
+        bool pruned;     ///< the branch was pruned
+    };
+    MedialAxisPrune() : erosion_threshold(0), ratio_threshold(0), lambda_threshold(0), angle_threshold(0) {}
+    /// prune leaf branches with an erosion thickness less than \a t
+    void set_erosion(double t) { erosion_threshold = t; }
+    /// prune leaf branches shorter than \a t times the clearance at their junction
+    void set_ratio(double t) { ratio_threshold = t; }
+    /// prune leaf branches where the nearest boundary points are closer together than \a t
+    void set_lambda(double t) { lambda_threshold = t; }
+    /// prune leaf branches with an object angle less than \a t radians
+    void set_angle(double t) { angle_threshold = t; }
+    /// \brief prune the medial-axis of \a g
+    /// \return the number of branches pruned
+    unsigned int prune(HEGraph& g);
+    /// the medial-axis before pruning
+    const MedialAxisGraph& graph() const { return mag; }
+    /// the measures of each branch of graph()
+    const std::vector<Measure>& measures() const { return measure; }
+private:
+    void measure_branch(HEGraph& g, unsigned int b, unsigned int leaf, double burn);
+    bool insignificant(const Measure& m) const;
+    double erosion_threshold; ///< smallest erosion thickness, or 0
+    double ratio_threshold;   ///< smallest length ratio, or 0
+    double lambda_threshold;  ///< smallest lambda, or 0
+    double angle_threshold;   ///< smallest object angle, or 0
+    MedialAxisGraph mag;          ///< the medial-axis
+    std::vector<Measure> measure; ///< the measures of each branch
+};
+
+} // end ovd namespace
+// end file medial_axis_prune.hpp
@@ -18,7 +18,12 @@
  *  along with this program. If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <algorithm>
+
+#include <boost/foreach.hpp>
+
 #include "medial_axis_walk.hpp"
+#include "trace.hpp"
 
 namespace ovd
 {
@@ -27,9 +32,15 @@ namespace ovd
 /// \brief add the given edge to the current list of edges.
 ///
 /// for line-edges we add only two endpoints
-/// for parabolic edges we add many points
+/// for parabolic, elliptic and hyperbolic edges we add many points
+/// with a tolerance set, EdgeSampler chooses the points
 void MedialAxisWalk::append_edge(MedialChain& chain, HEEdge edge)  {
     MedialPointList point_list; // the endpoints of each edge
+    if ( _chord_tolerance > 0 ) {
+        EdgeSampler( _chord_tolerance, _radius_tolerance ).sample( g, edge, point_list );
+        chain.push_back( point_list );
+        return;
+    }
     HEVertex v1 = g.source( edge );
     HEVertex v2 = g.target( edge );
     // these edge-types are drawn as a single line from source to target.
@@ -38,112 +49,295 @@ void MedialAxisWalk::append_edge(MedialChain& chain, HEEdge edge)  {
         MedialPoint pt2( g[v2].position, g[v2].dist() );
         point_list.push_back(pt1);
         point_list.push_back(pt2);
-    } else if ( (g[edge].type == PARABOLA) || (g[edge].type == LINE) ) { // these edge-types are drawn as polylines with _edge_points number of points
+    } else if ( (g[edge].type == PARABOLA) || (g[edge].type == LINE) ||
+                (g[edge].type == ELLIPSE) || (g[edge].type == HYPERBOLA) ) { // these edge-types are drawn as polylines with _edge_points number of points
         double t_src = g[v1].dist();
         double t_trg = g[v2].dist();
         double t_min = std::min(t_src,t_trg);
         double t_max = std::max(t_src,t_trg);
         
+        std::vector<double> t( std::max(_edge_points,0) );
         for (int n=0;n< _edge_points;n++) {
-            double t(0);
             if (t_src<=t_trg) // increasing t-value
-                t = t_min + ((t_max-t_min)/numeric::sq(_edge_points-1))*numeric::sq(n); // NOTE: quadratic t-dependece. More points at smaller t.
+                t[n] = t_min + ((t_max-t_min)/numeric::sq(_edge_points-1))*numeric::sq(n); // NOTE: quadratic t-dependece. More points at smaller t.
             else if (t_src>t_trg) { // decreasing t-value
                 int m = _edge_points-1-n; // m goes from (N-1)...0   as n goes from 0...(N-1)
-                t = t_min + ((t_max-t_min)/numeric::sq(_edge_points-1))*numeric::sq(m);
+                t[n] = t_min + ((t_max-t_min)/numeric::sq(_edge_points-1))*numeric::sq(m);
             }
-            Point p = g[edge].point(t);
-            MedialPoint pt( p, t );
-            point_list.push_back(pt);
         }
+        std::vector<Point> p( t.size() );
+        if ( !t.empty() )
+            g[edge].points( &t[0], t.size(), &p[0] ); // all points of the edge at once
+        for (unsigned int n=0;n<t.size();n++)
+            point_list.push_back( MedialPoint( p[n], t[n] ) );
     }
     chain.push_back( point_list );
 }
 
-/// we are at target(e). find the next suitable edge.
+/// \brief we are at target(e). find the next suitable edge.
+///
+/// along a loop of the medial axis the walk stays on the loop, and takes a branch only where
+/// no loop-edge is left. a branch (a bridge, not on any loop) ends at a vertex that still has a valid loop-edge,
+/// so that the loop is walked later from its own start-edge, see find_loop_start(). otherwise the first valid edge.
 /// \return true if a next-edge was found, false otherwise.
 bool MedialAxisWalk::next_edge(HEEdge e, HEEdge& next) {
     HEVertex trg = g.target(e);
-    EdgeVector out_edges = g.out_edges(trg);
-    
-    std::vector<HEEdge> valid_edges; // find all valid edges
-    BOOST_FOREACH( HEEdge oe, out_edges) {
-        if ( valid_next_edge(oe) ) {
-            valid_edges.push_back(oe);
+    HEEdge first = HEEdge();
+    bool found = false;
+    HEOutEdgeItr it, it_end;
+    for ( boost::tie(it, it_end) = g.out_edge_itr(trg); it != it_end; ++it ) {
+        if ( !valid_next_edge(*it) )
+            continue;
+        if ( !bridge[ number(*it) ] ) {
+            if ( bridge[ number(e) ] )
+                return false; // a branch ends where it meets a loop
+            next = *it;
+            return true;
+        }
+        if ( !found ) {
+            first = *it;
+            found = true;
         }
     }
-    if (!valid_edges.empty() ) {
-        next = valid_edges[0]; // return the first valid one
-        return true;
-    }
-    return false; 
+    next = first;
+    return found;
 }
-
     
 /// set edge and its twin invalid
 void MedialAxisWalk::set_invalid(HEEdge e) {
+    if ( valid_next_edge(e) ) {
+        g[e].valid = false;
+        remove_out_edge(e);
+    }
     g[e].valid = false;
-    if (g[e].twin != HEEdge()) {
-        g[ g[e].twin ].valid = false;
+    HEEdge twin = g[e].twin;
+    if (twin != HEEdge()) {
+        if ( valid_next_edge(twin) ) {
+            g[twin].valid = false;
+            remove_out_edge(twin);
+        }
+        g[twin].valid = false;
+    }
+}
+
+/// \brief update the degree of the source of \a e, which has just been set invalid
+///
+/// when one valid out-edge remains, it is a start-edge.
+void MedialAxisWalk::remove_out_edge(HEEdge e) {
+    if ( --degree[ source[ number(e) ] ] != 1 )
+        return;
+    HEOutEdgeItr it, it_end;
+    for ( boost::tie(it, it_end) = g.out_edge_itr( g.source(e) ); it != it_end; ++it ) {
+        if ( valid_next_edge(*it) ) {
+            starts.push( number(*it) );
+            return;
+        }
     }
 }
 
-/// loop through all edges and find an edge where we can start
-/// valid edges have a source-vertex with exactly one valid out-edge.
+/// the number of valid edge \a e
+unsigned int MedialAxisWalk::number(HEEdge e) const {
+    return edge_number[ g[e].index ];
+}
+
+/// \brief find an edge where we can start
+///
+/// the first start-edge on the worklist, i.e. a valid edge with a source-vertex that has exactly one valid out-edge.
+/// if there is none, a loop of the medial axis is left: see find_loop_start().
 bool MedialAxisWalk::find_start_edge(HEEdge& start) {
     start = HEEdge();
-    BOOST_FOREACH(HEEdge e, g.edges() ) { 
-        if ( valid_next_edge(e) ) {
-            if (degree_one_source(e)) { // for an o-shaped medial axis, this doesn't find a start-edge!
-                start = e;
-                return true;
-            }
+    while ( !starts.empty() ) {
+        // the source of a valid edge on the worklist still has degree one, as degrees only decrease
+        if ( valid_next_edge( edges[ starts.top() ] ) ) {
+            start = edges[ starts.top() ];
+            return true;
         }
+        starts.pop();
     }
-    
     // if we get here, there are no "dangling" edges where we can start.
     // but there might be an o-shaped feature which is un-machined.
-    EdgeVector valid_edges;
-    BOOST_FOREACH(HEEdge e, g.edges() ) { 
-        if ( valid_next_edge(e) ) {
-            valid_edges.push_back(e);
+    return find_loop_start(start);
+}
+
+/// \brief find an edge where we can start a loop of the medial axis
+///
+/// the start-edge of the loop with the smallest clearance at its start, that is still valid.
+/// the walk then starts with a shallow cut. if no such edge is left, the first valid edge.
+bool MedialAxisWalk::find_loop_start(HEEdge& start) {
+    while ( next_loop < loop_starts.size() ) {
+        unsigned int n = loop_starts[ next_loop ].second;
+        if ( valid_next_edge( edges[n] ) ) {
+            start = edges[n];
+            return true;
         }
+        next_loop++;
     }
-    // just return the first valid edge. (FIXME: better to start with a shallow cut, i.e. return the edge with the smallest clearance-disk?
-    if (!valid_edges.empty()) { // for an o-shaped medial axis, this doesn't find a start-edge!
-        start = valid_edges[0];
+    while ( first_valid < edges.size() && !valid_next_edge( edges[first_valid] ) )
+        first_valid++;
+    if ( first_valid < edges.size() ) {
+        start = edges[first_valid];
         return true;
     }
-    
-    
     return false;
 }
 
-/// check if the source of the edge is a valid starting-point for a path
-bool MedialAxisWalk::degree_one_source(HEEdge e) {
-    HEVertex src = g.source(e);
-    EdgeVector out_edges = g.out_edges(src);
-    int count(0);
-    BOOST_FOREACH( HEEdge oe, out_edges) {
-        if ( valid_next_edge(oe) ) {
-            count++;
+/// \brief find the loops of the medial axis, and a start-edge for each
+///
+/// one depth-first search over the valid edges, with the out-edges of vertex v in out_edge[ out_begin[v] ] ...
+/// out_edge[ out_begin[v+1]-1 ]. each edge to a vertex that is still on the search-path closes a loop,
+/// along the path back to that vertex. the vertices of the loop are scanned for the one with the smallest clearance,
+/// where the loop starts. of the two loop-edges from there, the walk takes the one along which the clearance grows
+/// more slowly, i.e. with the smaller increase in clearance over the chord-length, so that the tool engagement
+/// grows gently from the shallow start.
+///
+/// the same search finds the bridges, i.e. the edges that are on no loop: the tree-edge into w is a bridge
+/// when no edge from w or its descendants leads back above w (Tarjan's low-link).
+void MedialAxisWalk::find_loops(const std::vector<unsigned int>& out_begin, const std::vector<unsigned int>& out_edge) {
+    loop_starts.clear();
+    next_loop = 0;
+    const unsigned int NONE = 0xFFFFFFFF;
+    unsigned int n_edges = edges.size();
+    unsigned int n_vertices = out_begin.size()-1;
+    std::vector<unsigned int> twin( n_edges, NONE );
+    for (unsigned int n=0;n<n_edges;n++) {
+        HEEdge t = g[ edges[n] ].twin;
+        if ( t != HEEdge() && valid_next_edge(t) )
+            twin[n] = number(t);
+    }
+    std::vector<double> clearance( n_vertices );
+    std::vector<Point> position( n_vertices );
+    for (unsigned int v=0;v<n_vertices;v++) {
+        HEVertex vertex = g.source( edges[ out_edge[ out_begin[v] ] ] );
+        clearance[v] = g[vertex].dist();
+        position[v] = g[vertex].position;
+    }
+    std::vector<char> state( n_vertices, 0 );              // 0: not found, 1: on the search-path, 2: done
+    std::vector<unsigned int> parent( n_vertices, NONE );  // the edge by which the search reached each vertex
+    std::vector<unsigned int> next( out_begin.begin(), out_begin.end()-1 ); // the next out-edge to search
+    std::vector<unsigned int> order( n_vertices );         // the order in which the search found each vertex
+    std::vector<unsigned int> low( n_vertices );           // the earliest vertex reached from below each vertex
+    unsigned int found = 0;
+    bridge.assign( n_edges, 0 );
+    std::vector<unsigned int> path;
+    for (unsigned int root=0;root<n_vertices;root++) {
+        if ( state[root] )
+            continue;
+        state[root] = 1;
+        order[root] = low[root] = found++;
+        path.push_back(root);
+        while ( !path.empty() ) {
+            unsigned int v = path.back();
+            if ( next[v] == out_begin[v+1] ) {
+                state[v] = 2;
+                path.pop_back();
+                if ( parent[v] != NONE ) {
+                    unsigned int p = source[ parent[v] ];
+                    low[p] = std::min( low[p], low[v] );
+                    if ( low[v] > order[p] )
+                        bridge[ parent[v] ] = bridge[ twin[ parent[v] ] ] = 1;
+                }
+                continue;
+            }
+            unsigned int h = out_edge[ next[v]++ ];
+            if ( twin[h] == NONE || ( parent[v] != NONE && twin[h] == parent[v] ) )
+                continue;
+            unsigned int w = source[ twin[h] ];
+            if ( state[w] == 0 ) {
+                state[w] = 1;
+                order[w] = low[w] = found++;
+                parent[w] = h;
+                path.push_back(w);
+            } else if ( state[w] == 1 ) {
+                low[v] = std::min( low[v], order[w] );
+                // the loop from w along the search-path to v, and back to w along h.
+                // scan it for the smallest clearance, with the loop-edges in and out of each vertex.
+                unsigned int min_out = h, min_in = parent[v];
+                unsigned int u = v, out_h = h;
+                while (true) {
+                    unsigned int in_h = ( u == w ) ? h : parent[u];
+                    if ( clearance[u] < clearance[ source[min_out] ] ) {
+                        min_out = out_h;
+                        min_in = in_h;
+                    }
+                    if ( u == w )
+                        break;
+                    out_h = in_h;
+                    u = source[in_h];
+                }
+                unsigned int m = source[min_out];
+                unsigned int forward = min_out;
+                unsigned int backward = twin[min_in];
+                unsigned int t_fwd = source[ twin[forward] ];
+                unsigned int t_bwd = source[ twin[backward] ];
+                double d_fwd = ( position[t_fwd] - position[m] ).norm();
+                double d_bwd = ( position[t_bwd] - position[m] ).norm();
+                double rise_fwd = clearance[t_fwd] - clearance[m];
+                double rise_bwd = clearance[t_bwd] - clearance[m];
+                // compare rise_fwd/d_fwd with rise_bwd/d_bwd, without dividing by a zero chord
+                unsigned int s = ( rise_bwd*d_fwd < rise_fwd*d_bwd ) ? backward : forward;
+                loop_starts.push_back( std::make_pair( clearance[m], s ) );
+            }
+        }
+    }
+    std::sort( loop_starts.begin(), loop_starts.end() );
+}
+
+/// \brief number the valid edges in edge-list order, count the valid out-edges of each vertex, and find the start-edges
+///
+/// the number of each edge is kept by its EdgeProps::index, and the out-edges of each vertex
+/// are listed vertex by vertex, so this takes time proportional to the size of the graph.
+void MedialAxisWalk::number_edges() {
+    edges.clear();
+    edge_number.assign( g.num_edges(), 0 );
+    BOOST_FOREACH(HEEdge e, g.edges() ) { 
+        if ( valid_next_edge(e) ) {
+            edge_number[ g[e].index ] = edges.size();
+            edges.push_back(e);
+        }
+    }
+    source.resize( edges.size() );
+    degree.clear();
+    std::vector<unsigned int> out_begin; // first out-edge of each vertex in out_edge
+    std::vector<unsigned int> out_edge; // the out-edges of each vertex
+    out_edge.reserve( edges.size() );
+    BOOST_FOREACH(HEVertex v, g.vertices() ) {
+        unsigned int begin = out_edge.size();
+        HEOutEdgeItr it, it_end;
+        for ( boost::tie(it, it_end) = g.out_edge_itr(v); it != it_end; ++it ) {
+            if ( valid_next_edge(*it) ) {
+                source[ number(*it) ] = out_begin.size();
+                out_edge.push_back( number(*it) );
+            }
+        }
+        if ( out_edge.size() > begin ) {
+            out_begin.push_back(begin);
+            degree.push_back( out_edge.size()-begin );
         }
     }
-    return (count==1);
+    out_begin.push_back( out_edge.size() );
+    starts = std::priority_queue< unsigned int, std::vector<unsigned int>, std::greater<unsigned int> >();
+    for (unsigned int n=0;n<edges.size();n++) {
+        if ( degree[ source[n] ] == 1 )
+            starts.push(n);
+    }
+    first_valid = 0;
+    find_loops(out_begin, out_edge);
 }
 
-/// find start-edgem then walk
+/// find start-edge, then walk
 void MedialAxisWalk::do_walk() {
+    OVD_TRACE_SCOPE("medial_axis_walk");
     out = MedialChainList();
+    number_edges();
     HEEdge start = HEEdge();
     while( find_start_edge(start) ) { // find a suitable start-edge
         medial_axis_walk(start); // from the start-edge, walk as far as possible
     }
 }
 
-/// we can follow an edge if it is valid, and not a ::LINESITE or ::NULLEDGE
+/// we can follow an edge if it is valid, and not a ::LINESITE, ::ARCSITE or ::NULLEDGE
 bool MedialAxisWalk::valid_next_edge(HEEdge e) {
-    return ( (g[e].type != LINESITE) && (g[e].type !=NULLEDGE) && (g[e].valid) );
+    return ( (g[e].type != LINESITE) && (g[e].type != ARCSITE) && (g[e].type !=NULLEDGE) && (g[e].valid) );
 }
     
 /// start at source of Edge start, and walk as far as possible
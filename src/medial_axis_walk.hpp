@@ -22,28 +22,21 @@
 
 #include <string>
 #include <iostream>
+#include <vector>
+#include <queue>
+#include <functional>
 
 #include "graph.hpp"
 #include "common/numeric.hpp"
 #include "site.hpp"
+#include "edge_sampler.hpp"
 
 namespace ovd
 {
 
-/// \brief Medial-axis point and associated clearance-disc radius.
-struct MedialPoint {
-    Point p; ///< position
-    double clearance_radius; ///< clearance-disk radius
-    /// \param pi position
-    /// \param r radius
-    MedialPoint(Point pi, double r): p(pi), clearance_radius(r) {}
-};
-typedef std::list<MedialPoint> MedialPointList; ///< list of points on the medial-axis
 typedef std::list<MedialPointList> MedialChain; ///< a list of several lists
 typedef std::list<MedialChain> MedialChainList; ///< a list of lists
 
-// FIXME: MedialAxisWalk could probably be optimized to minimize rapid-traverses
-
 /// \brief Walk along the medial-axis edges of a voronoi-diagram.
 ///
 /// When we want a toolpath along the medial axis we first filter down the voronoi-diagram
@@ -53,13 +46,36 @@ typedef std::list<MedialChain> MedialChainList; ///< a list of lists
 /// Algorithm:
 /// - first find one valid edge that has a degree-1 vertex (i.e. a suitable start point for the path)
 /// - if there's only one choice for the next edge, go there
-/// - if there are two choices, take one of the choices
+/// - if there are two choices, take one of the choices. along a loop, stay on the loop.
+/// - a branch that meets a loop ends there, so the loop is walked from its own start
 /// - when done, find another valid start-edge.
+/// - when no degree-1 vertex is left, start a loop of the medial axis (e.g. an o-shaped medial axis)
+///   at its vertex with the smallest clearance-disk, in the direction where the clearance grows more slowly
+///
+/// Curved edges are sampled with a fixed number of points, or with EdgeSampler when
+/// a tolerance is set with set_tolerance().
+///
+/// The valid edges are numbered once, in the order of the edge-list of the graph, and the
+/// number of valid out-edges of each vertex is counted. The counts are updated as edges are walked,
+/// and edges from vertices whose count drops to one are put on a worklist, ordered by edge number.
+/// So a start-edge is found without a search through all edges, and the walk takes time
+/// proportional to the number of medial-axis edges (times the log of the worklist size).
+/// The chains are the same as with a search of the edge-list for each start-edge.
+/// The loops are found by one depth-first search when the edges are numbered, each with its start-edge.
+///
+/// The chains are output in the order they are found. ToolpathOrder reorders them to reduce the rapid-traverses.
 class MedialAxisWalk {
 public:
     /// \param gi vd-graph
     /// \param edge_pts subdivision for non-line edges
-    MedialAxisWalk(HEGraph& gi, int edge_pts = 20): g(gi), _edge_points(edge_pts) {}
+    MedialAxisWalk(HEGraph& gi, int edge_pts = 20): g(gi), _edge_points(edge_pts), _chord_tolerance(0), _radius_tolerance(0) {}
+    /// \brief sample edges with EdgeSampler, instead of with \a edge_pts points
+    /// \param chord_tolerance largest distance between an edge and its points, or 0 for the fixed sampling
+    /// \param radius_tolerance largest error in the interpolated clearance-disk radius, or 0 to ignore the radius
+    void set_tolerance(double chord_tolerance, double radius_tolerance = 0) {
+        _chord_tolerance = chord_tolerance;
+        _radius_tolerance = radius_tolerance;
+    }
 
     /// run algorithm
     MedialChainList walk() {
@@ -68,19 +84,35 @@ public:
     }
 protected:
     void do_walk();
+    void number_edges();
     void medial_axis_walk(HEEdge start);    
     bool valid_next_edge(HEEdge e);
-    bool degree_one_source(HEEdge e);
     void append_edge(MedialChain& chain, HEEdge edge);
     bool next_edge(HEEdge e, HEEdge& next);
     void set_invalid(HEEdge e);
+    void remove_out_edge(HEEdge e);
     bool find_start_edge(HEEdge& start);
+    bool find_loop_start(HEEdge& start);
     MedialChainList out; ///< output of algorithm
 private:
     MedialAxisWalk(); // don't use.
+    unsigned int number(HEEdge e) const;
+    void find_loops(const std::vector<unsigned int>& out_begin, const std::vector<unsigned int>& out_edge);
     HEGraph& g; ///< original graph
     int _edge_points; ///< number of points to subdivide parabolas (non-line edges).
-
+    double _chord_tolerance; ///< EdgeSampler chord tolerance, or 0
+    double _radius_tolerance; ///< EdgeSampler radius tolerance
+    std::vector<HEEdge> edges; ///< the valid edges, in edge-list order
+    std::vector<unsigned int> edge_number; ///< number of each valid edge, by EdgeProps::index
+    std::vector<unsigned int> source; ///< number of the source vertex of each valid edge
+    std::vector<unsigned int> degree; ///< number of valid out-edges of each vertex
+    /// valid edges from a vertex of degree one, smallest edge number first. may hold edges that have been walked.
+    std::priority_queue< unsigned int, std::vector<unsigned int>, std::greater<unsigned int> > starts;
+    unsigned int first_valid; ///< no valid edge has a smaller number
+    /// the clearance at the start and the start-edge of each loop, smallest clearance first
+    std::vector< std::pair<double, unsigned int> > loop_starts;
+    unsigned int next_loop; ///< no loop before this has a valid start-edge
+    std::vector<char> bridge; ///< for each valid edge, true if it is on no loop of the medial axis
 };
 
 } // end namespace
@@ -17,7 +17,12 @@
  *  You should have received a copy of the GNU Lesser General Public License
  *  along with this program. If not, see <http://www.gnu.org/licenses/>.
 */
+#include <algorithm>
+
+#include <boost/foreach.hpp>
+
 #include "offset.hpp"
+#include "trace.hpp"
 
 namespace ovd
 {
@@ -31,71 +36,257 @@ void Offset::print() {
 /// create offsets at offset distance \a t
 OffsetLoops Offset::offset(double t) {
     offset_list.clear();
-    set_flags(t);
-    HEFace start;
-    while (find_start_face(start)) // while there are faces that still require offsets
-        offset_loop_walk(start,t); // start on the face, and do an offset loop
-
+    OffsetLoopCollector collector(offset_list);
+    offset(t, collector);
     return offset_list;
 }
 
-/// find a suitable start face
-bool Offset::find_start_face(HEFace& start) {
-    for(HEFace f=0; f<g.num_faces() ; f++) {
-        if (face_done[f]==0 ) {
-            start=f;
-            return true;
+/// \brief create offsets at each of the offset distances \a ts
+///
+/// the result is identical to calling offset(t) for each t.
+/// each distance is a separate query of the FaceIntervalIndex, in the order of \a ts.
+/// a sweep over the faces sorted by clearance, with a set of active faces, would visit the same faces,
+/// but it needs \a ts sorted and pays for the active-set updates, while the index is kept between calls
+/// and also serves offset(t).
+/// \return one OffsetLoops for each distance, in the order of \a ts
+std::vector<OffsetLoops> Offset::offset(const std::vector<double>& ts) {
+    OVD_TRACE_SCOPE("offset_multi");
+    update_index();
+    std::vector<OffsetLoops> out( ts.size() );
+    for (unsigned int n=0;n<ts.size();n++) {
+        OffsetLoopCollector collector( out[n] );
+        candidates.clear();
+        index.query(ts[n], candidates);
+        offset_faces(candidates, ts[n], collector);
+    }
+    return out;
+}
+
+/// stream offsets at offset distance \a t to \a v
+void Offset::offset(double t, OffsetVisitor& v) {
+    OVD_TRACE_SCOPE("offset");
+    update_index();
+    candidates.clear();
+    index.query(t, candidates);
+    offset_faces(candidates, t, v);
+}
+
+/// \brief stream offsets at each of the offset distances \a ts to \a v
+///
+/// the loops of each distance are streamed in turn, in the order of \a ts
+void Offset::offset(const std::vector<double>& ts, OffsetVisitor& v) {
+    OVD_TRACE_SCOPE("offset_multi");
+    update_index();
+    for (unsigned int n=0;n<ts.size();n++) {
+        candidates.clear();
+        index.query(ts[n], candidates);
+        offset_faces(candidates, ts[n], v);
+    }
+}
+
+/// \brief rebuild the face-interval index, and the clearance cache if it is not shared,
+/// if the graph has changed since they were built
+///
+/// a shared cache must be rebuilt by its owner.
+void Offset::update_index() {
+    if ( cache == &own_cache && own_cache.stale(g) )
+        own_cache.build(g);
+    assert( !cache->stale(g) );
+    if ( index.stale(g) ) {
+        face_done.assign( cache->num_faces(), 1 );
+        face_multi.assign( cache->num_faces(), 0 );
+        edge_entered.assign( cache->num_edges(), 0 );
+        face_mark.assign( cache->num_faces(), 0 );
+        if (seeded)
+            flood_region();
+        build_index();
+    }
+}
+
+/// build the face-interval index, for the region if offsets are restricted to one
+void Offset::build_index() {
+    if (restricted)
+        index.build(*cache, region_faces);
+    else
+        index.build(*cache);
+}
+
+/// \brief produce offsets only on \a faces
+///
+/// loops that start on one of \a faces are followed through all faces they pass.
+void Offset::set_faces(const std::vector<HEFace>& faces) {
+    region_faces = faces;
+    restricted = true;
+    seeded = false;
+    if ( index.stale(g) )
+        update_index();
+    else
+        build_index();
+}
+
+/// \brief produce offsets only on the faces connected to \a seed through faces with all edges valid
+///
+/// the region is found again if the graph changes.
+/// with a filter that marks the inside of a pocket valid, the region of a face inside the pocket is the pocket.
+void Offset::set_region(HEFace seed) {
+    seed_face = seed;
+    restricted = true;
+    seeded = true;
+    if ( index.stale(g) ) {
+        update_index();
+    } else {
+        flood_region();
+        build_index();
+    }
+}
+
+/// produce offsets on all faces
+void Offset::clear_region() {
+    region_faces.clear();
+    restricted = false;
+    seeded = false;
+    if ( !index.stale(g) )
+        build_index();
+}
+
+/// set region_faces to the faces connected to seed_face, by a flood fill through faces with all edges valid
+void Offset::flood_region() {
+    region_faces.clear();
+    if ( !face_valid(seed_face) )
+        return;
+    region_faces.push_back(seed_face);
+    face_mark[seed_face] = 1;
+    for (unsigned int n=0; n<region_faces.size(); n++) {
+        HEFace f = region_faces[n];
+        for (unsigned int e = cache->begin(f); e < cache->end(f); e++) {
+            unsigned int twin = cache->edge(e).twin;
+            if ( twin == ClearanceCache::NO_EDGE )
+                continue;
+            HEFace adjacent = cache->edge(twin).face;
+            if ( !face_mark[adjacent] && face_valid(adjacent) ) {
+                face_mark[adjacent] = 1;
+                region_faces.push_back(adjacent);
+            }
+        }
+    }
+    BOOST_FOREACH(HEFace f, region_faces) {
+        face_mark[f] = 0;
+    }
+}
+
+/// true if all edges of face \a f are valid
+bool Offset::face_valid(HEFace f) {
+    for (unsigned int e = cache->begin(f); e < cache->end(f); e++) {
+        if ( !cache->edge(e).valid )
+            return false;
+    }
+    return true;
+}
+
+/// \brief produce offset loops at distance \a t on the candidate \a faces
+///
+/// \a faces are the faces whose clearance-interval contains t. those where an edge brackets t,
+/// and which have no invalid edges, require an offset. loops are started from these faces
+/// in increasing face order, and every face that a loop passes through is marked done.
+/// loops through faces that are passed more than once are then completed by offset_missed_loops().
+void Offset::offset_faces(std::vector<HEFace>& faces, double t, OffsetVisitor& v) {
+    std::sort( faces.begin(), faces.end() );
+    multi_faces.clear();
+    BOOST_FOREACH(HEFace f, faces) {
+        unsigned int passages = face_passages(f,t);
+        if ( passages > 0 )
+            face_done[f] = 0;
+        if ( passages > 1 ) {
+            multi_faces.push_back(f);
+            face_multi[f] = 1;
         }
     }
-    return false;
+    BOOST_FOREACH(HEFace f, faces) {
+        if ( face_done[f]==0 )
+            offset_loop_walk(f,t,v);
+    }
+    offset_missed_loops(t,v);
+}
+
+/// \brief walk the loops that offset_faces() missed
+///
+/// a face that more than one loop passes through (a non-convex face, or a point-site face that the offset
+/// circle cuts in two) is marked done by the first of these loops. here a loop is walked from each edge
+/// of these faces where a loop enters the face, but no loop has entered it yet.
+/// multi_faces and face_multi must be set, and edge_entered set for the edges entered so far.
+/// face_multi and edge_entered are cleared.
+void Offset::offset_missed_loops(double t, OffsetVisitor& v) {
+    BOOST_FOREACH(HEFace f, multi_faces) {
+        for (unsigned int e = cache->begin(f); e < cache->end(f); e++) {
+            if ( cache->edge(e).increasing(t) && !edge_entered[e] )
+                offset_edge_walk(e,t,v);
+        }
+    }
+    BOOST_FOREACH(HEFace f, multi_faces) {
+        face_multi[f] = 0;
+        for (unsigned int e = cache->begin(f); e < cache->end(f); e++)
+            edge_entered[e] = 0;
+    }
 }
 
 /// perform an offset walk at given distance \a t,
 /// starting at the given face
-void Offset::offset_loop_walk(HEFace start, double t) {
+void Offset::offset_loop_walk(HEFace start, double t, OffsetVisitor& v) {
     //std::cout << " offset_walk() starting on face " << start << "\n";
+    offset_edge_walk( find_next_offset_edge( cache->begin(start), t, false), t, v ); // the first edge on the start-face
+}
+
+/// perform an offset walk at given distance \a t,
+/// entering the face of ClearanceCache edge \a start_edge on that edge
+void Offset::offset_edge_walk(unsigned int start_edge, double t, OffsetVisitor& v) {
     bool out_in_mode= false; 
-    HEEdge start_edge =  find_next_offset_edge( g[start].edge , t, out_in_mode); // the first edge on the start-face
-    HEEdge current_edge = start_edge;
-    OffsetLoop loop; // store the output in this loop
-    loop.offset_distance = t;
-    OffsetVertex pt( g[current_edge].point(t) ); // add the first point to the loop.
-    loop.push_back( pt );
+    unsigned int current_edge = start_edge;
+    v.begin_loop(t);
+    Point previous = g[ cache->edge(current_edge).e ].point(t); // the first point of the loop
     do {
         out_in_mode = edge_mode(current_edge, t);
         // find the next edge
-        HEEdge next_edge = find_next_offset_edge( g[current_edge].next, t, out_in_mode); 
-        //std::cout << "offset-output: "; print_edge(current_edge); std::cout << " to "; print_edge(next_edge); std::cout << "\n";
-        HEFace current_face = g[current_edge].face;
-        loop.push_back( offset_element_from_face(current_face, current_edge, next_edge, t) );
-        face_done[current_face]=1; // although we may revisit current_face (if it is non-convex), it seems safe to mark it "done" here.
-        current_edge = g[next_edge].twin;
+        unsigned int next_edge = find_next_offset_edge( cache->edge(current_edge).next, t, out_in_mode); 
+        HEFace current_face = cache->edge(current_edge).face;
+        Point next = g[ cache->edge(next_edge).e ].point(t);
+        offset_element_from_face(current_face, previous, next, v);
+        previous = next;
+        face_done[current_face]=1; // we may revisit current_face (if it is non-convex), see offset_missed_loops()
+        if ( face_multi[current_face] )
+            edge_entered[current_edge] = 1;
+        current_edge = cache->edge(next_edge).twin;
     } while (current_edge != start_edge);
-    offset_list.push_back( loop ); // append the created loop to the output
+    v.end_loop();
 }
 
-
-/// return an offset-element corresponding to the current face
-OffsetVertex Offset::offset_element_from_face(HEFace current_face, HEEdge current_edge, HEEdge next_edge, double t) {
+/// \brief send the offset-element from \a p0 to \a p1 on the current face to \a v
+///
+/// a line-site gives a line, and point- and arc-sites give an arc centered on the site.
+void Offset::offset_element_from_face(HEFace current_face, const Point& p0, const Point& p1, OffsetVisitor& v) {
     Site* s = g[current_face].site;
-    Ofs* o = s->offset( g[current_edge].point(t), g[next_edge].point(t) ); // ask the Site for offset-geometry here.
-    bool cw(true);
-    if (!s->isLine() ) // point and arc-sites produce arc-offsets, for which cw must be set.
-        cw = find_cw( o->start(), o->center(), o->end() ); // figure out cw or ccw arcs?
-    // add offset to output
-    OffsetVertex offset_element( g[next_edge].point(t), o->radius(), o->center(), cw, current_face );
-    return offset_element;
+    if ( s->isLine() ) {
+        v.line(p0, p1, current_face);
+        return;
+    }
+    Point c( s->x(), s->y() ); // the point-site, or the center of the arc-site
+    bool cw;
+    if ( s->isArc() ) {
+        // the offset of an arc-site may sweep more than a half-circle, so find_cw() can't be used.
+        // the offset runs along the arc-site if the end is further along the arc than the start.
+        cw = s->cw();
+        if ( s->in_region_t_raw(p1) < s->in_region_t_raw(p0) )
+            cw = !cw;
+    } else {
+        cw = find_cw(p0, c, p1);
+    }
+    v.arc(p0, p1, c, (p0-c).norm(), cw, current_face);
 }
     
 /// \brief figure out mode (?)
-bool Offset::edge_mode(HEEdge e, double t) {
-    HEVertex src = g.source(e);
-    HEVertex trg = g.target(e);
-    double src_r = g[src].dist();
-    double trg_r = g[trg].dist();
-    if ( (src_r<t) && (t<trg_r) ) {
+bool Offset::edge_mode(unsigned int e, double t) {
+    if ( cache->edge(e).increasing(t) ) {
         return true;
-    } else if ((trg_r<t) && (t<src_r) ) {
+    } else if ( cache->edge(e).decreasing(t) ) {
         return false;
     } else {
         assert(0);
@@ -114,61 +305,54 @@ bool Offset::find_cw(Point start, Point center, Point end) {
 /// we can be in one of two modes.
 /// if mode==false then we are looking for an edge where src_t < t < trg_t
 /// if mode==true we are looning for an edge where       trg_t < t < src_t
-HEEdge Offset::find_next_offset_edge(HEEdge e, double t, bool mode) {
-    HEEdge start=e;
-    HEEdge current=start;
-    HEEdge ofs_edge=e;
+unsigned int Offset::find_next_offset_edge(unsigned int e, double t, bool mode) {
+    unsigned int start=e;
+    unsigned int current=start;
+    unsigned int ofs_edge=e;
     do {
-        HEVertex src = g.source(current);
-        HEVertex trg = g.target(current);
-        double src_r = g[src].dist();
-        double trg_r = g[trg].dist();
-        if ( !mode && (src_r<t) && (t<trg_r) ) {
+        const ClearanceCache::Edge& r = cache->edge(current);
+        if ( !mode && r.increasing(t) ) {
             ofs_edge = current;
             break;
-        } else if (mode && (trg_r<t) && (t<src_r) ) {
+        } else if ( mode && r.decreasing(t) ) {
             ofs_edge = current;
             break;
         }
-        current =g[current].next;
+        current = r.next;
     } while( current!=start );
     return ofs_edge;
 }
 
-/// go through all faces and set flag=0 if the face requires an offset.    
-void Offset::set_flags(double t) {
-    for(HEFace f=0; f<g.num_faces() ; f++) {
-        HEEdge start = g[f].edge;
-        HEEdge current = start;
-        do {
-            HEVertex src = g.source(current);
-            HEVertex trg = g.target(current);
-            double src_r = g[src].dist();
-            double trg_r = g[trg].dist();
-            if (t_bracket(src_r,trg_r,t)) {
-                if ( face_done[f] ) // if 1
-                    face_done[f] = 0; // , set to 0. this is a face that requires an offset!
-            }
-            current = g[current].next;
-        } while ( current!=start );
-    }
-        
-    // again go through faces again, and set flag=1 if any edge on the face is invalid
-    // this is required because an upstream filter will set valid=false on some edges, 
-    // but not all, on a face where we do not want offsets.
-    for(HEFace f=0; f<g.num_faces() ; f++) {
-        HEEdge start = g[f].edge;
-        HEEdge current = start;
-        do {
-            if ( !g[current].valid ) {
-                face_done[f] = 1; // don't offset faces with invalid edges
-            }
-            current = g[current].next;
-        } while ( current!=start );
+/// \brief true if face \a f requires an offset at distance \a t
+///
+/// an edge on the face must bracket t. faces with one or more invalid edges are not offset,
+/// because an upstream filter sets valid=false on some edges, but not all, on a face where we do not want offsets.
+bool Offset::face_needs_offset(HEFace f, double t) {
+    bool bracket = false;
+    for (unsigned int e = cache->begin(f); e < cache->end(f); e++) {
+        const ClearanceCache::Edge& r = cache->edge(e);
+        if ( !r.valid )
+            return false;
+        if ( t_bracket( r.src_t, r.trg_t, t ) )
+            bracket = true;
     }
-        //print_status();
+    return bracket;
 }
 
+/// \brief the number of times offsets at distance \a t pass through face \a f
+///
+/// this is the number of edges on the face where an offset enters the face, i.e. where the clearance
+/// increases past t. zero if the face does not need an offset, and at least one if it does.
+unsigned int Offset::face_passages(HEFace f, double t) {
+    if ( !face_needs_offset(f,t) )
+        return 0;
+    unsigned int n = 0;
+    for (unsigned int e = cache->begin(f); e < cache->end(f); e++) {
+        if ( cache->edge(e).increasing(t) )
+            n++;
+    }
+    return std::max(n, 1u);
+}
 
 /// is t in (a,b) ?
 bool Offset::t_bracket(double a, double b, double t) {
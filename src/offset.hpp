@@ -21,13 +21,29 @@
 
 #include <string>
 #include <iostream>
+#include <vector>
+#include <cmath>
 
 #include "graph.hpp"
 #include "site.hpp"
+#include "clearance_cache.hpp"
+#include "face_interval_index.hpp"
 
 namespace ovd
 {
 
+/// the angle of the arc from \a p0 to \a p1 around \a c, negative if \a cw
+inline double arc_sweep(const Point& p0, const Point& p1, const Point& c, bool cw) {
+    Point a = p0-c;
+    Point b = p1-c;
+    double s = atan2( a.cross(b), a.dot(b) );
+    if (cw && s > 0)
+        s -= 2*M_PI;
+    else if (!cw && s < 0)
+        s += 2*M_PI;
+    return s;
+}
+
 /// \brief Line- or arc-vertex of an offset curve.
 ///
 /// \todo this duplicates the idea of the Ofs class. Remove this or Ofs!
@@ -41,6 +57,10 @@ struct OffsetVertex {
     OffsetVertex(Point pi, double ri, Point ci, bool cwi, HEFace fi): p(pi), r(ri), c(ci), cw(cwi), f(fi) {}
     /// ctor
     OffsetVertex(Point pi): p(pi), r(-1.), cw(false), f(0) {}
+    /// length of the line or arc from \a start to p
+    double length(const Point& start) const {
+        return (r > 0) ? r*fabs( arc_sweep(start,p,c,cw) ) : (p-start).norm();
+    }
 };
 
 /// a single offset loop
@@ -54,6 +74,51 @@ struct OffsetLoop {
 /// multiple loops. the output of the algorithm
 typedef std::vector<OffsetLoop> OffsetLoops;
 
+/// \brief Receives offset loops from Offset, one element at a time.
+///
+/// for each loop, begin_loop() is called, then line() or arc() for each offset-element
+/// in order along the loop, then end_loop(). the end of each element is the start of the next,
+/// and the end of the last element is the start of the first.
+class OffsetVisitor {
+public:
+    virtual ~OffsetVisitor() {}
+    /// a new loop at offset distance \a t starts
+    virtual void begin_loop(double t) = 0;
+    /// line from \a p0 to \a p1, the offset of the line-site of face \a f
+    virtual void line(const Point& p0, const Point& p1, HEFace f) = 0;
+    /// arc from \a p0 to \a p1 with center \a c and radius \a r, the offset of the point- or arc-site of face \a f
+    virtual void arc(const Point& p0, const Point& p1, const Point& c, double r, bool cw, HEFace f) = 0;
+    /// the current loop is closed
+    virtual void end_loop() = 0;
+};
+
+/// \brief OffsetVisitor that appends each loop to an OffsetLoops
+class OffsetLoopCollector : public OffsetVisitor {
+public:
+    /// \param out loops are appended here
+    OffsetLoopCollector(OffsetLoops& out) : loops(out) {}
+    virtual void begin_loop(double t) {
+        loops.push_back( OffsetLoop() );
+        loops.back().offset_distance = t;
+    }
+    virtual void line(const Point& p0, const Point& p1, HEFace f) {
+        first_point(p0);
+        loops.back().push_back( OffsetVertex(p1, -1, Point(0,0), true, f) );
+    }
+    virtual void arc(const Point& p0, const Point& p1, const Point& c, double r, bool cw, HEFace f) {
+        first_point(p0);
+        loops.back().push_back( OffsetVertex(p1, r, c, cw, f) );
+    }
+    virtual void end_loop() {}
+private:
+    /// the first OffsetVertex of a loop is its start point
+    void first_point(const Point& p0) {
+        if ( loops.back().vertices.empty() )
+            loops.back().push_back( OffsetVertex(p0) );
+    }
+    OffsetLoops& loops; ///< output
+};
+
 /// \brief From a voronoi-diagram, generate offsets.
 ///
 /// an offset is always a closed loop.
@@ -67,34 +132,91 @@ typedef std::vector<OffsetLoop> OffsetLoops;
 /// voronoi-diagram. To produce offsets only inside or outside a given geometry,
 /// use a filter first. The filter sets the valid-property of edges, so that offsets
 /// are not produced on faces with one or more invalid edge.
+///
+/// Offsets can also be restricted to a list of faces with set_faces(), or to the region
+/// of valid faces around a seed face with set_region(), e.g. for a pocket that is a small part of
+/// a large diagram. Only loops that start on these faces are produced, and the work for each
+/// offset distance is proportional to the number of faces in the region.
+///
+/// The faces an offset at distance t can pass through are looked up in a FaceIntervalIndex,
+/// and the faces are walked in a ClearanceCache. Both are built on first use, and rebuilt
+/// when sites have been inserted into the diagram or a filter has been run.
+///
+/// Offsets are either returned as OffsetLoops, or streamed to an OffsetVisitor
+/// element by element, without storing them.
 class Offset {
 public:
     /// \param gi vd-graph
-    Offset(HEGraph& gi): g(gi) {
-        face_done.clear();
-        face_done.assign( g.num_faces(), 1 );
-    }
+    Offset(HEGraph& gi): g(gi), cache(&own_cache), restricted(false), seeded(false) { }
     /// print stats
     void print();
     /// create offsets at offset distance \a t
     OffsetLoops offset(double t);
+    /// create offsets at each of the offset distances \a ts
+    std::vector<OffsetLoops> offset(const std::vector<double>& ts);
+    /// stream offsets at offset distance \a t to \a v
+    void offset(double t, OffsetVisitor& v);
+    /// stream offsets at each of the offset distances \a ts to \a v
+    void offset(const std::vector<double>& ts, OffsetVisitor& v);
+    /// produce offsets only on \a faces
+    void set_faces(const std::vector<HEFace>& faces);
+    /// produce offsets only on the faces connected to \a seed through faces with all edges valid
+    void set_region(HEFace seed);
+    /// produce offsets on all faces
+    void clear_region();
+    /// the faces that offsets are restricted to. empty if they are not restricted
+    const std::vector<HEFace>& region() const { return region_faces; }
+    /// the clearance cache of the graph, e.g. to share with an OffsetSorter
+    const ClearanceCache& clearance_cache() {
+        update_index();
+        return *cache;
+    }
 protected:
-    bool find_start_face(HEFace& start);
-    void offset_loop_walk(HEFace start, double t);
-    OffsetVertex offset_element_from_face(HEFace current_face, HEEdge current_edge, HEEdge next_edge, double t);
-    bool edge_mode(HEEdge e, double t);
+    /// \param gi vd-graph
+    /// \param c clearance cache of \a gi, built by the caller
+    Offset(HEGraph& gi, const ClearanceCache& c): g(gi), cache(&c), restricted(false), seeded(false) { }
+    /// the vd-graph
+    const HEGraph& graph() const { return g; }
+    /// the clearance cache in use, as it is (clearance_cache() rebuilds it if the graph has changed)
+    const ClearanceCache& face_cache() const { return *cache; }
+    void update_index();
+    void build_index();
+    void flood_region();
+    bool face_valid(HEFace f);
+    void offset_faces(std::vector<HEFace>& faces, double t, OffsetVisitor& v);
+    void offset_loop_walk(HEFace start, double t, OffsetVisitor& v);
+    void offset_edge_walk(unsigned int start_edge, double t, OffsetVisitor& v);
+    void offset_missed_loops(double t, OffsetVisitor& v);
+    void offset_element_from_face(HEFace current_face, const Point& p0, const Point& p1, OffsetVisitor& v);
+    bool edge_mode(unsigned int e, double t);
     bool find_cw(Point start, Point center, Point end);
-    HEEdge find_next_offset_edge(HEEdge e, double t, bool mode);
-    void set_flags(double t);
+    unsigned int find_next_offset_edge(unsigned int e, double t, bool mode);
     bool t_bracket(double a, double b, double t);
+    bool face_needs_offset(HEFace f, double t);
+    unsigned int face_passages(HEFace f, double t);
     void print_status();
     
     OffsetLoops offset_list; ///< list of output offsets
+    std::vector<HEFace> candidates; ///< faces found in the index
+    /// hold a 0/1 flag for each face, indicating if an offset for this face has been produced or not.
+    std::vector<unsigned char> face_done;
+    /// 0/1 flag for each face, set during offset_faces() for faces in multi_faces
+    std::vector<unsigned char> face_multi;
+    std::vector<HEFace> multi_faces; ///< faces that more than one loop passes through
+    /// 0/1 flag for each ClearanceCache edge, set where a loop entered one of the multi_faces
+    std::vector<unsigned char> edge_entered;
 private:
     Offset(); // don't use.
     HEGraph& g; ///< vd-graph
-    /// hold a 0/1 flag for each face, indicating if an offset for this face has been produced or not.
-    std::vector<unsigned char> face_done;
+    const ClearanceCache* cache; ///< the edges of each face, with their clearance
+    ClearanceCache own_cache; ///< the cache, when it is not shared
+    std::vector<HEFace> region_faces; ///< faces that offsets are restricted to
+    bool restricted; ///< offsets are restricted to region_faces
+    bool seeded;     ///< region_faces is the region around seed_face
+    HEFace seed_face; ///< the seed of set_region()
+    std::vector<unsigned char> face_mark; ///< 0/1 flag for each face, used while finding the region
+    /// clearance-interval of each face, rebuilt when the graph changes
+    FaceIntervalIndex index;
 };
 
 
@@ -0,0 +1,128 @@
+/*
+ *  Copyright (c) 2010-2012 Anders Wallin (anders.e.e.wallin "at" gmail.com).
+ *
+ *  This file is part of Openvoronoi
+ *  (see https://github.com/aewallin/openvoronoi).
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <vector>
+#include <cmath>
+
+#include <boost/foreach.hpp>
+
+#include "offset.hpp"
+
+namespace ovd
+{
+
+/// \brief offset loops as polylines, in flat arrays
+///
+/// arcs are split into lines so that the distance between each line and its arc
+/// (the chord error) is at most the given tolerance.
+///
+/// all points are stored in one vector. loop n is the closed polyline
+/// points[ loop_start[n] ] ... points[ loop_start[n+1]-1 ], where the last point is equal to the first.
+///
+/// loops are added either by passing this OffsetVisitor to Offset::offset(), which writes the polylines
+/// while the loops are walked, or with add() from OffsetLoops, which first reserves the exact number of
+/// points from the arc angles.
+class OffsetPolylines : public OffsetVisitor {
+public:
+    /// \param tolerance largest distance between an arc and its lines
+    OffsetPolylines(double tolerance) : tol(tolerance) { loop_start.push_back(0); }
+    /// remove all loops
+    void clear() {
+        points.clear();
+        loop_start.assign(1,0);
+        distance.clear();
+    }
+    /// number of loops
+    std::size_t size() const { return distance.size(); }
+    /// add \a loops, with the storage reserved in advance
+    void add(const OffsetLoops& loops) {
+        std::size_t n = points.size();
+        BOOST_FOREACH(const OffsetLoop& loop, loops) {
+            Point previous = loop.vertices.front().p;
+            BOOST_FOREACH(const OffsetVertex& v, loop.vertices) {
+                n += (v.r > 0) ? arc_segments(previous, v.p, v.c, v.r, v.cw) : 1;
+                previous = v.p;
+            }
+        }
+        points.reserve(n);
+        loop_start.reserve( loop_start.size() + loops.size() );
+        distance.reserve( distance.size() + loops.size() );
+        BOOST_FOREACH(const OffsetLoop& loop, loops) {
+            begin_loop(loop.offset_distance);
+            Point previous = loop.vertices.front().p;
+            std::list<OffsetVertex>::const_iterator it = loop.vertices.begin();
+            for (++it; it != loop.vertices.end(); ++it) {
+                if (it->r > 0)
+                    arc(previous, it->p, it->c, it->r, it->cw, it->f);
+                else
+                    line(previous, it->p, it->f);
+                previous = it->p;
+            }
+            end_loop();
+        }
+    }
+    /// the number of lines for the arc from \a p0 to \a p1 around \a c
+    unsigned int arc_segments(const Point& p0, const Point& p1, const Point& c, double r, bool cw) const {
+        if ( r <= tol )
+            return 1;
+        double max_angle = 2*acos( 1 - tol/r ); // the chord error of a line over this angle is tol
+        return std::max( 1u, (unsigned int)ceil( fabs( arc_sweep(p0,p1,c,cw) ) / max_angle ) );
+    }
+
+    virtual void begin_loop(double t) {
+        distance.push_back(t);
+        first = true;
+    }
+    virtual void line(const Point& p0, const Point& p1, HEFace ) {
+        if (first)
+            start(p0);
+        points.push_back(p1);
+    }
+    virtual void arc(const Point& p0, const Point& p1, const Point& c, double r, bool cw, HEFace ) {
+        if (first)
+            start(p0);
+        unsigned int n = arc_segments(p0,p1,c,r,cw);
+        double a0 = atan2( p0.y-c.y, p0.x-c.x );
+        double step = arc_sweep(p0,p1,c,cw)/n;
+        for (unsigned int i=1;i<n;i++)
+            points.push_back( c + r*Point( cos(a0+i*step), sin(a0+i*step) ) );
+        points.push_back(p1);
+    }
+    virtual void end_loop() {
+        loop_start.push_back( points.size() );
+    }
+
+    std::vector<Point> points;           ///< the points of all loops
+    std::vector<std::size_t> loop_start; ///< index of the first point of each loop, and points.size() at the end
+    std::vector<double> distance;        ///< offset distance of each loop
+private:
+    OffsetPolylines(); // don't use.
+    /// the first point of a loop
+    void start(const Point& p0) {
+        points.push_back(p0);
+        first = false;
+    }
+    double tol;  ///< chord tolerance
+    bool first;  ///< no point has been written for the current loop
+};
+
+} // end ovd namespace
+// end file offset_polylines.hpp
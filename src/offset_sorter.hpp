@@ -22,6 +22,8 @@
 #include <string>
 #include <iostream>
 #include <fstream> // std::filebuf
+#include <vector>
+#include <algorithm>
 
 #include <boost/graph/adjacency_list.hpp>
 #include <boost/graph/graphviz.hpp>
@@ -29,34 +31,11 @@
 #include "graph.hpp"
 #include "site.hpp"
 #include "offset.hpp"
+#include "clearance_cache.hpp"
 
 namespace ovd
 {
 
-/*struct OffsetVertex {
-    Point p;  ///< position (start)
-    double r; ///< arc radius (line-vertex is indicated by radius of -1)
-    Point c;  ///< arc center
-    bool cw;  ///< clockwise (or not)
-    HEFace f; ///< corresponding face in the vd-graph
-    /// ctor
-    OffsetVertex(Point pi, double ri, Point ci, bool cwi, HEFace fi): p(pi), r(ri), c(ci), cw(cwi), f(fi) {}
-    /// ctor
-    OffsetVertex(Point pi): p(pi), r(-1.), cw(false), f(0) {}
-};
-
-/// a single offset loop
-struct OffsetLoop {
-    std::list<OffsetVertex> vertices;
-    double offset_distance;
-    void push_back(OffsetVertex v) {
-        vertices.push_back(v);
-    }
-};
-*/
-
-//typedef std::list<OffsetLoop> OffsetLoops;
-
 /// a graph for holding pocketing-loops.
 /// each vertex in this graph corresponds to an offset loop
 /// each edge corresponds a possible link between two loops
@@ -74,27 +53,6 @@ typedef boost::graph_traits<MachiningGraph>::edge_descriptor    MGEdge;
 /// vertex iterator for MachiningGraph
 typedef boost::graph_traits<MachiningGraph>::vertex_iterator   MGVertexItr;
 
-/// sort-predicate for sorting offset loops by offset distance
-class OffsetLoopCompare {
-public:
-    /// sort predicate
-    bool operator() (OffsetLoop l1, OffsetLoop l2) {
-        return (l1.offset_distance > l2.offset_distance);
-    }
-};
-
-/// pair offsetloop with the corresponding MachininGraph Vertex
-typedef std::pair<MGVertex,OffsetLoop> VertexOffsetLoop;
-
-/// predicate for sorting loops by offset-distance
-class VertexOffsetLoopCompare {
-public:
-    /// sort predicate
-    bool operator() (VertexOffsetLoop l1, VertexOffsetLoop l2) {
-        return (l1.second.offset_distance < l2.second.offset_distance);
-    }
-};
-
 /// for writing labels in graphviz-files
 template <class Name>
 class label_writer {
@@ -110,194 +68,172 @@ private:
     Name name; ///< graph that is written to file
 };
 
-/// this class sorts offset-loops into a MachiningGraph which should
-/// contain the loops in a sensible order for pocket machining
+/// \brief sorts offset-loops into a MachiningGraph
+///
+/// the MachiningGraph contains the loops in a sensible order for pocket machining.
+/// each loop is connected with an edge to the loops just outside it, i.e. the loops at the next
+/// smaller offset-distance that bound the same region.
+///
+/// nesting is found from the topology of the vd-graph, not from the geometry of the loops.
+/// the region where the clearance is larger than t is, in the vd-graph, the set of vertices with dist()>t
+/// joined by (valid) edges with dist()>t at both ends. each loop at t bounds one such region, and the region
+/// is found from a vd-edge that the loop crosses: its end with dist()>t is in the region.
+/// the regions are tracked with a union-find over vd-vertices, joining edges in order of decreasing clearance,
+/// so sorting L loops on a vd-graph with E edges takes O( (E+L) log(E+L) ) time.
+///
+/// a pocket without islands gives a tree. a region that also is bounded by islands has
+/// more than one loop just outside it, and these are all connected.
 class OffsetSorter {
 public:
-    OffsetSorter(HEGraph& gi): vdg(gi) {} ///< ctor
-    void add_loop(OffsetLoop l) { all_loops.push_back(l); } ///< add an OffsetLoop
-    /// sort offset loops
+    OffsetSorter(HEGraph& gi): vdg(gi), cache(&own_cache) {} ///< ctor
+    /// \param gi vd-graph
+    /// \param c clearance cache of \a gi, e.g. Offset::clearance_cache(), used while it is up to date
+    OffsetSorter(HEGraph& gi, const ClearanceCache& c): vdg(gi), cache(&c) {}
+    void add_loop(const OffsetLoop& l) { all_loops.push_back(l); } ///< add an OffsetLoop
+    /// add all \a loops
+    void add_loops(const OffsetLoops& loops) { all_loops.insert( all_loops.end(), loops.begin(), loops.end() ); }
+    /// \brief sort offset loops
+    ///
+    /// add the loops to the MachiningGraph in decreasing offset-distance order, i.e. max offset-distance
+    /// (innermost) loop first, and connect each loop to the loops just outside it.
     void sort_loops() {
-        // push loops to a set, so they come out in decreasing offset-distance order
-        // , i.e. max offset-distance (innermost) loop first.
-        BOOST_FOREACH( const OffsetLoop l, all_loops ) {
-            distance_sorted_loops.insert(l);
-        }
-
-        // go through the loops, in distance order, and add them as vertices to the MachiningGraph 
-        BOOST_FOREACH( OffsetLoop l, distance_sorted_loops ) {
-            std::cout << "MachiningGraph adding loop at " << l.offset_distance << "\n";
+        g.clear();
+        vertex_order.clear();
+        std::vector<unsigned int> order( all_loops.size() );
+        for (unsigned int n=0;n<order.size();n++)
+            order[n] = n;
+        std::stable_sort( order.begin(), order.end(), DecreasingDistance(all_loops) );
+        BOOST_FOREACH( unsigned int n, order ) {
             // each offset loop corresponds to a vertex in the machining-graph
             MGVertex new_vert = boost::add_vertex(g);
-            g[new_vert] = l;
+            g[new_vert] = all_loops[n];
             vertex_order.push_back( new_vert ); // output std::vector
         }
-        
-        // now add edges between vertices
-        BOOST_FOREACH( MGVertex v, vertex_order) {
-            std::cout << "connecting loop " << v << " at " << g[v].offset_distance << "\n";
-            connect_vertex(v); // attempt to connect the new vertex to existing vertices in the graph
+        if ( cache->stale(vdg) ) {
+            if ( own_cache.stale(vdg) )
+                own_cache.build(vdg);
+            cache = &own_cache;
         }
-        write_dotfile();
-    }
-    
-    /// try to connect the new vertex to existing vertices    
-    void connect_vertex(MGVertex v) {
-
-        std::vector< MGVertex > ext_loops; // loops outside the current one
-        double current_offset=0;
-        bool first = true;
-        
-        BOOST_FOREACH( MGVertex trg, vertex_order ) {
-            if ( (trg != v ) && (g[trg].offset_distance < g[v].offset_distance) ) { 
-                // don't connect to self, or to inside loops
-                if (first ) {
-                    current_offset = g[trg].offset_distance;
-                    first = false;
-                    std::cout << " first loop outside " << g[v].offset_distance << " is "  << current_offset << "\n";
-                }
-                // consider only loops just outside of the current one
-                if ( g[trg].offset_distance == current_offset ) {
-                    if ( inside(trg,v) ) {
-                        std::cout << "   connecting " << v << " -> " << trg <<  "\n";
-                        ext_loops.push_back( trg );
-                    }
-                }
+        std::vector<unsigned int> edges = edges_by_clearance();
+        std::vector<unsigned int> loop_vertex( vertex_order.size() );
+        for (unsigned int n=0;n<vertex_order.size();n++)
+            loop_vertex[n] = region_vertex( g[vertex_order[n]] );
+
+        // go through the distances in decreasing order. at each distance, join the edges above it,
+        // and connect the loops of the previous (larger) distance to the loops of this distance in the same region.
+        parent.resize( cache->num_vertices() );
+        for (unsigned int n=0;n<parent.size();n++)
+            parent[n] = n;
+        std::size_t next_edge = 0;
+        std::size_t inner_begin = 0, inner_end = 0; // loops at the previous distance
+        while ( inner_end < vertex_order.size() ) {
+            std::size_t begin = inner_end;
+            std::size_t end = begin;
+            double t = g[vertex_order[begin]].offset_distance;
+            while ( end < vertex_order.size() && g[vertex_order[end]].offset_distance == t )
+                end++;
+            while ( next_edge < edges.size() && cache->edge(edges[next_edge]).lo() > t ) {
+                join( cache->edge(edges[next_edge]).src, cache->edge(edges[next_edge]).trg );
+                next_edge++;
             }
-        }
-        
-        // go through the found loops and connect 
-        BOOST_FOREACH( MGVertex trg, ext_loops ) {
-            boost::add_edge(v,trg,g);
-        }
-    }
-    
-    /// return true if the in Vertex is interior to the out Vertex
-    bool inside(MGVertex out, MGVertex in) {
-        OffsetLoop in_loop = g[in];
-        OffsetLoop out_loop = g[out];
-        
-        std::vector<HEFace> in_loop_faces;
-        std::vector<HEFace> out_loop_faces;
-        
-        //std::cout << " " << in_loop.offset_distance << " in_loop faces: ";
-        bool first = true;
-        BOOST_FOREACH( OffsetVertex in_ofs_vert, in_loop.vertices ) {
-            if (first) {
-                first = false;
-            } else {
-                //std::cout << in_ofs_vert.f << " ";
-                in_loop_faces.push_back( in_ofs_vert.f );
-            }
-        }
-        //std::cout << "\n";
-        //std::cout << " " << out_loop.offset_distance << " out_loop faces: ";
-        first = true;
-        BOOST_FOREACH( OffsetVertex out_ofs_vert, out_loop.vertices ) {
-            if (first) {
-                first = false;
-            } else {
-                //std::cout << out_ofs_vert.f << " ";
-                out_loop_faces.push_back( out_ofs_vert.f );
+            std::vector< std::pair<unsigned int, MGVertex> > regions; // region of each loop at t
+            for (std::size_t n=begin;n<end;n++)
+                regions.push_back( std::make_pair( find( loop_vertex[n] ), vertex_order[n] ) );
+            std::sort( regions.begin(), regions.end() );
+            for (std::size_t n=inner_begin;n<inner_end;n++) {
+                unsigned int r = find( loop_vertex[n] );
+                std::vector< std::pair<unsigned int, MGVertex> >::iterator it =
+                    std::lower_bound( regions.begin(), regions.end(), std::make_pair(r, MGVertex(0)) );
+                for ( ; it != regions.end() && it->first == r ; ++it )
+                    boost::add_edge( vertex_order[n], it->second, g );
             }
+            inner_begin = begin;
+            inner_end = end;
         }
-        //std::cout << "\n";
-        
-        std::set<HEVertex> in_enclosed = loop_enclosed_vertices(in_loop_faces);
-        std::cout << "  IN " << in << " enclosed vertices: ";
-        BOOST_FOREACH(HEVertex tv, in_enclosed) {
-            std::cout << vdg[tv].index << " ";
-        }
-        std::cout << "\n";
-        
-        std::set<HEVertex> out_enclosed = loop_enclosed_vertices(out_loop_faces);
-        std::cout << "  OUT " << out << " enclosed vertices: ";
-        
-        BOOST_FOREACH(HEVertex tv, out_enclosed) {
-            std::cout << vdg[tv].index << " ";
-        }
-        std::cout << "\n";
-        
-        BOOST_FOREACH( HEVertex inv, in_enclosed) {
-            if ( out_enclosed.find( inv ) != out_enclosed.end() )
-                return true;
-        }
-        /*
-        BOOST_FOREACH( OffsetVertex in_ofs_vert, in_loop.vertices ) {
-            BOOST_FOREACH( OffsetVertex out_ofs_vert, out_loop.vertices ) {
-                if (in_ofs_vert.f!=0 && out_ofs_vert.f!=0 && in_ofs_vert.f == out_ofs_vert.f) {
-                    std::cout << "  Match!\n";
-                    return true;
-                }
-            }
-        } 
-        std::cout << "  NO Match!\n";
-        */
-        return false;
     }
+    /// the MachiningGraph built by sort_loops()
+    const MachiningGraph& graph() const { return g; }
+    /// the loops in the MachiningGraph, in decreasing offset-distance order
+    const std::vector<MGVertex>& loop_order() const { return vertex_order; }
 
-/// find the vd-vertices enclosed by the current offset loop
-std::set<HEVertex> loop_enclosed_vertices( std::vector<HEFace> in_loop_faces) {
-        std::vector< VertexVector > in_loop_vertices;
-        // now go through each in_loop face, and collect all interior vd-vertices
-        BOOST_FOREACH(HEFace f, in_loop_faces) {
-            VertexVector in_vertices = vdg.face_vertices(f);
-            in_loop_vertices.push_back(in_vertices);
-            //std::cout << " face " << f << " has " << in_vertices.size() << " vertices\n";
-        }
-        
-        std::set< HEVertex > in_loop_enclosed_vertices;
-        // now figure out which of the vertices are enclosed
-        for(unsigned int i=0;i<in_loop_vertices.size();++i) {
-            // i chooses the face we work on
-            // now choose a vertex
-            VertexVector test_face_verts = in_loop_vertices[i];
-            for (unsigned int iv=0;iv<in_loop_vertices[i].size();++iv) { 
-                HEVertex test_vert = test_face_verts[iv];
-                for(unsigned int j=0;j<in_loop_vertices.size();++j) { // choose first comp-face
-                    if ( j!=i ) {
-                        VertexVector comp1_face_verts = in_loop_vertices[j];
-                        for(unsigned int k=0;k<in_loop_vertices.size();++k) { // second comp-face
-                            if ( j!=k && i!=k ) {
-                                VertexVector comp2_face_verts = in_loop_vertices[k];
-                                // if we have three faces that each contains a Vertex then it is interior.
-                                bool comp1_ok=false;
-                                bool comp2_ok=false;
-                                BOOST_FOREACH(HEVertex comp1_vert, comp1_face_verts) {
-                                    if (test_vert == comp1_vert)
-                                        comp1_ok = true;
-                                }
-                                BOOST_FOREACH(HEVertex comp2_vert, comp2_face_verts) {
-                                    if (test_vert == comp2_vert)
-                                        comp2_ok = true;
-                                }
-                                if (comp1_ok && comp2_ok)
-                                    in_loop_enclosed_vertices.insert(test_vert);
-                            }
-                        }   
-                    }
-                }
-            }
-        }
-    //assert( !in_loop_enclosed_vertices.empty() );
-    return in_loop_enclosed_vertices;
-}    
     /// write the MachiningGraph to a .dot file for visualization
-    void write_dotfile() {        
+    void write_dotfile(std::string filename="test.dot") {
         std::filebuf fb;
-        fb.open ("test.dot",std::ios::out);
+        fb.open (filename.c_str(),std::ios::out);
         std::ostream out(&fb);
-        label_writer<MachiningGraph> lbl_wrt(g);
+        label_writer<const MachiningGraph&> lbl_wrt(g);
         boost::write_graphviz( out, g, lbl_wrt);
     }
        
 protected:
-    /// set of Loops, sorted by decreasing offset-distance
-    std::multiset<OffsetLoop, OffsetLoopCompare> distance_sorted_loops; 
+    /// sort-predicate for loop indices, by decreasing offset-distance
+    class DecreasingDistance {
+    public:
+        /// \param l the loops
+        DecreasingDistance(const OffsetLoops& l) : loops(l) {}
+        /// sort predicate
+        bool operator() (unsigned int a, unsigned int b) const {
+            return loops[a].offset_distance > loops[b].offset_distance;
+        }
+    private:
+        const OffsetLoops& loops; ///< the loops
+    };
+    /// the valid vd-edges (numbered in the ClearanceCache), sorted by decreasing smallest clearance
+    std::vector<unsigned int> edges_by_clearance() {
+        std::vector< std::pair<double, unsigned int> > sorted;
+        for (unsigned int e=0;e<cache->num_edges();e++) {
+            if ( cache->edge(e).valid )
+                sorted.push_back( std::make_pair( -cache->edge(e).lo(), e ) );
+        }
+        std::sort( sorted.begin(), sorted.end() );
+        std::vector<unsigned int> edges;
+        for (unsigned int n=0;n<sorted.size();n++)
+            edges.push_back( sorted[n].second );
+        return edges;
+    }
+    /// \brief the number of a vd-vertex in the region bounded by \a loop
+    ///
+    /// the first offset-element of the loop ends on an edge of its face that brackets the offset-distance.
+    /// the end of that edge with the larger clearance is in the region.
+    unsigned int region_vertex(const OffsetLoop& loop) {
+        std::list<OffsetVertex>::const_iterator first = loop.vertices.begin();
+        ++first;
+        double t = loop.offset_distance;
+        unsigned int best = cache->begin(first->f);
+        double best_error = -1;
+        for (unsigned int e = cache->begin(first->f); e < cache->end(first->f) && best_error != 0; e++) {
+            const ClearanceCache::Edge& r = cache->edge(e);
+            if ( r.lo() < t && t < r.hi() ) {
+                double error = ( vdg[r.e].point(t) - first->p ).norm();
+                if ( best_error < 0 || error < best_error ) {
+                    best = e;
+                    best_error = error;
+                }
+            }
+        }
+        const ClearanceCache::Edge& r = cache->edge(best);
+        return ( r.src_t > r.trg_t ) ? r.src : r.trg;
+    }
+    /// union-find root of \a n
+    unsigned int find(unsigned int n) {
+        while ( parent[n] != n ) {
+            parent[n] = parent[ parent[n] ]; // path halving
+            n = parent[n];
+        }
+        return n;
+    }
+    /// union-find join of \a a and \a b
+    void join(unsigned int a, unsigned int b) {
+        parent[ find(a) ] = find(b);
+    }
+
     std::vector<MGVertex> vertex_order; ///< the output of this algorithm, vertices in sorted order
     OffsetLoops all_loops; ///< all loops we deal with
     MachiningGraph g; ///< machining-graph constructed when this algorithm runs
     HEGraph& vdg; ///< vd-graph
+    const ClearanceCache* cache; ///< numbered vd-vertices and edges, with their clearance
+    ClearanceCache own_cache; ///< the cache, when it is not shared
+    std::vector<unsigned int> parent; ///< union-find parent of each vd-vertex
 };
 
 
@@ -0,0 +1,238 @@
+/*
+ *  Copyright (c) 2010-2012 Anders Wallin (anders.e.e.wallin "at" gmail.com).
+ *
+ *  This file is part of Openvoronoi
+ *  (see https://github.com/aewallin/openvoronoi).
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <algorithm>
+#include <thread>
+
+#include <boost/foreach.hpp>
+
+#include "parallel_offset.hpp"
+#include "run_tasks.hpp"
+#include "trace.hpp"
+
+namespace ovd
+{
+
+namespace {
+
+/// \brief an Offset used by one thread, that walks one loop at a time
+class LoopWalker : public Offset {
+public:
+    /// \param gi vd-graph
+    /// \param c clearance cache of \a gi, shared by all walkers
+    LoopWalker(HEGraph& gi, const ClearanceCache& c) : Offset(gi,c) {
+        face_done.assign( c.num_faces(), 1 );
+        face_multi.assign( c.num_faces(), 0 );
+        edge_entered.assign( c.num_edges(), 0 );
+    }
+    /// the number of times offsets at distance \a t pass through face \a f, zero if it requires no offset
+    unsigned int passages(HEFace f, double t) { return face_passages(f,t); }
+    /// walk the loop at distance \a t that starts on face \a f, into \a loop
+    void walk(HEFace f, double t, OffsetLoop& loop) {
+        offset_list.clear();
+        OffsetLoopCollector collector(offset_list);
+        offset_loop_walk(f,t,collector);
+        loop.vertices.swap( offset_list.back().vertices );
+        loop.offset_distance = t;
+    }
+    /// \brief append to \a loops the loops at distance \a t that were missed because they pass
+    /// through one of the \a multi faces after another loop
+    ///
+    /// the edges where \a loops enter these faces are found from the start-point of each offset-element.
+    void missed_loops(const std::vector<HEFace>& multi, OffsetLoops& loops, double t) {
+        multi_faces = multi;
+        BOOST_FOREACH(HEFace f, multi_faces) {
+            face_multi[f] = 1;
+        }
+        BOOST_FOREACH(const OffsetLoop& loop, loops) {
+            Point previous = loop.vertices.front().p;
+            std::list<OffsetVertex>::const_iterator it = loop.vertices.begin();
+            for (++it; it != loop.vertices.end(); ++it) {
+                if ( face_multi[it->f] )
+                    edge_entered[ entering_edge(it->f, previous, t) ] = 1;
+                previous = it->p;
+            }
+        }
+        OffsetLoopCollector collector(loops);
+        offset_missed_loops(t, collector);
+    }
+private:
+    /// the edge of face \a f, where the clearance increases past \a t, that is closest to \a p
+    unsigned int entering_edge(HEFace f, const Point& p, double t) {
+        const ClearanceCache& cache = face_cache();
+        unsigned int best = cache.begin(f);
+        double best_dist = -1;
+        for (unsigned int e = cache.begin(f); e < cache.end(f); e++) {
+            if ( cache.edge(e).increasing(t) ) {
+                double d = ( graph()[ cache.edge(e).e ].point(t) - p ).norm();
+                if ( best_dist < 0 || d < best_dist ) {
+                    best = e;
+                    best_dist = d;
+                }
+            }
+        }
+        return best;
+    }
+};
+
+/// set \a flags for all faces that \a loop passes through.
+/// (the first vertex is the start-point, and has no face)
+void set_flags(const OffsetLoop& loop, std::vector<unsigned char>& flags, unsigned char value) {
+    std::list<OffsetVertex>::const_iterator it = loop.vertices.begin();
+    for (++it; it != loop.vertices.end(); ++it)
+        flags[it->f] = value;
+}
+
+/// \brief loops walked by one task: a range of start-faces at one distance
+struct Task {
+    unsigned int n;              ///< index of the distance
+    std::size_t begin;           ///< first start-face
+    std::size_t end;             ///< one past the last start-face
+    std::vector<HEFace> starts;  ///< start-face of each walked loop, increasing
+    OffsetLoops loops;           ///< the walked loops
+};
+
+} // end anonymous namespace
+
+ParallelOffset::ParallelOffset(HEGraph& gi, unsigned int threads) : g(gi), _threads(threads) {
+    if (_threads == 0)
+        _threads = std::max( 1u, std::thread::hardware_concurrency() );
+}
+
+/// create offsets at offset distance \a t
+OffsetLoops ParallelOffset::offset(double t) {
+    return offset( std::vector<double>(1,t) ).front();
+}
+
+/// \brief create offsets at each of the offset distances \a ts
+///
+/// the result is identical to Offset::offset(ts).
+/// \return one OffsetLoops for each distance, in the order of \a ts
+std::vector<OffsetLoops> ParallelOffset::offset(const std::vector<double>& ts) {
+    OVD_TRACE_SCOPE("parallel_offset");
+    if ( cache.stale(g) ) {
+        cache.build(g);
+        index.build(cache);
+    }
+    std::vector<LoopWalker*> walkers;
+    std::vector< std::vector<unsigned char> > flags( _threads );
+    for (unsigned int i=0; i<_threads; i++)
+        walkers.push_back( new LoopWalker(g, cache) );
+
+    // the faces that require an offset at each distance, in increasing order
+    // and the faces that more than one loop passes through
+    std::vector< std::vector<HEFace> > starts( ts.size() );
+    std::vector< std::vector<HEFace> > multi( ts.size() );
+    auto find_starts = [&](std::size_t n, unsigned int thread) {
+        std::vector<HEFace> faces;
+        index.query(ts[n], faces);
+        std::sort( faces.begin(), faces.end() );
+        BOOST_FOREACH(HEFace f, faces) {
+            unsigned int passages = walkers[thread]->passages(f, ts[n]);
+            if ( passages > 0 )
+                starts[n].push_back(f);
+            if ( passages > 1 )
+                multi[n].push_back(f);
+        }
+    };
+    run_tasks( ts.size(), _threads, find_starts );
+
+    // split the start-faces of each distance into ranges, so that there are about as many tasks as threads
+    std::size_t ranges = ts.empty() ? 1 : (_threads + ts.size() - 1) / ts.size();
+    std::vector<Task> tasks;
+    std::vector<std::size_t> first_task( ts.size()+1 );
+    for (unsigned int n=0; n<ts.size(); n++) {
+        first_task[n] = tasks.size();
+        std::size_t size = (starts[n].size() + ranges - 1) / ranges;
+        for (std::size_t begin=0; begin < starts[n].size(); begin += size) {
+            Task task;
+            task.n = n;
+            task.begin = begin;
+            task.end = std::min( begin+size, starts[n].size() );
+            tasks.push_back(task);
+        }
+    }
+    first_task[ ts.size() ] = tasks.size();
+
+    // walk a loop from each start-face not yet visited by the same task
+    auto walk_range = [&](std::size_t k, unsigned int thread) {
+        Task& task = tasks[k];
+        double t = ts[task.n];
+        std::vector<unsigned char>& visited = flags[thread];
+        visited.resize( g.num_faces(), 0 );
+        for (std::size_t i = task.begin; i < task.end; i++) {
+            HEFace f = starts[task.n][i];
+            if ( visited[f] )
+                continue;
+            task.starts.push_back(f);
+            task.loops.push_back( OffsetLoop() );
+            walkers[thread]->walk(f, t, task.loops.back());
+            set_flags( task.loops.back(), visited, 1 );
+        }
+        BOOST_FOREACH(const OffsetLoop& loop, task.loops) {
+            set_flags(loop, visited, 0);
+        }
+    };
+    run_tasks( tasks.size(), _threads, walk_range );
+
+    // merge the loops of each distance, in the order Offset would walk them. a loop whose
+    // start-face was visited by an earlier loop is dropped. a start-face that its task skipped,
+    // because it was visited by a loop that is dropped here, is walked again.
+    std::vector<OffsetLoops> out( ts.size() );
+    auto merge = [&](std::size_t n, unsigned int thread) {
+        std::vector<unsigned char>& done = flags[thread];
+        done.resize( g.num_faces(), 0 );
+        std::size_t k = first_task[n];
+        std::size_t j = 0;
+        BOOST_FOREACH(HEFace f, starts[n]) {
+            while ( k < first_task[n+1] ) { // move to the first walked loop that starts at or after f
+                if ( j == tasks[k].starts.size() ) {
+                    k++;
+                    j = 0;
+                } else if ( tasks[k].starts[j] < f ) {
+                    j++;
+                } else {
+                    break;
+                }
+            }
+            if ( done[f] )
+                continue;
+            out[n].push_back( OffsetLoop() );
+            if ( k < first_task[n+1] && tasks[k].starts[j] == f )
+                out[n].back().vertices.swap( tasks[k].loops[j].vertices );
+            else
+                walkers[thread]->walk(f, ts[n], out[n].back());
+            out[n].back().offset_distance = ts[n];
+            set_flags( out[n].back(), done, 1 );
+        }
+        BOOST_FOREACH(const OffsetLoop& loop, out[n]) {
+            set_flags(loop, done, 0);
+        }
+        if ( !multi[n].empty() )
+            walkers[thread]->missed_loops( multi[n], out[n], ts[n] );
+    };
+    run_tasks( ts.size(), _threads, merge );
+
+    for (unsigned int i=0; i<walkers.size(); i++)
+        delete walkers[i];
+    return out;
+}
+
+} // end ovd namespace
+// end file parallel_offset.cpp
@@ -0,0 +1,66 @@
+/*
+ *  Copyright (c) 2010-2012 Anders Wallin (anders.e.e.wallin "at" gmail.com).
+ *
+ *  This file is part of Openvoronoi
+ *  (see https://github.com/aewallin/openvoronoi).
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <vector>
+
+#include "graph.hpp"
+#include "offset.hpp"
+#include "clearance_cache.hpp"
+#include "face_interval_index.hpp"
+
+namespace ovd
+{
+
+/// \brief Offsets computed on several threads.
+///
+/// The vd-graph and its ClearanceCache are only read, and shared by all threads. Each thread has its own
+/// Offset-walker and visited-flags for faces.
+///
+/// The work is split into tasks of one distance and a range of start-faces. If there are fewer
+/// distances than threads, the start-faces of each distance are split into several ranges.
+/// A task walks a loop from each of its start-faces that it has not already visited, so loops
+/// that pass through several ranges may be walked more than once. The loops of each distance are
+/// then merged in increasing start-face order, exactly as Offset visits them, so the output is
+/// identical to Offset::offset() regardless of the number of threads.
+///
+/// The graph must not be modified while offset() runs.
+class ParallelOffset {
+public:
+    /// \param gi vd-graph
+    /// \param threads number of threads, 0 for std::thread::hardware_concurrency()
+    ParallelOffset(HEGraph& gi, unsigned int threads=0);
+    /// create offsets at offset distance \a t
+    OffsetLoops offset(double t);
+    /// create offsets at each of the offset distances \a ts
+    std::vector<OffsetLoops> offset(const std::vector<double>& ts);
+    /// number of threads used
+    unsigned int num_threads() const { return _threads; }
+private:
+    ParallelOffset(); // don't use.
+    HEGraph& g; ///< vd-graph
+    ClearanceCache cache; ///< the edges of each face, rebuilt when the graph changes
+    /// clearance-interval of each face, rebuilt when the graph changes
+    FaceIntervalIndex index;
+    unsigned int _threads; ///< number of threads
+};
+
+} // end ovd namespace
+// end file parallel_offset.hpp
@@ -47,7 +47,7 @@ public:
     /// determine if an edge is valid or not
     virtual bool operator()(const HEEdge& e) const {
         
-        if ( (*g)[e].type == LINESITE || (*g)[e].type == NULLEDGE) 
+        if ( (*g)[e].type == LINESITE || (*g)[e].type == ARCSITE || (*g)[e].type == NULLEDGE) 
             return true;
         
         // if polygon inserted ccw  as (id1->id2), then the linesite should occur on valid faces as id1->id2
@@ -55,7 +55,7 @@ public:
         
         HEFace f = (*g)[e].face;
         Site* s = (*g)[f].site;
-        if ( s->isLine() && linesite_ccw(f) ) 
+        if ( (s->isLine() || s->isArc()) && linesite_ccw(f) ) 
             return true;
         else if ( s->isPoint() ) {
             //HEVertex site_vertex = s->vertex();
@@ -79,7 +79,7 @@ public:
         return false;
     }
 private:
-    /// on the face f, find the adjacent linesite
+    /// on the face f, find the adjacent linesite (or arcsite)
     HEEdge find_adjacent_linesite(  HEFace f ) const {
         HEEdge current = (*g)[f].edge;
         HEEdge start = current;
@@ -92,7 +92,7 @@ private:
                 //std::cout << " t= " << (*g)[ twin ].type << "\n";
                 
                 HEFace twf = (*g)[twin].face;
-                if ( (*g)[twf].site->isLine() ) {
+                if ( (*g)[twf].site->isLine() || (*g)[twf].site->isArc() ) {
                     //std::cout << "  returning: " << (*g)[ (*g).source(current) ].index << " - " << (*g)[ (*g).target(current) ].index << "\n";
                     return current;
                 }
@@ -105,13 +105,14 @@ private:
         
         return HEEdge();
     }
-    /// return true if linesite was inserted in the direction indicated by _side
+    /// return true if linesite (or arcsite) was inserted in the direction indicated by _side
     bool linesite_ccw(  HEFace f ) const {
         HEEdge current = (*g)[f].edge;
         HEEdge start = current;
         do {
-            if ( (_side && (*g)[current].type == LINESITE && (*g)[current].inserted_direction) ||
-                  (!_side && (*g)[current].type == LINESITE && !(*g)[current].inserted_direction)  )
+            bool site_edge = ( (*g)[current].type == LINESITE || (*g)[current].type == ARCSITE );
+            if ( (_side && site_edge && (*g)[current].inserted_direction) ||
+                  (!_side && site_edge && !(*g)[current].inserted_direction)  )
                 return true;
                 
             current = (*g)[current].next;
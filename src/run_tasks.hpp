@@ -0,0 +1,51 @@
+/*
+ *  Copyright (c) 2010-2012 Anders Wallin (anders.e.e.wallin "at" gmail.com).
+ *
+ *  This file is part of Openvoronoi
+ *  (see https://github.com/aewallin/openvoronoi).
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace ovd
+{
+
+/// \brief call work(task, thread) for tasks 0..n-1, on at most \a threads threads.
+///
+/// the tasks are handed out in increasing order, to whichever thread is free.
+/// thread 0 is the calling thread.
+template <class Work>
+void run_tasks(std::size_t n, unsigned int threads, Work& work) {
+    std::atomic<std::size_t> next(0);
+    std::vector<std::thread> pool;
+    unsigned int nt = std::max( 1u, (unsigned int)std::min<std::size_t>(threads, n) );
+    auto loop = [&work, &next, n](unsigned int i) {
+        for (std::size_t k = next++; k < n; k = next++)
+            work(k, i);
+    };
+    for (unsigned int i=1; i<nt; i++)
+        pool.push_back( std::thread(loop, i) );
+    loop(0);
+    for (unsigned int i=0; i<pool.size(); i++)
+        pool[i].join();
+}
+
+} // end ovd namespace
+// end file run_tasks.hpp
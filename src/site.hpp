@@ -273,7 +273,7 @@ public:
     /// true for LineSite
     bool is_linear() {return isLine(); }
     /// true for PointSite and ArcSite
-    bool is_quadratic() {return isPoint();}
+    bool is_quadratic() {return isPoint() || isArc();}
     /// x position
     virtual double x() const {
         std::cout << " WARNING: never call Site !\n";
@@ -496,91 +496,68 @@ private:
     Point _end; ///< end Point of LineSite
 };
 
-/// circular arc Site
+/// \brief circular arc Site
+///
+/// The arc runs from start() to end() around center(), clockwise if cw() is true.
+/// Like LineSite, an arc is inserted as two sites. The one with k()=+1 is on the
+/// outside (convex side) of the arc, where the clearance-disk grows with the radius of
+/// the offset circle. The one with k()=-1 is on the inside (concave side).
+/// Both sites have the same equation, the offset-direction is selected by eqp(k).
 class ArcSite : public Site {
 public:
     /// create arc-site
-    ArcSite( const Point& startpt, const Point& endpt, const Point& centr, bool dir) : 
-        _start(startpt), _end(endpt), _center(centr), _dir(dir) {
+    /// \param startpt start Point
+    /// \param endpt end Point
+    /// \param centr center Point
+    /// \param dir true for a clockwise arc
+    /// \param koff +1 for the outer side, -1 for the inner side of the arc
+    ArcSite( const Point& startpt, const Point& endpt, const Point& centr, bool dir, double koff=+1) : 
+        _start(startpt), _end(endpt), _center(centr), _dir(dir), _k(koff) {
         _radius = (_center - _start).norm();
         eq.q = true;
         eq.a = -2*_center.x;
         eq.b = -2*_center.y;
-        _k = 1;
-        eq.k = -2*_k*_radius; 
+        eq.k = -2*_radius; // (x-xc)^2 + (y-yc)^2 = (r+k*t)^2, k selected by eqp(k)
         eq.c = _center.x*_center.x + _center.y*_center.y - _radius*_radius;
+        e = HEEdge();
+        _sweep = angle(_start,_end);
+        if (_sweep == 0)
+            _sweep = 2*M_PI; // full circle
     }
     ~ArcSite() {}
-    virtual Ofs* offset(Point p1,Point p2) {return new ArcOfs(p1,p2,_center,-1); } //FIXME: radius
+    /// the offset of an arc is a concentric arc through \a p1 and \a p2
+    virtual Ofs* offset(Point p1,Point p2) {return new ArcOfs(p1,p2,_center,(p1-_center).norm()); }
     
+    /// true if \a p is in the wedge from the center through the arc.
+    /// the center itself is equidistant to the whole arc, and is in the region.
     virtual bool in_region(const Point& p) const {
-        /*
-        if (_dir) {
-            return p.is_right(_center,_start) && !p.is_right(_center,_end);
-        } else {
-            return !p.is_right(_center,_start) && p.is_right(_center,_end);
-        }
-        */
-        if (p==_center)
+        if ( (p-_center).norm() < 1e-7*_radius )
             return true;
-            
         double t = in_region_t(p);
         return ( (t>=0) && (t<=1) );
-        
     }
     
-    /// \todo fix arc-site in_region_t test!!
+    /// position of the projection of \a pt along the arc, 0 at start() and 1 at end()
     virtual double in_region_t(const Point& pt) const {
-        // projection onto circle
-        /*
-        Point cen_start = _start - _center;
-        Point cen_end   = _end - _center;
-        Point cen_pt = pt - _center;
-        Point proj = _center + ( _radius/cen_pt.norm())*cen_pt;
-        
-        double diangle_min,diangle_max;
-        if (!_dir) {
-            diangle_min = numeric::diangle( cen_start.x, cen_start.y );
-            diangle_max = numeric::diangle( cen_end.x, cen_end.y );
-        } else {
-            diangle_max = numeric::diangle( cen_start.x, cen_start.y );
-            diangle_min = numeric::diangle( cen_end.x, cen_end.y );
-        }
-        //double fuzz(0.01);
-        double diangle_pt = numeric::diangle(cen_pt.x, cen_pt.y);
-        */
-        double t = in_region_t_raw(pt); //(diangle_pt - diangle_min) / (diangle_max-diangle_min);
+        double t = in_region_t_raw(pt);
         double eps = 1e-7;
         if (fabs(t) < eps)  // rounding... UGLY
             t = 0.0;
         else if ( fabs(t-1.0) < eps )
             t = 1.0;
         return t;
-        
-        /// find t-value along arc
-        //return 0.5; // FIXME
     }
+    /// \details the angle from start() to \a pt, in the direction of the arc, divided by the arc sweep.
+    /// points outside the arc get t<0 if they are closer (in angle) to start() and t>1 if they are closer to end()
     virtual double in_region_t_raw(const Point& pt) const {
-        // projection onto circle
-        Point cen_start = _start - _center;
-        Point cen_end   = _end - _center;
-        Point cen_pt = pt - _center;
-        Point proj = _center + ( _radius/cen_pt.norm())*cen_pt;
-        
-        double diangle_min,diangle_max;
-        if (!_dir) {
-            diangle_min = numeric::diangle( cen_start.x, cen_start.y );
-            diangle_max = numeric::diangle( cen_end.x, cen_end.y );
-        } else {
-            diangle_max = numeric::diangle( cen_start.x, cen_start.y );
-            diangle_min = numeric::diangle( cen_end.x, cen_end.y );
-        }
-        //double fuzz(0.01);
-        double diangle_pt = numeric::diangle(cen_pt.x, cen_pt.y);
-        
-        double t = (diangle_pt - diangle_min) / (diangle_max-diangle_min);
-        return t;
-    }
+        if (pt == _center)
+            return 0.5;
+        double a = angle(_start,pt);
+        if ( a > _sweep + 0.5*(2*M_PI-_sweep) )
+            a -= 2*M_PI;
+        return a/_sweep;
+    }
+    /// closest point on the arc to \a p
     Point apex_point(const Point& p) {
         if (in_region(p))
             return projection_point(p);
@@ -591,8 +568,8 @@ public:
     virtual double x() const {return _center.x;}
     virtual double y() const {return _center.y;}
     virtual double r() const {return _radius;}
-    virtual double k() const {return _k;} // ?
-
+    virtual double k() const {return _k;}
+    virtual HEEdge edge() {return e;}
     
     virtual std::string str() const {return "ArcSite";}
     virtual std::string str2() const {
@@ -604,23 +581,37 @@ public:
         out.append( _center.str() );
         out.append( " cw=" );
         out.append( (_dir ? "1" : "0" ) );
-
+        out.append( " k=" );
+        out.append( (_k>0 ? "+1" : "-1" ) );
         return out;
     }
     HEEdge e; ///< edge_descriptor to ::ARCSITE pseudo-edge
     /// return start Point of ArcSite
-    const Point start() const {return _start;}
+    virtual const Point start() const {return _start;}
     /// return end Point of ArcSite
-    const Point end() const {return _end;}
+    virtual const Point end() const {return _end;}
     /// return center Point of ArcSite
-    Point center() {return _center;}
+    Point center() const {return _center;}
     /// return radius of ArcSite
-    double radius() {return _radius;}
+    double radius() const {return _radius;}
+    /// return the angle swept by the arc, in (0, 2*pi]
+    double sweep() const {return _sweep;}
     /// return true for CW ArcSite and false for CCW
-    bool cw() {return _dir;}
+    virtual bool cw() {return _dir;}
     inline virtual bool isArc() const  { return true;}
 
 private:
+    /// angle, in the direction of the arc and in [0, 2*pi), from \a p1 to \a p2 around the center
+    double angle(const Point& p1, const Point& p2) const {
+        Point u = p1 - _center;
+        Point v = p2 - _center;
+        double a = atan2( u.cross(v), u.dot(v) );
+        if (_dir)
+            a = -a;
+        if (a < 0)
+            a += 2*M_PI;
+        return a;
+    }
     /// projection of given Point onto the ArcSite
     Point projection_point(const Point& p) const {
         if ( p == _center ) {
@@ -646,7 +637,8 @@ private:
     Point _center; ///< center Point of arc
     bool _dir;     ///< CW or CCW direction flag
     double _radius;///< radius of arc
-    double _k; ///< offset-direction. +1 for enlarging, -1 for shrinking circle
+    double _k;     ///< offset-direction. +1 for the outer side, -1 for the inner side of the arc
+    double _sweep; ///< angle swept by the arc
 };
 
 
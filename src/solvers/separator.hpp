@@ -0,0 +1,86 @@
+/*
+ *  Copyright (c) 2010-2012 Anders Wallin (anders.e.e.wallin "at" gmail.com).
+ *  
+ *  This file is part of Openvoronoi 
+ *  (see https://github.com/aewallin/openvoronoi).
+ *  
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *  
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *  
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "common/point.hpp"
+#include "site.hpp"
+
+namespace ovd {
+namespace solvers {
+
+// A SEPARATOR is a straight edge from an endpoint e of a LineSite or ArcSite,
+// along which the clearance-disk touches both the endpoint and the LineSite/ArcSite.
+// Points on the separator are at
+//
+//  p = e + t*sv
+//
+// where the unit vector sv is the direction in which the offset of the site grows:
+//
+//  LineSite    a x + b y + c + k t = 0          sv = -k*(a,b)
+//  ArcSite     |p-c| = r + lambda*t             sv = lambda*(e-c)/r
+//
+// (for ArcSite the offset-equation has k = -2*lambda*r, see ArcSite)
+// Inserting p into the offset equation of a third site gives an equation that is linear in t:
+//
+//  PointSite   |p-p3|^2 = t^2               t = -|e-p3|^2 / (2*sv.(e-p3))
+//  LineSite    a3 x + b3 y + c3 + k3 t = 0  t = -(a3*ex+b3*ey+c3) / (a3*svx+b3*svy+k3)
+//  ArcSite     |p-c3| = r3 + lambda3*t      t = (r3^2-|e-c3|^2) / (2*(sv.(e-c3) - r3*lambda3))
+
+/// \brief direction of the ::SEPARATOR at the endpoint \a e of the LineSite or ArcSite \a s,
+/// on the side given by offset-direction \a k
+inline Point separator_direction(Site* s, double k, const Point& e) {
+    Eq<double> eq = s->eqp(k);
+    if (s->isLine())
+        return Point( -eq.k*eq.a, -eq.k*eq.b );
+    assert( s->isArc() );
+    Point dir = e - Point( s->x(), s->y() );
+    dir.normalize();
+    return (eq.k < 0 ? +1 : -1)*dir;
+}
+
+/// \brief find the offset-distance \a t where the separator \a e + t * \a sv is equidistant
+/// to the endpoint \a e and the Site \a s, on side \a k of \a s
+/// \return false if the separator is parallel to the offset of \a s, i.e. there is no solution
+inline bool separator_t(const Point& e, const Point& sv, Site* s, double k, double& t) {
+    double num, den;
+    if (s->isPoint()) {
+        Point w = e - s->position();
+        num = -w.dot(w);
+        den = 2*sv.dot(w);
+    } else if (s->isLine()) {
+        Eq<double> eq = s->eqp(k);
+        num = -( eq.a*e.x + eq.b*e.y + eq.c );
+        den = eq.a*sv.x + eq.b*sv.y + eq.k;
+    } else {
+        assert( s->isArc() );
+        double lambda = ( s->eqp(k).k < 0 ) ? +1 : -1;
+        Point w = e - Point( s->x(), s->y() );
+        num = s->r()*s->r() - w.dot(w);
+        den = 2*( sv.dot(w) - s->r()*lambda );
+    }
+    if ( !(fabs(den) > 0) )
+        return false;
+    t = num/den;
+    return true;
+}
+
+} // solvers
+} // ovd
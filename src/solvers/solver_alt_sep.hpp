@@ -22,6 +22,7 @@
 
 #include "common/point.hpp"
 #include "common/numeric.hpp"
+#include "solvers/separator.hpp"
 
 using namespace ovd::numeric; // sq() chop() determinant()
 
@@ -29,9 +30,9 @@ namespace ovd {
 namespace solvers {
     
 // this solver is called when we want to position a vertex on a SEPARATOR edge
-// a SEPARATOR edge exists between a LineSite and one of its PointSite end-points
-// the input sites are thus s1=LineSite and s2=PointSite  (if arcs are supported in the future then s1=ArcSite is possible)
-// s3 can be either a LineSite or a PointSite (of arcs are supported, s3=ArcSite is possible)
+// here the new site s3 (LineSite or ArcSite) forms a separator with s1 or s2, which is one of its
+// PointSite end-points. The vertex lies on the separator of s3, equidistant to the remaining third site,
+// which can be a PointSite, LineSite, or ArcSite (see separator.hpp for the ArcSite equations)
 //
 //  s1 (LineSite) offset eq. is     a1 x + b1 y + c1 + k1 t = 0   
 //  s2 (PointSite) offset eq. is    (x-x2)^2 + (y-y2)^2 = t^2     
@@ -84,18 +85,21 @@ int solve( Site* s1, double k1,
     if ( type == 0 ) {
         lsite = s3; lsite_k = k3;
         psite = s1; // psite_k = k1;    l3 / p1 form a separator
-        third_site = s2;      third_site_k = 1;
+        third_site = s2;      third_site_k = k2;
     } else if ( type == 1 ) {
         lsite = s3; lsite_k = k3;
         psite = s2; // psite_k = k2;    l3 / p2 form a separator
-        third_site = s1; third_site_k = 1; 
+        third_site = s1; third_site_k = k1; 
     } else {
         std::cout << "ALTSEPSolver FATAL ERROR! type not known.\n";
         exit(-1);
         return 0;
     }
+    // now we should have this:
+    assert( (lsite->isLine() || lsite->isArc()) && psite->isPoint() );
+
     // separator direction
-    Point sv = (k3 == - 1) ? Point(lsite->a(),lsite->b()) : Point(-lsite->a(),-lsite->b());
+    Point sv = separator_direction(lsite, lsite_k, psite->position() );
     
     if (debug && !silent) {
         std::cout << "ALTSEPSolver type="<< type <<"\n";
@@ -106,34 +110,12 @@ int solve( Site* s1, double k1,
         std::cout << " sv= " << sv << "\n";
     }
 
-    
-    // now we should have this:
-    assert( lsite->isLine() && psite->isPoint() );
-
     double tsln(0);
-
-    if ( third_site->isPoint() ) {
-        double dx = psite->x() - third_site->x();
-        double dy = psite->y() - third_site->y();
-        if ( fabs(2*( dx*sv.x+dy*sv.y  )) > 0 ) {
-            tsln = -(dx*dx+dy*dy) / (2*( dx*sv.x+dy*sv.y  )); // check for divide-by-zero?
-        } else {
-            //std::cout << " no solutions. (isPoint)\n";
-            return 0;
-        }
-    } else if (third_site->isLine()) {
-        if ( fabs(( sv.x*third_site->a() + sv.y*third_site->b() + third_site_k )) > 0 ) {
-            tsln = -(third_site->a()*psite->x()+third_site->b()*psite->y()+third_site->c()) / 
-                ( sv.x*third_site->a() + sv.y*third_site->b() + third_site_k );
-        } else {
-            //std::cout << " no solutions. (isLine)\n";
-            return 0;
-        }
-    } else {
-        assert(0);
-        exit(-1);
+    if ( !separator_t( psite->position(), sv, third_site, third_site_k, tsln ) ) {
+        //std::cout << " no solutions.\n";
+        return 0;
     }
-    Point psln = Point(psite->x(), psite->y() ) + tsln * sv;
+    Point psln = psite->position() + tsln * sv;
     slns.push_back( Solution( psln, tsln, k3 ) );
     return 1;
 }
@@ -22,6 +22,7 @@
 
 #include "common/point.hpp"
 #include "common/numeric.hpp"
+#include "solvers/separator.hpp"
 
 using namespace ovd::numeric; // sq() chop() determinant()
 
@@ -29,9 +30,9 @@ namespace ovd {
 namespace solvers {
     
 // this solver is called when we want to position a vertex on a SEPARATOR edge
-// a SEPARATOR edge exists between a LineSite and one of its PointSite end-points
-// the input sites are thus s1=LineSite and s2=PointSite  (if arcs are supported in the future then s1=ArcSite is possible)
-// s3 can be either a LineSite or a PointSite (of arcs are supported, s3=ArcSite is possible)
+// a SEPARATOR edge exists between a LineSite or ArcSite and one of its PointSite end-points
+// the input sites are thus s1=LineSite/ArcSite and s2=PointSite
+// s3 can be a LineSite or an ArcSite (see separator.hpp for the ArcSite equations)
 //
 //  s1 (LineSite) offset eq. is     a1 x + b1 y + c1 + k1 t = 0   (1)
 //  s2 (PointSite) offset eq. is    (x-x2)^2 + (y-y2)^2 = t^2     (2)
@@ -72,23 +73,24 @@ namespace solvers {
 class SEPSolver : public Solver {
 public:
 
-int solve( Site* s1, double ,
+int solve( Site* s1, double k1,
            Site* s2, double ,
            Site* s3, double k3, std::vector<Solution>& slns ) {
-    assert( s1->isLine() && s2->isPoint() );
-    assert( s3->isLine() ); // LineSites always inserted after PointSites. 
-                            // Thus we can only have s3=LineSite
-                            // or in the future s3 = ArcSite
+    assert( (s1->isLine() || s1->isArc()) && s2->isPoint() );
+    assert( s3->isLine() || s3->isArc() ); // LineSites always inserted after PointSites. 
+                                           // and ArcSites after LineSites
     if (debug) 
         std::cout << "SEPSolver.\n";
     
     // separator direction
-    Point sv(-s1->a(),-s1->b());
+    Point sv = separator_direction(s1, k1, s2->position() );
     if (debug) std::cout << " SEPSolver sv= "<< sv << "\n";
     
-    double tsln = -(s3->a()*s2->x()+s3->b()*s2->y()+s3->c()) / ( sv.x*s3->a() + sv.y*s3->b() + k3  );
+    double tsln(0);
+    if ( !separator_t( s2->position(), sv, s3, k3, tsln ) )
+        return 0;
 
-    Point psln = Point(s2->x(), s2->y() ) + tsln * sv;
+    Point psln = s2->position() + tsln * sv;
     slns.push_back( Solution( psln, tsln, k3 ) );
     return 1;
 }
@@ -1,5 +1,4 @@
-
-// OpenVoronoi polygon example
+// OpenVoronoi arc-site test
 
 #include <string>
 #include <iostream>
@@ -9,116 +8,275 @@
 #include "voronoidiagram.hpp"
 #include "version.hpp"
 #include "common/point.hpp"
+#include "polygon_interior_filter.hpp"
+#include "medial_axis_filter.hpp"
+#include "medial_axis_walk.hpp"
+#include "offset.hpp"
 #include "utility/vd2svg.hpp"
 
 #include <boost/foreach.hpp>
 
+/// signed angle from \a a to \a b around \a c, ccw if \a ccw is true, in (-2pi, 2pi)
+double sweep(ovd::Point a, ovd::Point b, ovd::Point c, bool ccw) {
+    ovd::Point u = a-c;
+    ovd::Point v = b-c;
+    double s = atan2( u.cross(v), u.dot(v) );
+    if (ccw && s<0)
+        s += 2*M_PI;
+    else if (!ccw && s>0)
+        s -= 2*M_PI;
+    return s;
+}
 
-int main(int /*argc*/,char** /*argv[]*/) {
+/// \brief a closed CCW polygon where each edge is a line or a circular arc
+struct ArcPolygon {
+    std::vector<ovd::Point> points; ///< vertices
+    std::vector<bool> arc;          ///< edge i, from point i to i+1, is an arc
+    std::vector<ovd::Point> center; ///< arc center
+    std::vector<bool> cw;           ///< arc direction
 
-    ovd::VoronoiDiagram* vd = new ovd::VoronoiDiagram(1);
-    std::string filename = "output.svg";
-    std::cout << "OpenVoronoi version: " << ovd::version() << "\n";
+    /// add a line-edge starting at \a p
+    void line(ovd::Point p) {
+        points.push_back(p); arc.push_back(false); center.push_back(ovd::Point(0,0)); cw.push_back(false);
+    }
+    /// add an arc-edge starting at \a p
+    void arc_edge(ovd::Point p, ovd::Point c, bool cw_arc) {
+        points.push_back(p); arc.push_back(true); center.push_back(c); cw.push_back(cw_arc);
+    }
+    /// area enclosed by the polygon
+    double area() const {
+        double a=0;
+        for (unsigned int i=0;i<points.size();i++) {
+            ovd::Point p1 = points[i];
+            ovd::Point p2 = points[ (i+1)%points.size() ];
+            a += 0.5*p1.cross(p2);
+            if (arc[i]) { // add or remove the circular segment between the chord and the arc
+                double r = (p1-center[i]).norm();
+                double s = sweep(p1,p2,center[i],!cw[i]);
+                a += 0.5*r*r*(s-sin(s));
+            }
+        }
+        return a;
+    }
+    /// length of the boundary
+    double perimeter() const {
+        double l=0;
+        for (unsigned int i=0;i<points.size();i++) {
+            ovd::Point p1 = points[i];
+            ovd::Point p2 = points[ (i+1)%points.size() ];
+            if (arc[i])
+                l += (p1-center[i]).norm()*fabs( sweep(p1,p2,center[i],!cw[i]) );
+            else
+                l += (p2-p1).norm();
+        }
+        return l;
+    }
+    /// insert into \a vd: points first, then lines, then arcs
+    void insert(ovd::VoronoiDiagram* vd) const {
+        std::vector<int> id;
+        BOOST_FOREACH(ovd::Point p, points) {
+            id.push_back( vd->insert_point_site(p) );
+        }
+        for (unsigned int i=0;i<points.size();i++) {
+            if (!arc[i])
+                vd->insert_line_site( id[i], id[(i+1)%points.size()] );
+        }
+        for (unsigned int i=0;i<points.size();i++) {
+            if (arc[i])
+                vd->insert_arc_site( id[i], id[(i+1)%points.size()], center[i], cw[i] );
+        }
+    }
+};
 
-    std::vector<int> id;
-    std::vector<ovd::Point> vertices;
-    /*       -----------------
-     *      /      arc        \
-     *     1                   0
-     *     |                   |
-     *     l3                  l1
-     *     |                   |
-     *     3-------l2----------2
-     * */
-    vertices.push_back( ovd::Point(0.1,0.1) );  // 0
-    vertices.push_back( ovd::Point(-0.1,0.1) ); // 1
-    vertices.push_back( ovd::Point(0.1,-0.1) ); // 2
-    vertices.push_back( ovd::Point(-0.1,-0.1) ); // 3
-
-    //vertices.push_back( ovd::Point(-0.03,-0.03) ); // 4?
-
-    // point-sites must be inserted first.
-    // insert_point_site() returns an int-handle that is used when inserting line-segments
-  //  BOOST_FOREACH(ovd::Point p, vertices ) {
-  //      id.push_back( vd->insert_point_site(p) );
-  //  }
-  //  if (!vd->check()) return -1;
-
-    /*
-    // now we insert line-segments
-    vd->insert_line_site(id[0],id[2]); // l1
-    if (!vd->check()) return -1;
-    vd->insert_line_site(id[3],id[2]); // l2
-    if (!vd->check()) return -1;
-    vd->insert_line_site(id[3],id[1]);
-    if (!vd->check()) return -1;
-
-    // then the arc
-    ovd::Point center(0,0);
-    vd->insert_arc_site( id[1], id[0] , center, true ); // ccw arc
-*/
-
-
-    //;circle ccw:1 radius:0.3103 s:-90 e:-9.46232 w:80.5377
-    //g0 x0.0808 y0.4821 ;Point
-    //g0x0.0808 y0.1718
-    //g3 x0.3869 y0.4311 i0 j0.3103
-
-    /*
-    int id1 = vd->insert_point_site(ovd::Point(0.0808,0.1718));
-    int id2 = vd->insert_point_site(ovd::Point(0.3869,0.4311));
-    // then the arc
-    ovd::Point center(0.0808,0.4821);
-    vd->debug_on();
-    vd->insert_arc_site( id1, id2 , center, false ); // ccw arc
-*/
-    /*
-    ;circle ccw:1 radius:0.0743773 s:27.3791 e:28.8791 w:1.5
-    g0 x0.0595 y0.1627 ;Point
-    g0x0.1255 y0.1969
-    g3 x0.1246 y0.1986 i-0.066 j-0.0342
-	*/
-    //int id0 = vd->insert_point_site(ovd::Point(0, 0));
-    double s=1;
-
-    ovd::Point p1(0.1255*s, 0.1969*s);
-    ovd::Point p2(0.1246*s, 0.1986*s);
-    ovd::Point p3(0, 0);
-    int id1 = vd->insert_point_site(p1);
-    int id2 = vd->insert_point_site(p2);
-    int id3 = vd->insert_point_site(p3);
-
-
-    // then the arc
-    ovd::Point center(0.0595*s, 0.1627*s);
-    vd->debug_on();
-    //vd->insert_line_site( id0, id1);
-    //vd->insert_line_site( id1, id2);
-    vd->insert_line_site( id1, id2);
-    vd->insert_line_site( id2, id3);
-    //vd->insert_arc_site( id1, id2 , center, true ); // cw arc
-    return 0;
-    std::cout << vd->print();
-    ovd::HEGraph& g = vd->get_graph_reference();
-    BOOST_FOREACH( ovd::HEEdge e, g.edges() ) {
-
-    	ovd::HEVertex src = g.source(e);
-    	ovd::HEVertex trg = g.target(e);
-    	ovd::Point src_p  = g[src].position;
-    	ovd::Point trg_p  = g[trg].position;
-
-    	if(p1==src_p && p2==trg_p) {
-    		std::cout << src_p<<trg_p;
-    		std::cout<<"huhu"<<std::endl;
-    		//g[e].type = ovd::ARCSITE;
-    	}
+/// regular n-gon where edges alternate between an outward arc, an inward arc and a line.
+/// \a h is the distance from the chord to the arc center, relative to the chord length
+ArcPolygon bulged_polygon(int n, double h, int pattern) {
+    ArcPolygon poly;
+    for (int i=0;i<n;i++) {
+        double a1 = 2*M_PI*i/n;
+        double a2 = 2*M_PI*(i+1)/n;
+        ovd::Point p1( 0.5*cos(a1), 0.5*sin(a1) );
+        ovd::Point p2( 0.5*cos(a2), 0.5*sin(a2) );
+        ovd::Point left = (p2-p1).xy_perp(); // points into the polygon
+        int type = (pattern==0) ? 0 : i%pattern; // 0: outward, 1: inward, 2: line
+        if (type==0)
+            poly.arc_edge( p1, 0.5*(p1+p2) + h*left, false );
+        else if (type==1)
+            poly.arc_edge( p1, 0.5*(p1+p2) - h*left, true );
+        else
+            poly.line( p1 );
+    }
+    return poly;
+}
 
+/// a \a w by \a h rectangle with its corners rounded by tangent arcs of radius \a r
+ArcPolygon rounded_rectangle(double w, double h, double r) {
+    ArcPolygon poly;
+    for (int i=0;i<4;i++) {
+        ovd::Point n( cos(M_PI/2*i), sin(M_PI/2*i) ); // outward normal of side i
+        ovd::Point m = n.xy_perp();                   // outward normal of the next side
+        ovd::Point half( 0.5*w-r, 0.5*h-r );
+        ovd::Point c_prev( (n.x-m.x)*half.x, (n.y-m.y)*half.y ); // corner center before side i
+        ovd::Point c( (n.x+m.x)*half.x, (n.y+m.y)*half.y );      // corner center after side i
+        poly.line( c_prev + r*n );
+        poly.arc_edge( c + r*n, c, false );
     }
+    return poly;
+}
+
+/// a slot of length \a l between the centers of its half-circle ends, of radius \a r
+ArcPolygon slot(double l, double r) {
+    ArcPolygon poly;
+    poly.line( ovd::Point(-0.5*l,-r) );
+    poly.arc_edge( ovd::Point(0.5*l,-r), ovd::Point(0.5*l,0), false );
+    poly.line( ovd::Point(0.5*l,r) );
+    poly.arc_edge( ovd::Point(-0.5*l,r), ovd::Point(-0.5*l,0), false );
+    return poly;
+}
 
-    std::cout << " Correctness-check: " << vd->check() << "\n";
-    std::cout << vd->print();
-    vd2svg(filename, vd);
+/// a 0.8 wide arch: a rectangle with its top replaced by an arc of radius 0.6,
+/// joined to the sides by fillets of radius 0.1 that are tangent to the sides and to the arc
+ArcPolygon arch() {
+    ArcPolygon poly;
+    poly.line( ovd::Point(-0.4,-0.3) );
+    poly.line( ovd::Point(0.4,-0.3) );
+    poly.arc_edge( ovd::Point(0.4,0.1), ovd::Point(0.3,0.1), false );
+    poly.arc_edge( ovd::Point(0.36,0.18), ovd::Point(0,-0.3), false );
+    poly.arc_edge( ovd::Point(-0.36,0.18), ovd::Point(-0.3,0.1), false );
+    poly.line( ovd::Point(-0.4,0.1) );
+    return poly;
+}
+
+/// signed area of an offset loop
+double loop_area(const ovd::OffsetLoop& loop) {
+    double a=0;
+    ovd::Point prev = loop.vertices.front().p;
+    BOOST_FOREACH(const ovd::OffsetVertex& v, loop.vertices) {
+        a += 0.5*prev.cross(v.p);
+        if (v.r > 0) {
+            double s = sweep(prev,v.p,v.c,!v.cw);
+            a += 0.5*v.r*v.r*(s-sin(s));
+        }
+        prev = v.p;
+    }
+    return a;
+}
 
+/// build the diagram of \a poly, check it, and check an interior offset and the medial axis.
+/// an interior offset at small distance \a d should enclose an area close to A - P*d.
+/// if \a ends is given, the medial axis should end at these points, e.g. at the centers of tangent arcs
+int test_polygon(std::string name, const ArcPolygon& poly, double d, const std::vector<ovd::Point>& ends = std::vector<ovd::Point>()) {
+    int failures = 0;
+    ovd::VoronoiDiagram* vd = new ovd::VoronoiDiagram(1);
+    vd->set_silent(true);
+    poly.insert(vd);
+    std::cout << name << ": " << vd->num_arc_sites() << " arcs, " << vd->num_vertices() << " vertices\n";
+    if (!vd->check()) {
+        std::cout << " ERROR: diagram check failed\n";
+        failures++;
+    }
+    vd2svg(name+".svg", vd);
+
+    ovd::polygon_interior_filter pi(true);
+    vd->filter(&pi);
+    ovd::Offset of( vd->get_graph_reference() );
+    ovd::OffsetLoops loops = of.offset(d);
+    double expected = poly.area() - poly.perimeter()*d;
+    int arcs = 0;
+    if (loops.size() != 1) {
+        std::cout << " ERROR: " << loops.size() << " offset loops, expected 1\n";
+        failures++;
+    } else {
+        double area = fabs( loop_area(loops[0]) );
+        std::cout << " offset area " << area << " expected " << expected << "\n";
+        if ( fabs(area-expected) > 0.05*poly.perimeter()*d ) {
+            std::cout << " ERROR: offset area\n";
+            failures++;
+        }
+        BOOST_FOREACH(const ovd::OffsetVertex& v, loops[0].vertices) {
+            if ( v.r > 0 && vd->get_graph_reference()[v.f].site->isArc() )
+                arcs++;
+        }
+        if (arcs==0) {
+            std::cout << " ERROR: no arc offsets\n";
+            failures++;
+        }
+    }
+
+    ovd::medial_axis_filter ma(0.9); // the corners of large_arc are at 143 degrees
+    vd->filter(&ma);
+    ovd::MedialAxisWalk walk( vd->get_graph_reference() );
+    ovd::MedialChainList chains = walk.walk();
+    if (chains.empty()) {
+        std::cout << " ERROR: no medial axis\n";
+        failures++;
+    }
+    BOOST_FOREACH(ovd::Point end, ends) {
+        bool found = false;
+        BOOST_FOREACH(const ovd::MedialChain& chain, chains) {
+            if ( (chain.front().front().p - end).norm() < 1e-6 || (chain.back().back().p - end).norm() < 1e-6 )
+                found = true;
+        }
+        if (!found) {
+            std::cout << " ERROR: the medial axis does not end at " << end << "\n";
+            failures++;
+        }
+    }
     delete vd;
-    return 0;
+    return failures;
+}
+
+// insert single arcs and polygons made of arcs and lines, and check the diagram,
+// interior offsets and the medial axis.
+int main(int /*argc*/,char** /*argv[]*/) {
+    std::cout << "OpenVoronoi version: " << ovd::version() << "\n";
+    int failures = 0;
+
+    // single arcs, smaller and larger than a half-circle, among point-sites
+    double sweeps[] = {0.5, 2.0, 4.5, -3.5};
+    for (int n=0;n<4;n++) {
+        ovd::VoronoiDiagram* vd = new ovd::VoronoiDiagram(1);
+        vd->set_silent(true);
+        ovd::Point c(0.05,-0.02);
+        double r = 0.3;
+        int id1 = vd->insert_point_site( c + r*ovd::Point(cos(0.2),sin(0.2)) );
+        int id2 = vd->insert_point_site( c + r*ovd::Point(cos(0.2+sweeps[n]),sin(0.2+sweeps[n])) );
+        for (int i=0;i<5;i++)
+            vd->insert_point_site( ovd::Point(0.5*cos(1.1+i*2.3),0.45*sin(0.7+i*1.9)) );
+        vd->insert_arc_site( id1, id2, c, sweeps[n]<0 );
+        if (!vd->check()) {
+            std::cout << " ERROR: single arc with sweep " << sweeps[n] << "\n";
+            failures++;
+        }
+        delete vd;
+    }
+
+    failures += test_polygon("outward", bulged_polygon(6,0.6,0), 0.01);
+    failures += test_polygon("alternating", bulged_polygon(8,0.8,2), 0.01);
+    failures += test_polygon("arc_line", bulged_polygon(8,0.4,3), 0.01);
+
+    // an arc larger than a half-circle, closed by a line
+    ArcPolygon pac;
+    pac.arc_edge( 0.4*ovd::Point(cos(-1.0),sin(-1.0)), ovd::Point(0,0), false );
+    pac.line( 0.4*ovd::Point(cos(4.0),sin(4.0)) );
+    failures += test_polygon("large_arc", pac, 0.01);
+
+    // tangent arcs, where the medial axis ends at the arc centers
+    double radii[] = {0.1, 0.05};
+    for (int n=0;n<2;n++) {
+        std::vector<ovd::Point> corners;
+        for (int i=0;i<4;i++)
+            corners.push_back( ovd::Point( (i%3 ? -1 : 1)*(0.4-radii[n]), (i<2 ? 1 : -1)*(0.25-radii[n]) ) );
+        failures += test_polygon("rounded_rectangle", rounded_rectangle(0.8,0.5,radii[n]), 0.01, corners);
+    }
+    std::vector<ovd::Point> slot_ends;
+    slot_ends.push_back( ovd::Point(0.3,0) );
+    slot_ends.push_back( ovd::Point(-0.3,0) );
+    failures += test_polygon("slot", slot(0.6,0.15), 0.01, slot_ends);
+    std::vector<ovd::Point> fillet_centers;
+    fillet_centers.push_back( ovd::Point(0.3,0.1) );
+    fillet_centers.push_back( ovd::Point(-0.3,0.1) );
+    failures += test_polygon("arch", arch(), 0.01, fillet_centers);
+
+    return failures;
 }
@@ -1,14 +1,565 @@
 
 #include <string>
 #include <iostream>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include <set>
+
+#include <boost/random/mersenne_twister.hpp>
+#include <boost/random/uniform_real_distribution.hpp>
 
 #include "medial_axis_filter.hpp"
 #include "medial_axis_walk.hpp"
+#include "medial_axis_pocket.hpp"
+#include "medial_axis_graph.hpp"
+#include "medial_axis_prune.hpp"
+#include "edge_sampler.hpp"
 #include "voronoidiagram.hpp"
 #include "polygon_interior_filter.hpp"
 #include "utility/vd2svg.hpp"
+#include "utility/polygon_generator.hpp"
 #include "version.hpp"
 
+/// \brief the walk of MedialAxisWalk, with a search through all edges for each start-edge
+///
+/// the reference for the chains of MedialAxisWalk. loops are started as in MedialAxisWalk, with find_loop_start().
+/// the bridges, the edges on no loop, are found by removing each edge in turn and searching for another way around it.
+class ReferenceWalk : public ovd::MedialAxisWalk {
+public:
+    ReferenceWalk(ovd::HEGraph& gi) : ovd::MedialAxisWalk(gi), g(gi) {}
+    ovd::MedialChainList walk() {
+        out = ovd::MedialChainList();
+        number_edges();
+        find_bridges();
+        ovd::HEEdge start;
+        while ( find_start(start) ) {
+            ovd::MedialChain chain;
+            append_edge(chain, start);
+            invalidate(start);
+            ovd::HEEdge next;
+            while ( find_next(start, next) ) {
+                append_edge(chain, next);
+                start = next;
+                invalidate(start);
+            }
+            out.push_back(chain);
+        }
+        return out;
+    }
+private:
+    void invalidate(ovd::HEEdge e) {
+        g[e].valid = false;
+        if ( g[e].twin != ovd::HEEdge() )
+            g[ g[e].twin ].valid = false;
+    }
+    /// true if \a w can be reached from \a v along valid edges
+    bool connected(ovd::HEVertex v, ovd::HEVertex w) {
+        std::set<ovd::HEVertex> found;
+        std::vector<ovd::HEVertex> stack(1, v);
+        found.insert(v);
+        while ( !stack.empty() ) {
+            ovd::HEVertex u = stack.back();
+            stack.pop_back();
+            if ( u == w )
+                return true;
+            BOOST_FOREACH( ovd::HEEdge oe, g.out_edges(u) ) {
+                if ( valid_next_edge(oe) && found.insert( g.target(oe) ).second )
+                    stack.push_back( g.target(oe) );
+            }
+        }
+        return false;
+    }
+    void find_bridges() {
+        bridge.assign( g.num_edges(), 0 );
+        BOOST_FOREACH( ovd::HEEdge e, g.edges() ) {
+            if ( !valid_next_edge(e) )
+                continue;
+            invalidate(e);
+            bridge[ g[e].index ] = !connected( g.source(e), g.target(e) );
+            g[e].valid = true;
+            g[ g[e].twin ].valid = true;
+        }
+    }
+    // along a loop take the first valid loop-edge, else the first valid edge. a branch ends at a loop.
+    bool find_next(ovd::HEEdge e, ovd::HEEdge& next) {
+        bool found = false;
+        BOOST_FOREACH( ovd::HEEdge oe, g.out_edges( g.target(e) ) ) {
+            if ( !valid_next_edge(oe) )
+                continue;
+            if ( !bridge[ g[oe].index ] ) {
+                next = oe;
+                return !bridge[ g[e].index ];
+            }
+            if ( !found ) {
+                next = oe;
+                found = true;
+            }
+        }
+        return found;
+    }
+    int degree(ovd::HEVertex v) {
+        int count = 0;
+        BOOST_FOREACH( ovd::HEEdge oe, g.out_edges(v) ) {
+            if ( valid_next_edge(oe) )
+                count++;
+        }
+        return count;
+    }
+    bool find_start(ovd::HEEdge& start) {
+        BOOST_FOREACH( ovd::HEEdge e, g.edges() ) {
+            if ( valid_next_edge(e) && degree( g.source(e) ) == 1 ) {
+                start = e;
+                return true;
+            }
+        }
+        return find_loop_start(start);
+    }
+    ovd::HEGraph& g;
+    std::vector<char> bridge; // by EdgeProps::index
+};
+
+/// true if the chains \a a and \a b are the same
+bool same_chains(const ovd::MedialChainList& a, const ovd::MedialChainList& b) {
+    if ( a.size() != b.size() )
+        return false;
+    ovd::MedialChainList::const_iterator ca = a.begin(), cb = b.begin();
+    for ( ; ca != a.end(); ++ca, ++cb ) {
+        if ( ca->size() != cb->size() )
+            return false;
+        ovd::MedialChain::const_iterator la = ca->begin(), lb = cb->begin();
+        for ( ; la != ca->end(); ++la, ++lb ) {
+            if ( la->size() != lb->size() )
+                return false;
+            ovd::MedialPointList::const_iterator pa = la->begin(), pb = lb->begin();
+            for ( ; pa != la->end(); ++pa, ++pb ) {
+                if ( !(pa->p == pb->p) || pa->clearance_radius != pb->clearance_radius )
+                    return false;
+            }
+        }
+    }
+    return true;
+}
+
+/// \brief compare the chains of MedialAxisWalk with ReferenceWalk, on random pockets with islands
+/// \return number of failures
+int compare_walks() {
+    int failures = 0;
+    for (unsigned int seed=1;seed<=4;seed++) {
+        ovd::PolygonGenerator gen(seed);
+        ovd::PolygonSet ps = gen.polygon( ovd::PolygonGenerator::STAR, 200, 6 );
+        ovd::VoronoiDiagram* vd = new ovd::VoronoiDiagram(1);
+        vd->set_silent(true);
+        ps.insert(vd);
+        ovd::polygon_interior_filter pi(true);
+        ovd::medial_axis_filter ma;
+        vd->filter(&pi);
+        vd->filter(&ma);
+        ReferenceWalk reference( vd->get_graph_reference() );
+        ovd::MedialChainList expected = reference.walk();
+        vd->filter_reset();
+        vd->filter(&pi);
+        vd->filter(&ma);
+        ovd::MedialAxisWalk maw( vd->get_graph_reference() );
+        ovd::MedialChainList chains = maw.walk();
+        std::cout << "seed " << seed << ": " << chains.size() << " chains\n";
+        if ( !same_chains(chains, expected) || chains.empty() ) {
+            std::cout << " ERROR: the chains differ from the reference walk, which has " << expected.size() << " chains\n";
+            failures++;
+        }
+        delete vd;
+    }
+    return failures;
+}
+
+/// distance from \a p to the polyline \a points, and in \a radius_error the clearance error at the closest point
+double polyline_distance(const ovd::MedialPointList& points, const ovd::MedialPoint& p, double& radius_error) {
+    double best = 1e99;
+    ovd::MedialPointList::const_iterator a = points.begin(), b = points.begin();
+    for (++b; b != points.end(); ++a, ++b) {
+        ovd::Point ab = b->p - a->p;
+        double u = ( ab.dot(ab) > 0 ) ? std::max( 0.0, std::min( 1.0, (p.p-a->p).dot(ab)/ab.dot(ab) ) ) : 0;
+        double d = ( p.p - (a->p + u*ab) ).norm();
+        if ( d < best ) {
+            best = d;
+            radius_error = fabs( p.clearance_radius - (a->clearance_radius + u*(b->clearance_radius-a->clearance_radius)) );
+        }
+    }
+    return best;
+}
+
+/// \brief sample the medial axis of random pockets with EdgeSampler, and compare with dense samples of each edge
+/// \return number of failures
+int check_sampler() {
+    int failures = 0;
+    for (unsigned int seed=1;seed<=3;seed++) {
+        // a fine tolerance, and a coarse one with long parts
+        double chord_tol = ( seed == 3 ) ? 1e-2 : 1e-4, radius_tol = chord_tol;
+        ovd::PolygonGenerator gen(seed);
+        ovd::PolygonSet ps = gen.polygon( ovd::PolygonGenerator::STAR, 200, 6 );
+        ovd::VoronoiDiagram* vd = new ovd::VoronoiDiagram(1);
+        vd->set_silent(true);
+        ps.insert(vd);
+        ovd::polygon_interior_filter pi(true);
+        ovd::medial_axis_filter ma;
+        vd->filter(&pi);
+        vd->filter(&ma);
+        ovd::HEGraph& g = vd->get_graph_reference();
+        ovd::EdgeSampler chord(chord_tol), both(chord_tol, radius_tol);
+        unsigned int n_chord = 0, n_both = 0, n_fixed = 0;
+        double max_chord = 0, max_radius = 0;
+        BOOST_FOREACH( ovd::HEEdge e, g.edges() ) {
+            if ( !g[e].valid || !ovd::EdgeSampler::evaluated( g[e].type ) )
+                continue;
+            ovd::MedialPointList a, b;
+            chord.sample(g, e, a);
+            both.sample(g, e, b);
+            n_chord += a.size();
+            n_both += b.size();
+            n_fixed += 20;
+            double t_src = g[ g.source(e) ].dist(), t_trg = g[ g.target(e) ].dist();
+            double t_min = std::min(t_src,t_trg), t_max = std::max(t_src,t_trg);
+            for (int n=0;n<=400;n++) {
+                double t = t_min + (t_max-t_min)*n*n/(400.0*400.0);
+                ovd::MedialPoint p( g[e].point(t), t );
+                double radius_error = 0;
+                max_chord = std::max( max_chord, polyline_distance(a, p, radius_error) );
+                polyline_distance(b, p, radius_error);
+                max_radius = std::max( max_radius, radius_error );
+            }
+        }
+        std::cout << "seed " << seed << ": " << n_fixed << " fixed points, " << n_chord << " with chord tolerance "
+                  << "(error " << max_chord << "), " << n_both << " with radius tolerance (error " << max_radius << ")\n";
+        if ( max_chord > chord_tol || max_radius > radius_tol || n_chord >= n_fixed ) {
+            std::cout << " ERROR: sampled edges outside the tolerance\n";
+            failures++;
+        }
+        delete vd;
+    }
+    return failures;
+}
+
+/// \brief compare EdgeProps::points() with EdgeProps::point(), on all edges of a random pocket
+/// \return number of failures
+int check_points() {
+    ovd::PolygonGenerator gen(5);
+    ovd::PolygonSet ps = gen.polygon( ovd::PolygonGenerator::STAR, 200, 6 );
+    ovd::VoronoiDiagram* vd = new ovd::VoronoiDiagram(1);
+    vd->set_silent(true);
+    ps.insert(vd);
+    ovd::HEGraph& g = vd->get_graph_reference();
+    int errors = 0, n_points = 0;
+    BOOST_FOREACH( ovd::HEEdge e, g.edges() ) {
+        if ( g[e].type == ovd::LINESITE || g[e].type == ovd::ARCSITE || g[e].type == ovd::NULLEDGE )
+            continue;
+        double t_src = g[ g.source(e) ].dist(), t_trg = g[ g.target(e) ].dist();
+        std::vector<double> t;
+        for (int n=0;n<11;n++) // an odd count, for the scalar tail after groups of four
+            t.push_back( t_src + (t_trg-t_src)*n/10.0 );
+        std::vector<ovd::Point> p( t.size() );
+        g[e].points( &t[0], t.size(), &p[0] );
+        for (unsigned int n=0;n<t.size();n++) {
+            ovd::Point q = g[e].point( t[n] );
+            if ( ( p[n] - q ).norm() > 1e-12*( 1 + q.norm() ) )
+                errors++;
+            n_points++;
+        }
+    }
+    delete vd;
+    std::cout << "EdgeProps::points(): " << n_points << " points, " << errors << " differ from EdgeProps::point()\n";
+    return (errors > 0) ? 1 : 0;
+}
+
+/// \brief a sheet of 3x3 separate random pockets, each with an island
+ovd::PolygonSet sheet() {
+    return ovd::PolygonGenerator::sheet(3, 3, 0.45, 0.2, 10, 60);
+}
+
+/// \brief compare medial_axis_pocket::run_parallel() with run(), on a sheet of separate pockets
+/// \return number of failures
+int check_parallel_pocket() {
+    ovd::PolygonSet ps = sheet();
+    ovd::VoronoiDiagram* vd = new ovd::VoronoiDiagram(1);
+    vd->set_silent(true);
+    ps.insert(vd);
+    ovd::polygon_interior_filter pi(true);
+    ovd::medial_axis_filter ma;
+    vd->filter(&pi);
+    vd->filter(&ma);
+    ovd::medial_axis_pocket sequential( vd->get_graph_reference() );
+    sequential.set_width(0.01);
+    sequential.run();
+    std::vector<ovd::medial_axis_pocket::MICList> expected = sequential.get_mic_components();
+    int failures = 0;
+    for (unsigned int threads=1;threads<=4;threads+=3) {
+        ovd::medial_axis_pocket parallel( vd->get_graph_reference() );
+        parallel.set_width(0.01);
+        parallel.run_parallel(threads);
+        std::vector<ovd::medial_axis_pocket::MICList> out = parallel.get_mic_components();
+        bool same = ( out.size() == expected.size() );
+        for (unsigned int n=0;n<out.size() && same;n++) {
+            same = ( out[n].size() == expected[n].size() );
+            for (unsigned int k=0;k<out[n].size() && same;k++)
+                same = ( out[n][k].c2 == expected[n][k].c2 && out[n][k].r2 == expected[n][k].r2 && out[n][k].new_branch == expected[n][k].new_branch );
+        }
+        std::cout << "run_parallel(" << threads << "): " << out.size() << " components\n";
+        if ( !same || out.size() < 9 ) {
+            std::cout << " ERROR: run_parallel() differs from run(), which has " << expected.size() << " components\n";
+            failures++;
+        }
+    }
+    delete vd;
+    return failures;
+}
+
+/// \brief check the cut-width of the MICs of medial_axis_pocket::run(), and that find_next_u() uses its fast paths
+/// \return number of failures
+int check_next_u() {
+    ovd::PolygonSet ps = sheet();
+    ovd::VoronoiDiagram* vd = new ovd::VoronoiDiagram(1);
+    vd->set_silent(true);
+    ps.insert(vd);
+    ovd::polygon_interior_filter pi(true);
+    ovd::medial_axis_filter ma;
+    vd->filter(&pi);
+    vd->filter(&ma);
+    double width = 0.01;
+    ovd::medial_axis_pocket map( vd->get_graph_reference() );
+    map.set_width(width);
+    map.run();
+    int errors = 0;
+    unsigned int n_mic = 0;
+    BOOST_FOREACH( const ovd::medial_axis_pocket::MICList& mics, map.get_mic_components() ) {
+        for (unsigned int n=1;n<mics.size();n++) { // the first MIC of a component has no previous MIC
+            const ovd::medial_axis_pocket::MIC& m = mics[n];
+            double w = (m.c2-m.c1).norm() + m.r2 - m.r1;
+            if ( fabs(w-width) > 1e-6*width )
+                errors++;
+            n_mic++;
+        }
+    }
+    ovd::medial_axis_pocket::SolverStats st = map.solver_stats();
+    std::cout << "find_next_u(): " << st.solves << " solves, " << st.closed_form << " closed-form, "
+              << st.bracketed << " bracketed, " << st.iterations << " iterations, " << st.evaluations << " evaluations\n";
+    int failures = 0;
+    if ( errors || n_mic == 0 ) {
+        std::cout << " ERROR: " << errors << " of " << n_mic << " MICs have the wrong cut-width\n";
+        failures++;
+    }
+    if ( st.solves != n_mic || st.closed_form == 0 || st.bracketed == 0 || st.evaluations > 4*st.solves ) {
+        std::cout << " ERROR: find_next_u() does not use the closed-form and bracketed solutions\n";
+        failures++;
+    }
+    delete vd;
+    return failures;
+}
+
+/// \brief check the structure of the MedialAxisGraph of \a g
+/// \return number of errors
+int check_graph_structure(ovd::HEGraph& g, const ovd::MedialAxisGraph& mag) {
+    int errors = 0;
+    unsigned int n_edges = 0; // edges of the medial-axis, counting each pair of half-edges once
+    BOOST_FOREACH( ovd::HEEdge e, g.edges() ) {
+        if ( g[e].valid && g[e].type != ovd::LINESITE && g[e].type != ovd::ARCSITE && g[e].type != ovd::NULLEDGE )
+            n_edges++;
+    }
+    if ( 2*mag.pieces.size() != n_edges || mag.offsets.size() != mag.num_nodes()+1 ||
+         mag.adjacency.size() != 2*mag.num_branches() )
+        errors++;
+    for (unsigned int b=0;b<mag.num_branches() && !errors;b++) {
+        const ovd::MedialAxisGraph::Branch& br = mag.branches[b];
+        if ( br.begin >= br.end || g.source( mag.pieces[br.begin].edge ) != mag.nodes[br.source].vertex ||
+             g.target( mag.pieces[br.end-1].edge ) != mag.nodes[br.target].vertex )
+            errors++;
+        for (unsigned int i=br.begin;i<br.end;i++) {
+            const ovd::MedialAxisGraph::Piece& p = mag.pieces[i];
+            if ( i+1 < br.end && g.target(p.edge) != g.source( mag.pieces[i+1].edge ) )
+                errors++;
+            if ( p.t_begin != g[ g.source(p.edge) ].dist() || p.t_end != g[ g.target(p.edge) ].dist() )
+                errors++;
+        }
+    }
+    for (unsigned int n=0;n<mag.num_nodes();n++) {
+        // the degree in the graph is the number of medial-axis out-edges of the vertex
+        unsigned int degree = 0;
+        BOOST_FOREACH( ovd::HEEdge e, g.out_edges( mag.nodes[n].vertex ) ) {
+            if ( g[e].valid && g[e].type != ovd::LINESITE && g[e].type != ovd::ARCSITE && g[e].type != ovd::NULLEDGE )
+                degree++;
+        }
+        if ( degree != mag.degree(n) || mag.nodes[n].clearance != g[ mag.nodes[n].vertex ].dist() )
+            errors++;
+        for (unsigned int i=mag.offsets[n];i<mag.offsets[n+1];i++) {
+            unsigned int b = mag.adjacency[i];
+            if ( mag.branches[b].source != n && mag.branches[b].target != n )
+                errors++;
+        }
+    }
+    return errors;
+}
+
+/// \brief check extract_medial_axis() on a sheet of pockets, and on a ring, whose medial-axis is a loop
+/// \return number of failures
+int check_graph() {
+    int failures = 0;
+    ovd::PolygonSet ring;
+    for (int loop=0;loop<2;loop++) {
+        std::vector<ovd::Point> pts;
+        for (int i=0;i<60;i++) {
+            double a = 2*M_PI*i/60.0 * (loop ? -1 : 1); // the island is CW
+            pts.push_back( (loop ? 0.3 : 0.6)*ovd::Point( cos(a), sin(a) ) );
+        }
+        ring.add_loop(pts);
+    }
+    ovd::PolygonSet inputs[2] = { sheet(), ring };
+    for (int n=0;n<2;n++) {
+        ovd::VoronoiDiagram* vd = new ovd::VoronoiDiagram(1);
+        vd->set_silent(true);
+        inputs[n].insert(vd);
+        ovd::polygon_interior_filter pi(true);
+        ovd::medial_axis_filter ma;
+        vd->filter(&pi);
+        vd->filter(&ma);
+        ovd::MedialAxisGraph mag = ovd::extract_medial_axis( vd->get_graph_reference() );
+        int errors = check_graph_structure( vd->get_graph_reference(), mag );
+        std::cout << "extract_medial_axis(): " << mag.num_nodes() << " nodes, " << mag.num_branches() << " branches, "
+                  << mag.pieces.size() << " pieces\n";
+        if ( n == 1 && ( mag.num_nodes() != 1 || mag.num_branches() != 1 || mag.degree(0) != 2 || mag.other(0,0) != 0 ) )
+            errors++;
+        if ( n == 0 && mag.num_branches() < 9 )
+            errors++;
+        if (errors) {
+            std::cout << " ERROR: " << errors << " errors in the MedialAxisGraph\n";
+            failures++;
+        }
+        delete vd;
+    }
+    return failures;
+}
+
+/// \brief walk the loop of the medial-axis of an uneven ring, and of the same ring with a spike
+///
+/// the loop should start at its vertex with the smallest clearance, and go where the clearance grows more slowly.
+/// the spike adds a branch to the loop, which should end where it meets the loop, without walking the loop.
+/// \return number of failures
+int check_loop_start() {
+    int failures = 0;
+    for (int spike=0;spike<2;spike++) {
+        ovd::PolygonSet ring;
+        for (int loop=0;loop<2;loop++) {
+            std::vector<ovd::Point> pts;
+            for (int i=0;i<90;i++) {
+                double a = 2*M_PI*i/90.0 * (loop ? -1 : 1); // the island is CW
+                double r = loop ? 0.2 : 0.6 + 0.15*cos(a-1) + 0.05*sin(2*a);
+                if ( spike && !loop && i == 45 )
+                    r += 0.2;
+                pts.push_back( r*ovd::Point( cos(a), sin(a) ) );
+            }
+            ring.add_loop(pts);
+        }
+        ovd::VoronoiDiagram* vd = new ovd::VoronoiDiagram(1);
+        vd->set_silent(true);
+        ring.insert(vd);
+        ovd::polygon_interior_filter pi(true);
+        ovd::medial_axis_filter ma;
+        vd->filter(&pi);
+        vd->filter(&ma);
+        ovd::MedialAxisWalk maw( vd->get_graph_reference() );
+        ovd::MedialChainList chains = maw.walk();
+        if ( chains.size() != (unsigned int)(1+spike) ) {
+            std::cout << " ERROR: " << chains.size() << " chains on a ring with " << spike << " spikes\n";
+            failures++;
+            delete vd;
+            continue;
+        }
+        const ovd::MedialChain& chain = chains.back();
+        double min_clearance = chain.front().front().clearance_radius;
+        BOOST_FOREACH( const ovd::MedialPointList& pts, chain ) { // the vertices
+            min_clearance = std::min( min_clearance, std::min( pts.front().clearance_radius, pts.back().clearance_radius ) );
+        }
+        // the rise in clearance over the first edge, and over the last edge in reverse
+        const ovd::MedialPoint& start = chain.front().front();
+        const ovd::MedialPoint& fwd = chain.front().back();
+        const ovd::MedialPoint& bwd = chain.back().front();
+        double slope_fwd = ( fwd.clearance_radius - start.clearance_radius ) / ( fwd.p - start.p ).norm();
+        double slope_bwd = ( bwd.clearance_radius - start.clearance_radius ) / ( bwd.p - start.p ).norm();
+        std::cout << "loop: " << chain.size() << " edges, start clearance " << start.clearance_radius << " (smallest "
+                  << min_clearance << "), clearance rise " << slope_fwd << " (other way " << slope_bwd << ")\n";
+        if ( start.clearance_radius != min_clearance || !( start.p == chain.back().back().p ) || slope_fwd > slope_bwd ) {
+            std::cout << " ERROR: the loop does not start at its smallest clearance-disk, in the direction of the slower rise\n";
+            failures++;
+        }
+        if ( spike ) {
+            // the branch from the spike ends at a vertex of the loop
+            const ovd::MedialChain& branch = chains.front();
+            const ovd::Point& end = branch.back().back().p;
+            bool on_loop = false;
+            BOOST_FOREACH( const ovd::MedialPointList& pts, chain ) {
+                if ( ( pts.front().p - end ).norm() < 1e-9 )
+                    on_loop = true;
+            }
+            std::cout << "branch: " << branch.size() << " edges, from clearance " << branch.front().front().clearance_radius
+                      << " to " << branch.back().back().clearance_radius << "\n";
+            if ( !on_loop ) {
+                std::cout << " ERROR: the branch from the spike does not end on the loop\n";
+                failures++;
+            }
+        }
+        delete vd;
+    }
+    return failures;
+}
+
+/// \brief prune the medial-axis of a noisy pocket with five lobes
+/// \return number of failures
+int check_prune() {
+    boost::random::mt19937 rng(1);
+    boost::random::uniform_real_distribution<double> noise(-0.003,0.003);
+    std::vector<ovd::Point> pts;
+    for (int i=0;i<400;i++) {
+        double a = 2*M_PI*i/400.0;
+        pts.push_back( ( 0.5 + 0.15*cos(5*a) + noise(rng) )*ovd::Point( cos(a), sin(a) ) );
+    }
+    ovd::PolygonSet ps;
+    ps.add_loop(pts);
+    int failures = 0;
+    for (int n=0;n<3;n++) {
+        ovd::VoronoiDiagram* vd = new ovd::VoronoiDiagram(1);
+        vd->set_silent(true);
+        ps.insert(vd);
+        ovd::polygon_interior_filter pi(true);
+        ovd::medial_axis_filter ma;
+        vd->filter(&pi);
+        vd->filter(&ma);
+        ovd::HEGraph& g = vd->get_graph_reference();
+        ovd::MedialAxisPrune prune;
+        if ( n == 1 )
+            prune.set_erosion(0.02);
+        if ( n == 2 )
+            prune.set_angle(1.0);
+        unsigned int pruned = prune.prune(g);
+        ovd::MedialAxisGraph mag = ovd::extract_medial_axis(g);
+        unsigned int leaves = 0;
+        for (unsigned int k=0;k<mag.num_nodes();k++) {
+            if ( mag.degree(k) == 1 )
+                leaves++;
+        }
+        unsigned int before = prune.graph().num_branches();
+        std::cout << "MedialAxisPrune: " << before << " branches, " << pruned << " pruned, " << mag.num_branches()
+                  << " branches and " << leaves << " end-points left\n";
+        int errors = check_graph_structure(g, mag);
+        if ( n == 0 && ( pruned != 0 || mag.num_branches() != before ) )
+            errors++;
+        if ( n > 0 && ( 10*mag.num_branches() > before || leaves != 5 ) ) // one branch to each lobe
+            errors++;
+        if (errors) {
+            std::cout << " ERROR: " << errors << " errors in the pruned medial-axis\n";
+            failures++;
+        }
+        delete vd;
+    }
+    return failures;
+}
+
 // OpenVoronoi example program. Uses MedialAxis filter to filter the complete Voronoi diagram
 // down to the medial axis.
 // then uses MedialAxisWalk to walk along the medial axis and draw clearance-disks
@@ -79,5 +630,5 @@ int main() {
     vd->filter_reset();
     delete vd;
 
-    return 0;
+    return compare_walks() + check_sampler() + check_points() + check_parallel_pocket() + check_next_u() + check_graph() + check_prune() + check_loop_start();
 }
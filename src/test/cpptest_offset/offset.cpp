@@ -2,11 +2,279 @@
 #include <string>
 #include <iostream>
 
+#include <algorithm>
+
 #include "offset.hpp"
+#include "offset_sorter.hpp"
+#include "offset_polylines.hpp"
+#include "contour_toolpath.hpp"
+#include "parallel_offset.hpp"
+#include "face_interval_index.hpp"
+#include "clearance_cache.hpp"
+#include "polygon_interior_filter.hpp"
+#include "utility/polygon_generator.hpp"
 #include "voronoidiagram.hpp"
 #include "utility/vd2svg.hpp"
 #include "version.hpp"
 
+/// true if the two offsets are identical
+bool same_loops(const ovd::OffsetLoops& l1, const ovd::OffsetLoops& l2) {
+    if (l1.size() != l2.size())
+        return false;
+    for (unsigned int n=0;n<l1.size();n++) {
+        if (l1[n].vertices.size() != l2[n].vertices.size() || l1[n].offset_distance != l2[n].offset_distance)
+            return false;
+        std::list<ovd::OffsetVertex>::const_iterator v1 = l1[n].vertices.begin();
+        std::list<ovd::OffsetVertex>::const_iterator v2 = l2[n].vertices.begin();
+        for ( ; v1 != l1[n].vertices.end(); ++v1, ++v2) {
+            if ( !(v1->p == v2->p) || v1->r != v2->r || !(v1->c == v2->c) || v1->cw != v2->cw || v1->f != v2->f )
+                return false;
+        }
+    }
+    return true;
+}
+
+/// \brief visitor that checks that loops are closed and elements are continuous,
+/// and compares each element with previously computed loops
+class CheckingVisitor : public ovd::OffsetVisitor {
+public:
+    CheckingVisitor(const std::vector<ovd::OffsetLoops>& l) : expected(l), n(0), loop(0), visited(0), errors(0), in_loop(false) {}
+    virtual void begin_loop(double t) {
+        if (in_loop)
+            errors++;
+        while ( n < expected.size() && loop == expected[n].size() ) { // next distance
+            n++;
+            loop = 0;
+        }
+        if ( n == expected.size() || expected[n][loop].offset_distance != t ) {
+            errors++;
+            return;
+        }
+        in_loop = true;
+        v = expected[n][loop].vertices.begin();
+        first = v->p;
+        previous = v->p;
+        ++v;
+    }
+    virtual void line(const ovd::Point& p0, const ovd::Point& p1, ovd::HEFace f) {
+        element(p0, p1, -1, ovd::Point(0,0), true, f);
+    }
+    virtual void arc(const ovd::Point& p0, const ovd::Point& p1, const ovd::Point& c, double r, bool cw, ovd::HEFace f) {
+        element(p0, p1, r, c, cw, f);
+    }
+    virtual void end_loop() {
+        if ( !in_loop || !(previous == first) || v != expected[n][loop].vertices.end() )
+            errors++;
+        in_loop = false;
+        loop++;
+        visited++;
+    }
+    /// all loops were visited, without errors
+    bool ok() const {
+        unsigned int total = 0;
+        BOOST_FOREACH(const ovd::OffsetLoops& l, expected) {
+            total += l.size();
+        }
+        return errors == 0 && !in_loop && visited == total;
+    }
+private:
+    void element(const ovd::Point& p0, const ovd::Point& p1, double r, const ovd::Point& c, bool cw, ovd::HEFace f) {
+        if ( !in_loop || v == expected[n][loop].vertices.end() ) {
+            errors++;
+            return;
+        }
+        if ( !(p0 == previous) || !(p1 == v->p) || r != v->r || !(c == v->c) || cw != v->cw || f != v->f )
+            errors++;
+        previous = p1;
+        ++v;
+    }
+    const std::vector<ovd::OffsetLoops>& expected;
+    unsigned int n;
+    unsigned int loop;
+    unsigned int visited;
+    int errors;
+    bool in_loop;
+    std::list<ovd::OffsetVertex>::const_iterator v;
+    ovd::Point first;
+    ovd::Point previous;
+};
+
+/// \a loop as a polygon, with arcs split into short lines
+std::vector<ovd::Point> loop_polygon(const ovd::OffsetLoop& loop) {
+    std::vector<ovd::Point> poly;
+    ovd::Point previous = loop.vertices.front().p;
+    BOOST_FOREACH( const ovd::OffsetVertex& v, loop.vertices ) {
+        if (v.r > 0) {
+            ovd::Point a = previous-v.c;
+            ovd::Point b = v.p-v.c;
+            double sweep = atan2( a.cross(b), a.dot(b) );
+            if (v.cw && sweep > 0)
+                sweep -= 2*M_PI;
+            else if (!v.cw && sweep < 0)
+                sweep += 2*M_PI;
+            for (int i=1;i<32;i++) {
+                double angle = atan2(a.y,a.x) + sweep*i/32;
+                poly.push_back( v.c + v.r*ovd::Point(cos(angle),sin(angle)) );
+            }
+        }
+        poly.push_back(v.p);
+        previous = v.p;
+    }
+    return poly;
+}
+
+/// signed area of polygon \a poly
+double polygon_area(const std::vector<ovd::Point>& poly) {
+    double a=0;
+    for (unsigned int i=0;i<poly.size();i++)
+        a += 0.5*poly[i].cross( poly[(i+1)%poly.size()] );
+    return a;
+}
+
+/// true if \a p is inside polygon \a poly
+bool inside(const std::vector<ovd::Point>& poly, ovd::Point p) {
+    bool in = false;
+    for (unsigned int i=0, j=poly.size()-1; i<poly.size(); j=i++) {
+        if ( ( (poly[i].y > p.y) != (poly[j].y > p.y) ) &&
+             ( p.x < (poly[j].x-poly[i].x)*(p.y-poly[i].y)/(poly[j].y-poly[i].y) + poly[i].x ) )
+            in = !in;
+    }
+    return in;
+}
+
+/// \brief sort \a levels into a MachiningGraph, and check it. return the number of errors
+///
+/// each loop, except at the smallest distance, must be connected to loops at the next smaller distance only.
+/// the loop must be inside the loops it is connected to, or outside of them if they go around an island.
+/// with \a tree each loop must be connected to exactly one loop.
+int check_nesting(ovd::HEGraph& g, const std::vector<ovd::OffsetLoops>& levels, bool tree) {
+    ovd::OffsetSorter sorter(g);
+    BOOST_FOREACH( const ovd::OffsetLoops& loops, levels ) {
+        sorter.add_loops(loops);
+    }
+    sorter.sort_loops();
+    const ovd::MachiningGraph& mg = sorter.graph();
+    const std::vector<ovd::MGVertex>& order = sorter.loop_order();
+    int errors = 0;
+    double smallest = mg[ order.back() ].offset_distance;
+    double outer_sign = 0; // orientation of the loops that go around the pocket
+    BOOST_FOREACH( ovd::MGVertex v, order ) {
+        double a = polygon_area( loop_polygon(mg[v]) );
+        if ( fabs(a) > fabs(outer_sign) )
+            outer_sign = a;
+    }
+    for (unsigned int n=0;n<order.size();n++) {
+        ovd::MGVertex v = order[n];
+        double t = mg[v].offset_distance;
+        double next = smallest; // the next smaller distance
+        for (unsigned int m=n+1;m<order.size();m++) {
+            if ( mg[order[m]].offset_distance < t ) {
+                next = mg[order[m]].offset_distance;
+                break;
+            }
+        }
+        unsigned int parents = boost::out_degree(v, mg);
+        if ( (t > smallest && parents == 0) || (t == smallest && parents != 0) || (tree && t > smallest && parents != 1) )
+            errors++;
+        ovd::Point p = mg[v].vertices.front().p;
+        boost::graph_traits<ovd::MachiningGraph>::out_edge_iterator it, it_end;
+        for (boost::tie(it, it_end) = boost::out_edges(v, mg); it != it_end; ++it) {
+            const ovd::OffsetLoop& outer = mg[ boost::target(*it, mg) ];
+            std::vector<ovd::Point> poly = loop_polygon(outer);
+            bool island = ( polygon_area(poly) > 0 ) != ( outer_sign > 0 );
+            if ( outer.offset_distance != next || inside(poly, p) == island )
+                errors++;
+        }
+    }
+    return errors;
+}
+
+/// \brief link \a levels into a ContourToolpath, and check it. return the number of errors
+///
+/// each loop must be cut exactly once, every arc must start and end on its circle,
+/// a new path must start at each innermost loop, and the cut length must include the length of all loops.
+int check_toolpath(ovd::HEGraph& g, const std::vector<ovd::OffsetLoops>& levels) {
+    ovd::OffsetSorter sorter(g);
+    BOOST_FOREACH( const ovd::OffsetLoops& loops, levels ) {
+        sorter.add_loops(loops);
+    }
+    sorter.sort_loops();
+    const ovd::MachiningGraph& mg = sorter.graph();
+    ovd::ContourToolpath toolpath(sorter);
+    toolpath.run();
+    int errors = 0;
+    std::vector<int> cut( boost::num_vertices(mg), 0 );
+    std::vector<int> inner( boost::num_vertices(mg), 0 );
+    double loop_length = 0;
+    BOOST_FOREACH( ovd::MGVertex v, sorter.loop_order() ) {
+        boost::graph_traits<ovd::MachiningGraph>::out_edge_iterator it, it_end;
+        boost::tie(it, it_end) = boost::out_edges(v, mg);
+        if ( it != it_end ) // a loop is linked to the first loop outside it
+            inner[ boost::target(*it, mg) ]++;
+        ovd::Point previous = mg[v].vertices.front().p;
+        BOOST_FOREACH( const ovd::OffsetVertex& ov, mg[v].vertices ) {
+            loop_length += ov.length(previous);
+            previous = ov.p;
+        }
+    }
+    BOOST_FOREACH( const ovd::ContourPath& path, toolpath.paths() ) {
+        BOOST_FOREACH( ovd::MGVertex v, path.loops ) {
+            cut[v]++;
+        }
+        for (unsigned int k=1;k<path.moves.size();k++) {
+            const ovd::OffsetVertex& m = path.moves[k];
+            if ( m.r > 0 && ( fabs( (path.moves[k-1].p-m.c).norm() - m.r ) > 1e-6 || fabs( (m.p-m.c).norm() - m.r ) > 1e-6 ) )
+                errors++;
+        }
+    }
+    unsigned int leaves = 0;
+    for (unsigned int v=0;v<cut.size();v++) {
+        if ( cut[v] != 1 )
+            errors++;
+        if ( inner[v] == 0 )
+            leaves++;
+    }
+    if ( toolpath.paths().size() != leaves )
+        errors++;
+    if ( toolpath.cut_length() < loop_length*(1-1e-9) || toolpath.rapid_length() < 0 )
+        errors++;
+    std::cout << "toolpath: " << cut.size() << " loops in " << toolpath.paths().size() << " paths, cut length "
+              << toolpath.cut_length() << " (loops " << loop_length << ") rapid length " << toolpath.rapid_length() << "\n";
+    return errors;
+}
+
+/// \brief the number of faces of \a g that \a loops pass through a wrong number of times
+///
+/// a loop passes through a face once for each edge of the face where the clearance rises past \a t,
+/// if all edges of the face are valid.
+int wrong_passages(ovd::HEGraph& g, const ovd::OffsetLoops& loops, double t) {
+    std::vector<unsigned int> passed( g.num_faces(), 0 );
+    BOOST_FOREACH( const ovd::OffsetLoop& loop, loops ) {
+        std::list<ovd::OffsetVertex>::const_iterator it = loop.vertices.begin();
+        for (++it; it != loop.vertices.end(); ++it)
+            passed[it->f]++;
+    }
+    int errors = 0;
+    for (ovd::HEFace f=0; f<g.num_faces(); f++) {
+        unsigned int rising = 0;
+        bool valid = true, bracket = false;
+        ovd::HEEdge current = g[f].edge;
+        do {
+            double a = g[ g.source(current) ].dist();
+            double b = g[ g.target(current) ].dist();
+            valid = valid && g[current].valid;
+            bracket = bracket || ( std::min(a,b) < t && t < std::max(a,b) );
+            if ( a < t && t < b )
+                rising++;
+            current = g[current].next;
+        } while ( current != g[f].edge );
+        unsigned int expected = ( valid && bracket ) ? std::max(rising, 1u) : 0;
+        if ( passed[f] != expected )
+            errors++;
+    }
+    return errors;
+}
+
 // very simple OpenVoronoi example program
 int main() {
     ovd::VoronoiDiagram* vd = new ovd::VoronoiDiagram(1); // (r)
@@ -70,7 +338,303 @@ int main() {
 
     doc.save();
     std::cout << vd->print();
+
+    // offsets at many distances in one call must be identical to one call per distance.
+    // the distances are unsorted, repeated, and include the clearance of a vertex.
+    int failures = 0;
+    std::vector<double> ts;
+    for (int i=12; i>0; i--)
+        ts.push_back( i*0.013 );
+    ts.push_back( 0.026 );
+    BOOST_FOREACH( ovd::HEVertex v, g.vertices() ) {
+        if ( g[v].dist() > 0 && g[v].dist() < 0.15 ) {
+            ts.push_back( g[v].dist() );
+            break;
+        }
+    }
+    std::vector<ovd::OffsetLoops> multi = offset.offset(ts);
+    for (unsigned int n=0;n<ts.size();n++) {
+        if ( !same_loops( multi[n], offset.offset(ts[n]) ) ) {
+            std::cout << " ERROR: multi-distance offset differs at t= " << ts[n] << "\n";
+            failures++;
+        }
+    }
+
+    // the interval index must find the same faces as a scan over all faces
+    ovd::ClearanceCache cache;
+    cache.build(g);
+    ovd::FaceIntervalIndex index;
+    index.build(cache);
+    for (int i=0;i<40;i++) {
+        double t = 0.005*i;
+        std::vector<ovd::HEFace> found, expected;
+        index.query(t, found);
+        std::sort( found.begin(), found.end() );
+        for (ovd::HEFace f=0; f<g.num_faces(); f++) {
+            double lo=1e99, hi=-1e99;
+            BOOST_FOREACH( ovd::HEVertex v, g.face_vertices(f) ) {
+                lo = std::min(lo, g[v].dist());
+                hi = std::max(hi, g[v].dist());
+            }
+            if (lo < t && t < hi)
+                expected.push_back(f);
+        }
+        if (found != expected) {
+            std::cout << " ERROR: index finds " << found.size() << " faces at t= " << t << ", expected " << expected.size() << "\n";
+            failures++;
+        }
+    }
+
+    // the clearance cache must hold the edges of each face in order, with the clearance of their vertices
+    int cache_errors = 0;
+    for (ovd::HEFace f=0; f<g.num_faces(); f++) {
+        double lo=1e99, hi=-1e99;
+        ovd::HEEdge current = g[f].edge;
+        for (unsigned int e=cache.begin(f); e<cache.end(f); e++) {
+            const ovd::ClearanceCache::Edge& r = cache.edge(e);
+            lo = std::min(lo, r.src_t);
+            hi = std::max(hi, r.src_t);
+            if ( r.e != current || r.face != f || cache.index(current, g) != e ||
+                 r.src_t != g[ g.source(current) ].dist() || r.trg_t != g[ g.target(current) ].dist() ||
+                 cache.vertex_dist(r.src) != r.src_t || cache.edge(r.next).e != g[current].next ||
+                 ( g[current].twin == ovd::HEEdge() ) != ( r.twin == ovd::ClearanceCache::NO_EDGE ) ||
+                 ( r.twin != ovd::ClearanceCache::NO_EDGE && ( cache.edge(r.twin).e != g[current].twin || cache.edge(r.twin).src != r.trg ) ) ||
+                 r.valid != g[current].valid ||
+                 r.apex != ( g[ g.source(current) ].type == ovd::APEX || g[ g.target(current) ].type == ovd::APEX ) )
+                cache_errors++;
+            current = g[current].next;
+        }
+        if ( current != g[f].edge || lo != cache.face_min(f) || hi != cache.face_max(f) )
+            cache_errors++;
+    }
+    if ( cache.num_edges() != g.num_edges() || cache.num_vertices() != g.num_vertices() || cache_errors ) {
+        std::cout << " ERROR: " << cache_errors << " errors in clearance cache\n";
+        failures++;
+    }
+
+    // after the insertions and removals of construction, each edge has its own index in [0,num_edges())
+    int index_errors = 0;
+    BOOST_FOREACH( ovd::HEEdge e, g.edges() ) {
+        if ( g[e].index >= g.num_edges() || g.indexed_edge( g[e].index ) != e )
+            index_errors++;
+    }
+    if (index_errors) {
+        std::cout << " ERROR: " << index_errors << " edges with a wrong index\n";
+        failures++;
+    }
+
+    delete vd;
+
+    // the index is rebuilt when sites are inserted after an offset
+    vd = new ovd::VoronoiDiagram(1);
+    int ids[3] = { vd->insert_point_site(p0), vd->insert_point_site(p1), vd->insert_point_site(p4) };
+    ovd::HEGraph& g2 = vd->get_graph_reference();
+    ovd::Offset offset2(g2);
+    offset2.offset(0.05);
+    cache.build(g2);
+    index.build(cache);
+    vd->insert_line_site(ids[0], ids[1]);
+    vd->insert_line_site(ids[1], ids[2]);
+    if ( !index.stale(g2) ) {
+        std::cout << " ERROR: index not stale after insertion\n";
+        failures++;
+    }
+    cache.build(g2);
+    ovd::polygon_interior_filter interior(true);
+    vd->filter(&interior);
+    if ( !cache.stale(g2) ) {
+        std::cout << " ERROR: clearance cache not stale after filter\n";
+        failures++;
+    }
+    vd->filter_reset();
+    ovd::Offset fresh(g2);
+    for (unsigned int n=0;n<ts.size();n++) {
+        if ( !same_loops( offset2.offset(ts[n]), fresh.offset(ts[n]) ) ) {
+            std::cout << " ERROR: offset differs after insertion at t= " << ts[n] << "\n";
+            failures++;
+        }
+    }
+    delete vd;
+
+    // parallel offsets must be identical to sequential ones, for any number of threads.
+    // a pocket with islands gives several loops at each distance. with a single distance
+    // the start-faces are split between threads.
+    ovd::PolygonGenerator gen(7);
+    ovd::PolygonSet ps = gen.polygon( ovd::PolygonGenerator::SPACE_PARTITIONING, 200, 8 );
+    vd = new ovd::VoronoiDiagram(1);
+    vd->set_silent(true);
+    ps.insert(vd);
+    ovd::polygon_interior_filter pi(true);
+    vd->filter(&pi);
+    ovd::HEGraph& g3 = vd->get_graph_reference();
+    ovd::Offset sequential(g3);
+    std::vector<double> pts;
+    for (int i=1;i<=30;i++)
+        pts.push_back( 0.002*i );
+    std::vector<ovd::OffsetLoops> expected = sequential.offset(pts);
+    unsigned int threads[] = {1, 2, 3, 8};
+    for (int n=0;n<4;n++) {
+        ovd::ParallelOffset parallel(g3, threads[n]);
+        std::vector<ovd::OffsetLoops> result = parallel.offset(pts);
+        for (unsigned int i=0;i<pts.size();i++) {
+            if ( !same_loops( result[i], expected[i] ) ) {
+                std::cout << " ERROR: parallel offset with " << threads[n] << " threads differs at t= " << pts[i] << "\n";
+                failures++;
+            }
+        }
+        for (unsigned int i=0;i<pts.size();i+=7) {
+            if ( !same_loops( parallel.offset(pts[i]), expected[i] ) ) {
+                std::cout << " ERROR: single parallel offset with " << threads[n] << " threads differs at t= " << pts[i] << "\n";
+                failures++;
+            }
+        }
+    }
+    std::cout << "parallel offset: " << expected[0].size() << " loops at t= " << pts[0] << "\n";
+
+    // offsets restricted to the region of a face inside the pocket must be identical,
+    // and the region must not include the faces outside the pocket
+    ovd::Offset in_region(g3);
+    in_region.set_region( (++expected[0].front().vertices.begin())->f );
+    std::vector<ovd::HEFace> region = in_region.region();
+    std::vector<ovd::OffsetLoops> region_loops = in_region.offset(pts);
+    in_region.set_faces(region);
+    std::vector<ovd::OffsetLoops> face_loops = in_region.offset(pts);
+    in_region.clear_region();
+    std::vector<ovd::OffsetLoops> all_loops = in_region.offset(pts);
+    for (unsigned int i=0;i<pts.size();i++) {
+        if ( !same_loops( region_loops[i], expected[i] ) || !same_loops( face_loops[i], expected[i] ) ||
+             !same_loops( all_loops[i], expected[i] ) ) {
+            std::cout << " ERROR: offset restricted to a region differs at t= " << pts[i] << "\n";
+            failures++;
+        }
+    }
+    int outside = 0;
+    BOOST_FOREACH( ovd::HEFace f, region ) {
+        BOOST_FOREACH( ovd::HEEdge e, g3.face_edges(f) ) {
+            if ( !g3[e].valid )
+                outside++;
+        }
+    }
+    if ( outside || region.size() >= g3.num_faces() ) {
+        std::cout << " ERROR: region of " << region.size() << " faces includes " << outside << " invalid edges\n";
+        failures++;
+    }
+    std::cout << "region: " << region.size() << " of " << g3.num_faces() << " faces\n";
+
+    // streamed offsets must match the returned loops, element by element
+    CheckingVisitor checker(expected);
+    sequential.offset(pts, checker);
+    if ( !checker.ok() ) {
+        std::cout << " ERROR: streamed offsets differ from offset loops\n";
+        failures++;
+    }
+
+    // polylines written while walking, and from loops, must be identical, and within the chord tolerance of the arcs
+    double tol = 1e-4;
+    ovd::OffsetPolylines streamed(tol), from_loops(tol);
+    sequential.offset(pts, streamed);
+    BOOST_FOREACH( const ovd::OffsetLoops& loops, expected ) {
+        from_loops.add(loops);
+    }
+    if ( streamed.points != from_loops.points || streamed.loop_start != from_loops.loop_start ||
+         streamed.distance != from_loops.distance || from_loops.points.capacity() != from_loops.points.size() ) {
+        std::cout << " ERROR: streamed and stored polylines differ\n";
+        failures++;
+    }
+    int chord_errors = 0;
+    std::size_t loop_n = 0;
+    BOOST_FOREACH( const ovd::OffsetLoops& loops, expected ) {
+        BOOST_FOREACH( const ovd::OffsetLoop& loop, loops ) {
+            std::size_t i = from_loops.loop_start[loop_n];
+            BOOST_FOREACH( const ovd::OffsetVertex& v, loop.vertices ) {
+                if ( i == from_loops.loop_start[loop_n] ) { // the start point
+                    i++;
+                    continue;
+                }
+                unsigned int n = (v.r > 0) ? from_loops.arc_segments(from_loops.points[i-1], v.p, v.c, v.r, v.cw) : 1;
+                for (unsigned int k=0;k<n;k++,i++) {
+                    ovd::Point mid = 0.5*( from_loops.points[i-1] + from_loops.points[i] );
+                    if ( v.r > 0 && ( fabs( (from_loops.points[i]-v.c).norm() - v.r ) > 1e-9 || v.r - (mid-v.c).norm() > tol*(1+1e-9) ) )
+                        chord_errors++;
+                }
+                if ( !(from_loops.points[i-1] == v.p) )
+                    chord_errors++;
+            }
+            if ( i != from_loops.loop_start[loop_n+1] )
+                chord_errors++;
+            loop_n++;
+        }
+    }
+    if (chord_errors) {
+        std::cout << " ERROR: " << chord_errors << " errors in polylines\n";
+        failures++;
+    }
+
+    // no loop is missed in faces that more than one loop passes through
+    for (unsigned int i=0;i<pts.size();i++) {
+        int wrong = wrong_passages(g3, expected[i], pts[i]);
+        if (wrong) {
+            std::cout << " ERROR: " << wrong << " faces passed a wrong number of times at t= " << pts[i] << "\n";
+            failures++;
+        }
+    }
+
+    // nesting of loops in a pocket with islands
+    int nesting = check_nesting(g3, expected, false);
+    if (nesting) {
+        std::cout << " ERROR: " << nesting << " errors in nesting of offset loops\n";
+        failures++;
+    }
+    // a sorter sharing the clearance cache of the Offset must connect the same loops
+    ovd::OffsetSorter own(g3), shared(g3, sequential.clearance_cache());
+    BOOST_FOREACH( const ovd::OffsetLoops& loops, expected ) {
+        own.add_loops(loops);
+        shared.add_loops(loops);
+    }
+    own.sort_loops();
+    shared.sort_loops();
+    boost::graph_traits<ovd::MachiningGraph>::edge_iterator it, it_end, it2, it2_end;
+    boost::tie(it, it_end) = boost::edges( own.graph() );
+    boost::tie(it2, it2_end) = boost::edges( shared.graph() );
+    for ( ; it != it_end && it2 != it2_end; ++it, ++it2 ) {
+        if ( boost::source(*it, own.graph()) != boost::source(*it2, shared.graph()) ||
+             boost::target(*it, own.graph()) != boost::target(*it2, shared.graph()) )
+            break;
+    }
+    if ( it != it_end || it2 != it2_end ) {
+        std::cout << " ERROR: sorter with shared clearance cache differs\n";
+        failures++;
+    }
+    int linking = check_toolpath(g3, expected);
+    if (linking) {
+        std::cout << " ERROR: " << linking << " errors in contour toolpath\n";
+        failures++;
+    }
+    delete vd;
+
+    // without islands the loops form a tree
+    ovd::PolygonGenerator star_gen(3);
+    ovd::PolygonSet star = star_gen.polygon( ovd::PolygonGenerator::STAR, 60 );
+    vd = new ovd::VoronoiDiagram(1);
+    vd->set_silent(true);
+    star.insert(vd);
+    vd->filter(&pi);
+    ovd::Offset star_offset( vd->get_graph_reference() );
+    std::vector<double> star_ts;
+    for (int i=1;i<=60;i++)
+        star_ts.push_back( 0.005*i );
+    std::vector<ovd::OffsetLoops> star_levels = star_offset.offset(star_ts);
+    nesting = check_nesting( vd->get_graph_reference(), star_levels, true );
+    if (nesting) {
+        std::cout << " ERROR: " << nesting << " errors in nesting of offset loops without islands\n";
+        failures++;
+    }
+    linking = check_toolpath( vd->get_graph_reference(), star_levels );
+    if (linking) {
+        std::cout << " ERROR: " << linking << " errors in contour toolpath without islands\n";
+        failures++;
+    }
     delete vd;
 
-    return 0;
+    return failures;
 }
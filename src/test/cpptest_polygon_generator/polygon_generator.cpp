@@ -0,0 +1,71 @@
+#include <string>
+#include <iostream>
+
+#include "voronoidiagram.hpp"
+#include "polygon_interior_filter.hpp"
+#include "offset.hpp"
+#include "utility/polygon_generator.hpp"
+#include "version.hpp"
+
+// generate random polygons with islands with each method, and check that
+// they are simple, correctly oriented, and that the voronoi diagram of each is valid.
+int main() {
+    std::cout << ovd::version() << "\n";
+    const char* names[] = {"space_partitioning", "two_opt", "star", "koch"};
+    ovd::PolygonGenerator::Method methods[] = {ovd::PolygonGenerator::SPACE_PARTITIONING,
+        ovd::PolygonGenerator::TWO_OPT, ovd::PolygonGenerator::STAR, ovd::PolygonGenerator::KOCH};
+    int failures = 0;
+    for (int m=0;m<4;m++) {
+        for (unsigned int seed=1;seed<=3;seed++) {
+            ovd::PolygonGenerator gen(seed);
+            ovd::PolygonSet ps = gen.polygon( methods[m], 40, 3 );
+            std::cout << names[m] << " seed " << seed << ": " << ps.points.size() << " points, "
+                      << ps.loops.size()-1 << " islands\n";
+
+            // the same seed must give the same polygon
+            ovd::PolygonGenerator gen2(seed);
+            ovd::PolygonSet ps2 = gen2.polygon( methods[m], 40, 3 );
+            bool same = (ps2.points.size() == ps.points.size());
+            for (unsigned int i=0; same && i<ps.points.size(); i++)
+                same = (ps.points[i] == ps2.points[i]);
+            if (!same) {
+                std::cout << " ERROR: not deterministic\n";
+                failures++;
+            }
+            if (!ps.is_simple()) {
+                std::cout << " ERROR: not simple\n";
+                failures++;
+            }
+            if (ps.area(0) <= 0) {
+                std::cout << " ERROR: boundary not CCW\n";
+                failures++;
+            }
+            for (unsigned int n=1;n<ps.loops.size();n++) {
+                if (ps.area(n) >= 0) {
+                    std::cout << " ERROR: island not CW\n";
+                    failures++;
+                }
+            }
+
+            ovd::VoronoiDiagram* vd = new ovd::VoronoiDiagram(1);
+            vd->set_silent(true);
+            ps.insert(vd);
+            if (!vd->check()) {
+                std::cout << " ERROR: diagram check failed\n";
+                failures++;
+            }
+            // a small offset gives (at least) one loop inside the boundary and one loop around each island.
+            // narrow necks in the pocket may split the boundary offset into several loops.
+            ovd::polygon_interior_filter pi(true);
+            vd->filter(&pi);
+            ovd::Offset of( vd->get_graph_reference() );
+            ovd::OffsetLoops loops = of.offset(0.001);
+            if (loops.size() < ps.loops.size()) {
+                std::cout << " ERROR: " << loops.size() << " offset loops, expected at least " << ps.loops.size() << "\n";
+                failures++;
+            }
+            delete vd;
+        }
+    }
+    return failures;
+}
@@ -0,0 +1,199 @@
+#include <string>
+#include <iostream>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+
+#include <boost/foreach.hpp>
+#include <boost/random/mersenne_twister.hpp>
+#include <boost/random/uniform_real_distribution.hpp>
+
+#include "voronoidiagram.hpp"
+#include "polygon_interior_filter.hpp"
+#include "medial_axis_filter.hpp"
+#include "toolpath_order.hpp"
+#include "utility/polygon_generator.hpp"
+#include "version.hpp"
+
+/// rapid length of paths from \a first to \a last in \a order, reversed where \a reversed is set
+double rapid_length(const std::vector<ovd::Point>& first, const std::vector<ovd::Point>& last,
+                    const std::vector<unsigned int>& order, const std::vector<char>& reversed) {
+    double sum = 0;
+    ovd::Point position(0,0);
+    for (unsigned int k=0;k<order.size();k++) {
+        sum += ( ( reversed[k] ? last : first )[ order[k] ] - position ).norm();
+        position = ( reversed[k] ? first : last )[ order[k] ];
+    }
+    return sum;
+}
+
+/// \brief check that \a o is a permutation of \a n paths, with the rapid length it reports
+/// \return number of errors
+int check_order(const ovd::ToolpathOrder& o, const std::vector<ovd::Point>& first, const std::vector<ovd::Point>& last) {
+    std::vector<unsigned int> sorted( o.order() );
+    std::sort( sorted.begin(), sorted.end() );
+    int errors = 0;
+    for (unsigned int n=0;n<sorted.size();n++) {
+        if ( sorted[n] != n )
+            errors++;
+    }
+    if ( sorted.size() != first.size() || o.reversed().size() != first.size() )
+        errors++;
+    else if ( fabs( rapid_length(first, last, o.order(), o.reversed()) - o.rapid_after() ) > 1e-9 )
+        errors++;
+    if ( o.rapid_after() > o.rapid_before() + 1e-12 )
+        errors++;
+    return errors;
+}
+
+/// \brief order shuffled pieces of a line, and random segments
+/// \return number of failures
+int check_segments() {
+    int failures = 0;
+    boost::random::mt19937 rng(1);
+    boost::random::uniform_real_distribution<double> random(0,1);
+    // pieces of the x-axis, in random order and direction. the shortest rapids link the pieces in x-order
+    unsigned int n = 200;
+    std::vector<unsigned int> piece(n);
+    for (unsigned int i=0;i<n;i++)
+        piece[i] = i;
+    std::vector<ovd::Point> first(n), last(n);
+    for (unsigned int i=0;i<n;i++) {
+        std::swap( piece[i], piece[ i + (unsigned int)( random(rng)*(n-i) ) ] );
+        first[i] = ovd::Point( 0.004*piece[i], 0 );
+        last[i] = ovd::Point( 0.004*piece[i]+0.002, 0 );
+        if ( random(rng) < 0.5 )
+            std::swap( first[i], last[i] );
+    }
+    ovd::ToolpathOrder line;
+    line.run(first, last, true);
+    std::cout << "line: rapids " << line.rapid_before() << " -> " << line.rapid_after() << ", " << line.moves() << " moves\n";
+    if ( check_order(line, first, last) || line.rapid_after() > 1.01*0.002*(n-1) ) {
+        std::cout << " ERROR: pieces of a line not ordered along the line\n";
+        failures++;
+    }
+    // random short segments: the moves improve on the nearest-neighbour tour
+    n = 1000;
+    first.resize(n);
+    last.resize(n);
+    for (unsigned int i=0;i<n;i++) {
+        first[i] = ovd::Point( random(rng)-0.5, random(rng)-0.5 );
+        last[i] = first[i] + 0.02*ovd::Point( random(rng)-0.5, random(rng)-0.5 );
+    }
+    for (int reversible=0;reversible<2;reversible++) {
+        ovd::ToolpathOrder greedy;
+        greedy.set_time_budget(0);
+        greedy.run(first, last, reversible);
+        ovd::ToolpathOrder improved;
+        improved.run(first, last, reversible);
+        std::cout << "segments (reversible=" << reversible << "): rapids " << improved.rapid_before() << " -> nearest-neighbour "
+                  << greedy.rapid_after() << " -> " << improved.rapid_after() << ", " << improved.moves() << " moves\n";
+        if ( check_order(greedy, first, last) || check_order(improved, first, last) || greedy.moves() != 0 ||
+             !( improved.rapid_after() < 0.95*greedy.rapid_after() ) ) {
+            std::cout << " ERROR: 2-opt and Or-opt do not improve the nearest-neighbour tour\n";
+            failures++;
+        }
+        if ( !reversible ) {
+            BOOST_FOREACH( char r, improved.reversed() ) {
+                if (r)
+                    failures++;
+            }
+        }
+    }
+    return failures;
+}
+
+/// \brief a sheet of 4x4 separate random pockets, each with an island
+ovd::PolygonSet sheet() {
+    return ovd::PolygonGenerator::sheet(4, 4, 0.3, 0.13, 20, 40);
+}
+
+/// \brief order the MIC-lists of medial_axis_pocket, and the chains of MedialAxisWalk, on a sheet of pockets
+/// \return number of failures
+int check_medial_axis() {
+    ovd::PolygonSet ps = sheet();
+    ovd::VoronoiDiagram* vd = new ovd::VoronoiDiagram(1);
+    vd->set_silent(true);
+    ps.insert(vd);
+    ovd::polygon_interior_filter pi(true);
+    ovd::medial_axis_filter ma;
+    vd->filter(&pi);
+    vd->filter(&ma);
+    int failures = 0;
+
+    ovd::medial_axis_pocket map( vd->get_graph_reference() );
+    map.set_width(0.01);
+    map.run();
+    std::vector<ovd::medial_axis_pocket::MICList> components = map.get_mic_components();
+    std::vector<ovd::medial_axis_pocket::MICList> input = components;
+    ovd::ToolpathOrder mic_order;
+    mic_order.run(components);
+    std::cout << "medial_axis_pocket: " << components.size() << " MIC-lists, rapids " << mic_order.rapid_before()
+              << " -> " << mic_order.rapid_after() << "\n";
+    std::vector<ovd::Point> first, last;
+    BOOST_FOREACH( const ovd::medial_axis_pocket::MICList& mics, input ) {
+        first.push_back( mics.front().c2 );
+        last.push_back( mics.back().c2 );
+    }
+    bool same = ( components.size() == input.size() && check_order(mic_order, first, last) == 0 );
+    for (unsigned int k=0;k<components.size() && same;k++) {
+        const ovd::medial_axis_pocket::MICList& in = input[ mic_order.order()[k] ];
+        same = ( components[k].size() == in.size() && !mic_order.reversed()[k] );
+        for (unsigned int i=0;i<in.size() && same;i++)
+            same = ( components[k][i].c2 == in[i].c2 );
+    }
+    if ( !same || components.size() < 16 ) {
+        std::cout << " ERROR: MIC-lists not reordered\n";
+        failures++;
+    }
+
+    ovd::MedialAxisWalk maw( vd->get_graph_reference() );
+    ovd::MedialChainList chains = maw.walk();
+    std::vector< std::vector<ovd::Point> > points; // the points of each chain, in order
+    first.clear();
+    last.clear();
+    BOOST_FOREACH( const ovd::MedialChain& chain, chains ) {
+        points.push_back( std::vector<ovd::Point>() );
+        BOOST_FOREACH( const ovd::MedialPointList& pts, chain ) {
+            BOOST_FOREACH( const ovd::MedialPoint& p, pts ) {
+                points.back().push_back( p.p );
+            }
+        }
+        first.push_back( points.back().front() );
+        last.push_back( points.back().back() );
+    }
+    ovd::ToolpathOrder chain_order;
+    chain_order.run(chains);
+    std::cout << "MedialAxisWalk: " << chains.size() << " chains, rapids " << chain_order.rapid_before()
+              << " -> " << chain_order.rapid_after() << "\n";
+    same = ( chains.size() == points.size() && check_order(chain_order, first, last) == 0 );
+    unsigned int k = 0;
+    BOOST_FOREACH( const ovd::MedialChain& chain, chains ) {
+        if ( !same )
+            break;
+        std::vector<ovd::Point> in = points[ chain_order.order()[k] ];
+        if ( chain_order.reversed()[k] )
+            std::reverse( in.begin(), in.end() );
+        unsigned int i = 0;
+        BOOST_FOREACH( const ovd::MedialPointList& pts, chain ) {
+            BOOST_FOREACH( const ovd::MedialPoint& p, pts ) {
+                same = same && ( i < in.size() && p.p == in[i] );
+                i++;
+            }
+        }
+        same = same && ( i == in.size() );
+        k++;
+    }
+    if ( !same || !( chain_order.rapid_after() < chain_order.rapid_before() ) ) {
+        std::cout << " ERROR: medial-axis chains not reordered\n";
+        failures++;
+    }
+    delete vd;
+    return failures;
+}
+
+// order toolpaths to reduce the rapid moves between them
+int main() {
+    std::cout << ovd::version() << "\n";
+    return check_segments() + check_medial_axis();
+}
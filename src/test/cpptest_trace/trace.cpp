@@ -0,0 +1,94 @@
+#include <string>
+#include <sstream>
+#include <iostream>
+#include <thread>
+
+#include "voronoidiagram.hpp"
+#include "trace.hpp"
+#include "version.hpp"
+
+/// true if \a json contains \a s
+bool contains(const std::string& json, const std::string& s) {
+    return json.find(s) != std::string::npos;
+}
+
+/// record n events in a new thread with a small ring buffer
+void small_buffer_thread(int n) {
+    for (int i=0;i<n;i++) {
+        ovd::trace::Scope s("ring");
+    }
+}
+
+// record scoped events from two threads, check the Chrome trace output,
+// and check that diagram construction is traced when built with OVD_TRACE.
+int main() {
+    std::cout << ovd::version() << "\n";
+    int failures = 0;
+    {
+        ovd::trace::Scope s("outer","tag0");
+        ovd::trace::Steps steps;
+        steps.next("step1");
+        steps.next("step2");
+    }
+    if (ovd::trace::size() != 3) {
+        std::cout << " ERROR: " << ovd::trace::size() << " events, expected 3\n";
+        failures++;
+    }
+
+    // a full ring buffer keeps only the newest events
+    ovd::trace::set_buffer_size(3); // rounded up to 4
+    std::thread t(small_buffer_thread,10);
+    t.join();
+    if (ovd::trace::size() != 3+4) {
+        std::cout << " ERROR: " << ovd::trace::size() << " events, expected 7\n";
+        failures++;
+    }
+
+    ovd::trace::set_enabled(false);
+    {
+        ovd::trace::Scope s("disabled");
+    }
+    ovd::trace::set_enabled(true);
+
+    std::ostringstream o;
+    ovd::trace::write_chrome_trace(o);
+    std::string json = o.str();
+    const char* expected[] = {"{\"traceEvents\":[", "\"name\":\"outer\"", "\"tag\":\"tag0\"",
+        "\"name\":\"step1\"", "\"name\":\"step2\"", "\"name\":\"ring\"", "\"ph\":\"X\"", "\"tid\":1"};
+    for (unsigned int i=0;i<sizeof(expected)/sizeof(expected[0]);i++) {
+        if (!contains(json,expected[i])) {
+            std::cout << " ERROR: trace does not contain " << expected[i] << "\n";
+            failures++;
+        }
+    }
+    if (contains(json,"disabled")) {
+        std::cout << " ERROR: event recorded while disabled\n";
+        failures++;
+    }
+
+    ovd::trace::clear();
+    if (ovd::trace::size() != 0) {
+        std::cout << " ERROR: clear() left " << ovd::trace::size() << " events\n";
+        failures++;
+    }
+
+#ifdef OVD_TRACE
+    ovd::VoronoiDiagram* vd = new ovd::VoronoiDiagram(1);
+    int id1 = vd->insert_point_site( ovd::Point(-0.1,-0.2) );
+    int id2 = vd->insert_point_site( ovd::Point( 0.2, 0.1) );
+    vd->insert_point_site( ovd::Point( 0.1,-0.3) );
+    vd->insert_line_site(id1,id2);
+    delete vd;
+    std::ostringstream o2;
+    ovd::trace::write_chrome_trace(o2);
+    const char* phases[] = {"insert_point_site", "insert_line_site", "augment_vertex_set",
+        "separators", "\"name\":\"position\"", "\"tag\":\"ppp\""};
+    for (unsigned int i=0;i<sizeof(phases)/sizeof(phases[0]);i++) {
+        if (!contains(o2.str(),phases[i])) {
+            std::cout << " ERROR: trace does not contain " << phases[i] << "\n";
+            failures++;
+        }
+    }
+#endif
+    return failures;
+}
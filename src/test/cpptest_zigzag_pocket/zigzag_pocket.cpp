@@ -0,0 +1,122 @@
+#include <string>
+#include <iostream>
+#include <cmath>
+#include <ctime>
+
+#include <boost/foreach.hpp>
+
+#include "voronoidiagram.hpp"
+#include "polygon_interior_filter.hpp"
+#include "zigzag_pocket.hpp"
+#include "utility/polygon_generator.hpp"
+#include "version.hpp"
+
+/// distance from \a p to the segment \a a - \a b
+double segment_distance(const ovd::Point& p, const ovd::Point& a, const ovd::Point& b) {
+    ovd::Point ab = b-a;
+    double u = (p-a).dot(ab) / ab.dot(ab);
+    u = std::max( 0.0, std::min( 1.0, u ) );
+    return ( p - (a+u*ab) ).norm();
+}
+
+/// distance from \a p to the boundary of the pocket \a ps, negative outside the pocket
+double clearance(const ovd::PolygonSet& ps, const ovd::Point& p) {
+    double d = 1e99;
+    bool inside = false;
+    for (unsigned int i=0;i<ps.segments.size();i++) {
+        const ovd::Point& a = ps.points[ ps.segments[i].first ];
+        const ovd::Point& b = ps.points[ ps.segments[i].second ];
+        d = std::min( d, segment_distance(p,a,b) );
+        if ( ( (a.y > p.y) != (b.y > p.y) ) && ( p.x < (b.x-a.x)*(p.y-a.y)/(b.y-a.y) + a.x ) )
+            inside = !inside;
+    }
+    return inside ? d : -d;
+}
+
+/// \brief check the toolpath \a zz of a tool with \a radius, in the pocket \a ps. return the number of errors
+///
+/// points along all moves must be at least \a radius from the boundary. each point of the pocket that is far
+/// from the boundary must be within half a \a stepover of a pass in the direction \a angle.
+int check_toolpath(const ovd::PolygonSet& ps, const ovd::ZigZagPocket& zz, double radius, double stepover, double angle) {
+    int errors = 0;
+    std::vector< std::pair<ovd::Point,ovd::Point> > passes; // in the frame of the scan-lines
+    ovd::Point dir( cos(angle), sin(angle) );
+    ovd::Point normal( -sin(angle), cos(angle) );
+    unsigned int n_passes = 0;
+    BOOST_FOREACH( const ovd::ZigZagPath& path, zz.paths() ) {
+        n_passes += path.passes;
+        for (unsigned int k=1;k<path.moves.size();k++) {
+            const ovd::OffsetVertex& m = path.moves[k];
+            ovd::Point start = path.moves[k-1].p;
+            double sweep = (m.r > 0) ? ovd::arc_sweep(start, m.p, m.c, m.cw) : 0;
+            for (int i=0;i<=8;i++) {
+                ovd::Point p = start + (i/8.0)*(m.p-start);
+                if (m.r > 0) {
+                    ovd::Point a = start-m.c;
+                    double angle_i = atan2(a.y,a.x) + sweep*i/8.0;
+                    p = m.c + m.r*ovd::Point( cos(angle_i), sin(angle_i) );
+                }
+                if ( clearance(ps,p) < radius*(1-1e-6) )
+                    errors++;
+            }
+            ovd::Point u( start.dot(dir), start.dot(normal) );
+            ovd::Point v( m.p.dot(dir), m.p.dot(normal) );
+            if ( m.r <= 0 && fabs(u.y-v.y) < 1e-12 )
+                passes.push_back( std::make_pair( ovd::Point( std::min(u.x,v.x), u.y ), ovd::Point( std::max(u.x,v.x), u.y ) ) );
+        }
+    }
+    if ( passes.size() < n_passes )
+        errors++;
+    // coverage: sample the pocket on a grid
+    int uncovered = 0, samples = 0;
+    for (int i=-50;i<=50;i++) {
+        for (int j=-50;j<=50;j++) {
+            ovd::Point p(i*0.02, j*0.02);
+            if ( clearance(ps,p) < radius + stepover )
+                continue;
+            samples++;
+            ovd::Point q( p.dot(dir), p.dot(normal) );
+            bool covered = false;
+            for (unsigned int n=0;n<passes.size() && !covered;n++)
+                covered = ( fabs(passes[n].first.y - q.y) <= 0.5*stepover*(1+1e-9) && passes[n].first.x <= q.x && q.x <= passes[n].second.x );
+            if (!covered)
+                uncovered++;
+        }
+    }
+    if ( uncovered || samples == 0 )
+        errors++;
+    std::cout << " " << zz.paths().size() << " cells, " << n_passes << " passes, cut length " << zz.cut_length()
+              << ", rapid length " << zz.rapid_length() << ", " << samples << " samples, " << uncovered << " uncovered\n";
+    return errors;
+}
+
+// zig-zag toolpaths in random pockets with islands
+int main() {
+    std::cout << ovd::version() << "\n";
+    int failures = 0;
+    for (unsigned int seed=1;seed<=3;seed++) {
+        ovd::PolygonGenerator gen(seed);
+        ovd::PolygonSet ps = gen.polygon( ovd::PolygonGenerator::STAR, 100, 4 );
+        ovd::VoronoiDiagram* vd = new ovd::VoronoiDiagram(1);
+        vd->set_silent(true);
+        ps.insert(vd);
+        ovd::polygon_interior_filter pi(true);
+        vd->filter(&pi);
+        ovd::ZigZagPocket zz( vd->get_graph_reference() );
+        double angles[2] = { 0, 0.7 };
+        for (int n=0;n<2;n++) {
+            double radius = 0.01, stepover = 0.015;
+            std::clock_t start = std::clock();
+            zz.run(radius, stepover, angles[n]);
+            double ms = 1000.0*( std::clock()-start )/CLOCKS_PER_SEC;
+            std::cout << "seed " << seed << " angle " << angles[n] << ": " << ms << " ms\n";
+            int errors = check_toolpath(ps, zz, radius, stepover, angles[n]);
+            if (errors) {
+                std::cout << " ERROR: " << errors << " errors in zig-zag toolpath\n";
+                failures++;
+            }
+        }
+        delete vd;
+    }
+    return failures;
+}
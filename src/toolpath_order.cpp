@@ -0,0 +1,367 @@
+/*
+ *  Copyright (c) 2010-2012 Anders Wallin (anders.e.e.wallin "at" gmail.com).
+ *
+ *  This file is part of Openvoronoi
+ *  (see https://github.com/aewallin/openvoronoi).
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+
+#include <boost/foreach.hpp>
+
+#include "toolpath_order.hpp"
+
+namespace ovd
+{
+
+namespace {
+
+/// an end of a path, in the list of ends sorted by x
+struct PathEnd {
+    Point p;           ///< position
+    unsigned int end;  ///< 2*path for the first point of the path, 2*path+1 for the last
+    /// \param pi position \param e end
+    PathEnd(const Point& pi, unsigned int e) : p(pi), end(e) {}
+    /// order by x
+    bool operator<(const PathEnd& other) const { return p.x < other.p.x; }
+};
+
+/// \brief a tour over the paths, improved by 2-opt and Or-opt moves
+///
+/// the ends of path n are numbered 2*n (first point) and 2*n+1 (last point). the start position is
+/// path number n_paths, at position 0 of the tour, and is never moved.
+class Tour {
+public:
+    /// \param f first points \param l last points \param s start position \param r are the paths reversible?
+    Tour(const std::vector<Point>& f, const std::vector<Point>& l, const Point& s, bool r)
+        : first(f), last(l), start(s), reversible(r), n_paths(f.size()), n_neighbours(8) {
+        for (unsigned int n=0;n<n_paths;n++) {
+            ends.push_back( PathEnd( first[n], 2*n ) );
+            ends.push_back( PathEnd( last[n], 2*n+1 ) );
+        }
+        std::sort( ends.begin(), ends.end() );
+    }
+    /// \brief the nearest-neighbour tour: from the start, to the nearest end of a path not yet cut
+    ///
+    /// the search goes out in both directions from the x of the current position,
+    /// until the distance in x alone is larger than the best found.
+    void greedy() {
+        std::vector<char> done( n_paths, false );
+        item.assign( 1, n_paths );
+        rev.assign( 1, false );
+        Point position = start;
+        for (unsigned int n=0;n<n_paths;n++) {
+            double best_dist = -1;
+            unsigned int best = 0;
+            std::size_t s = std::lower_bound( ends.begin(), ends.end(), PathEnd(position,0) ) - ends.begin();
+            for (std::size_t i=s; i<ends.size(); i++) { // to the right
+                if ( best_dist >= 0 && ends[i].p.x - position.x > best_dist )
+                    break;
+                nearest( ends[i], position, done, best_dist, best );
+            }
+            for (std::size_t i=s; i-- > 0; ) { // to the left
+                if ( best_dist >= 0 && position.x - ends[i].p.x > best_dist )
+                    break;
+                nearest( ends[i], position, done, best_dist, best );
+            }
+            done[ best/2 ] = true;
+            item.push_back( best/2 );
+            rev.push_back( best & 1 ); // entered at the last point
+            position = point( out_end( item.size()-1 ) );
+        }
+        pos.resize( n_paths+1 );
+        update_positions( 0, item.size() );
+    }
+    /// \brief apply improving moves until none is found, or until \a seconds have passed
+    ///
+    /// the time is counted from after the neighbour search.
+    /// \return the number of moves applied
+    unsigned int improve(double seconds) {
+        find_neighbours();
+        std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() +
+            std::chrono::duration_cast<std::chrono::steady_clock::duration>( std::chrono::duration<double>(seconds) );
+        unsigned int moves = 0;
+        bool improved = true;
+        while ( improved && std::chrono::steady_clock::now() < deadline ) {
+            improved = false;
+            for (unsigned int k=1;k<item.size();k++) {
+                if ( (k % 64) == 0 && std::chrono::steady_clock::now() >= deadline )
+                    break;
+                if ( reversible && two_opt(k) ) {
+                    improved = true;
+                    moves++;
+                }
+                for (unsigned int length=1;length<=3 && k+length<=item.size();length++) {
+                    if ( or_opt(k, length) ) {
+                        improved = true;
+                        moves++;
+                    }
+                }
+            }
+        }
+        return moves;
+    }
+    /// total rapid length of the tour
+    double length() const {
+        double sum = 0;
+        for (unsigned int k=0;k+1<item.size();k++)
+            sum += link(k);
+        return sum;
+    }
+    std::vector<unsigned int> item; ///< the path at each position of the tour
+    std::vector<char> rev;          ///< is the path at each position reversed?
+private:
+    /// if end \a k is closer to \a position than \a best_dist, and may start the next path, make it the best end
+    void nearest(const PathEnd& k, const Point& position, const std::vector<char>& done,
+                 double& best_dist, unsigned int& best) const {
+        if ( done[ k.end/2 ] || ( !reversible && (k.end & 1) ) )
+            return;
+        double d = ( k.p - position ).norm();
+        if ( best_dist < 0 || d < best_dist ) {
+            best_dist = d;
+            best = k.end;
+        }
+    }
+    /// the n_neighbours nearest ends of other paths, of each end, including the start position
+    void find_neighbours() {
+        neighbours.assign( 2*(n_paths+1), std::vector<unsigned int>() );
+        for (unsigned int e=0;e<neighbours.size();e++) {
+            Point p = point(e);
+            std::vector< std::pair<double, unsigned int> > best; // sorted by distance
+            std::size_t s = std::lower_bound( ends.begin(), ends.end(), PathEnd(p,0) ) - ends.begin();
+            for (std::size_t i=s; i<ends.size(); i++) {
+                if ( best.size() == n_neighbours && ends[i].p.x - p.x > best.back().first )
+                    break;
+                keep( ends[i], e, p, best );
+            }
+            for (std::size_t i=s; i-- > 0; ) {
+                if ( best.size() == n_neighbours && p.x - ends[i].p.x > best.back().first )
+                    break;
+                keep( ends[i], e, p, best );
+            }
+            for (unsigned int i=0;i<best.size();i++)
+                neighbours[e].push_back( best[i].second );
+        }
+    }
+    /// add end \a k to the nearest ends \a best of end \a e at \a p, if it is near enough and on another path
+    void keep(const PathEnd& k, unsigned int e, const Point& p,
+              std::vector< std::pair<double, unsigned int> >& best) const {
+        if ( k.end/2 == e/2 )
+            return;
+        std::pair<double, unsigned int> d( (k.p-p).norm(), k.end );
+        if ( best.size() == n_neighbours && !( d < best.back() ) )
+            return;
+        best.insert( std::upper_bound( best.begin(), best.end(), d ), d );
+        if ( best.size() > n_neighbours )
+            best.pop_back();
+    }
+    /// \brief 2-opt: reverse a run of paths, so that a new link goes to a near end
+    ///
+    /// the run is k..j, so that the path before k links to the last point of j, or j..k-1,
+    /// so that the first point of j links to the first point of k.
+    /// the links inside the run are as long as before, as each path is reversed too.
+    bool two_opt(unsigned int k) {
+        BOOST_FOREACH( unsigned int e, neighbours[ out_end(k-1) ] ) {
+            unsigned int j = pos[e/2];
+            if ( j < k || e != out_end(j) )
+                continue;
+            double delta = dist( out_end(k-1), e ) - link(k-1);
+            if ( j+1 < item.size() )
+                delta += dist( in_end(k), in_end(j+1) ) - link(j);
+            if ( delta < -eps ) {
+                reverse(k, j);
+                return true;
+            }
+        }
+        BOOST_FOREACH( unsigned int e, neighbours[ in_end(k) ] ) {
+            unsigned int j = pos[e/2];
+            if ( j == 0 || j >= k || e != in_end(j) )
+                continue;
+            double delta = dist( out_end(j-1), out_end(k-1) ) + dist( e, in_end(k) ) - link(j-1) - link(k-1);
+            if ( delta < -eps ) {
+                reverse(j, k-1);
+                return true;
+            }
+        }
+        return false;
+    }
+    /// \brief Or-opt: move the run of \a length paths at \a k to after a path with an end near one of its ends
+    ///
+    /// the run is moved forward or, if the paths are reversible, reversed. the best such move is applied.
+    bool or_opt(unsigned int k, unsigned int length) {
+        unsigned int k_end = k+length-1; // last position of the run
+        unsigned int e_in = in_end(k), e_out = out_end(k_end);
+        double gain = link(k-1);
+        if ( k_end+1 < item.size() )
+            gain += link(k_end) - dist( out_end(k-1), in_end(k_end+1) );
+        double best_delta = -eps;
+        unsigned int best_p = 0;
+        bool best_reversed = false;
+        for (int side=0;side<2;side++) {
+            BOOST_FOREACH( unsigned int e, neighbours[ side ? e_out : e_in ] ) {
+                unsigned int q = pos[e/2];
+                unsigned int p = ( e == out_end(q) ) ? q : q-1; // insert between p and p+1
+                if ( p+1 >= k && p <= k_end )
+                    continue;
+                bool has_next = ( p+1 < item.size() );
+                double base = has_next ? link(p) : 0;
+                double forward = dist( out_end(p), e_in ) - base;
+                double backward = dist( out_end(p), e_out ) - base;
+                if ( has_next ) {
+                    forward += dist( e_out, in_end(p+1) );
+                    backward += dist( e_in, in_end(p+1) );
+                }
+                if ( forward - gain < best_delta ) {
+                    best_delta = forward - gain;
+                    best_p = p;
+                    best_reversed = false;
+                }
+                if ( reversible && backward - gain < best_delta ) {
+                    best_delta = backward - gain;
+                    best_p = p;
+                    best_reversed = true;
+                }
+            }
+        }
+        if ( best_delta >= -eps )
+            return false;
+        move(k, length, best_p, best_reversed);
+        return true;
+    }
+    /// reverse the paths at positions \a i to \a j
+    void reverse(unsigned int i, unsigned int j) {
+        std::reverse( item.begin()+i, item.begin()+j+1 );
+        std::reverse( rev.begin()+i, rev.begin()+j+1 );
+        for (unsigned int k=i;k<=j;k++)
+            rev[k] = !rev[k];
+        update_positions(i, j+1);
+    }
+    /// move the run of \a length paths at \a k to between \a p and \a p+1, reversed if \a backward
+    void move(unsigned int k, unsigned int length, unsigned int p, bool backward) {
+        std::vector<unsigned int> run_item( item.begin()+k, item.begin()+k+length );
+        std::vector<char> run_rev( rev.begin()+k, rev.begin()+k+length );
+        if ( backward ) {
+            std::reverse( run_item.begin(), run_item.end() );
+            std::reverse( run_rev.begin(), run_rev.end() );
+            for (unsigned int i=0;i<length;i++)
+                run_rev[i] = !run_rev[i];
+        }
+        item.erase( item.begin()+k, item.begin()+k+length );
+        rev.erase( rev.begin()+k, rev.begin()+k+length );
+        unsigned int at = ( p < k ) ? p+1 : p+1-length;
+        item.insert( item.begin()+at, run_item.begin(), run_item.end() );
+        rev.insert( rev.begin()+at, run_rev.begin(), run_rev.end() );
+        update_positions( std::min(k,at), std::max(k,at)+length );
+    }
+    /// set the position of the paths at positions \a i to \a j-1
+    void update_positions(unsigned int i, unsigned int j) {
+        for (unsigned int k=i;k<j;k++)
+            pos[ item[k] ] = k;
+    }
+    /// the end where the path at position \a k starts
+    unsigned int in_end(unsigned int k) const { return 2*item[k] + ( rev[k] ? 1 : 0 ); }
+    /// the end where the path at position \a k ends
+    unsigned int out_end(unsigned int k) const { return 2*item[k] + ( rev[k] ? 0 : 1 ); }
+    /// position of end \a e
+    const Point& point(unsigned int e) const {
+        if ( e/2 == n_paths )
+            return start;
+        return (e & 1) ? last[e/2] : first[e/2];
+    }
+    /// distance between ends \a a and \a b
+    double dist(unsigned int a, unsigned int b) const { return ( point(a)-point(b) ).norm(); }
+    /// length of the rapid after the path at position \a k
+    double link(unsigned int k) const { return dist( out_end(k), in_end(k+1) ); }
+
+    const std::vector<Point>& first; ///< first point of each path
+    const std::vector<Point>& last;  ///< last point of each path
+    Point start;                     ///< the start position
+    bool reversible;                 ///< may paths be reversed?
+    unsigned int n_paths;            ///< number of paths
+    std::size_t n_neighbours;        ///< number of near ends tried for each end
+    std::vector<PathEnd> ends;       ///< the ends of all paths, sorted by x
+    std::vector<unsigned int> pos;   ///< position of each path in the tour
+    std::vector< std::vector<unsigned int> > neighbours; ///< the nearest ends of other paths, of each end
+    static const double eps;         ///< smallest improvement of a move
+};
+
+const double Tour::eps = 1e-12;
+
+} // end anonymous namespace
+
+ToolpathOrder::ToolpathOrder() : start(0,0), budget(1.0), _rapid_before(0), _rapid_after(0), _moves(0) { }
+
+/// \param first the first point of each path
+/// \param last the last point of each path
+/// \param reversible may the paths be cut from the last point to the first?
+void ToolpathOrder::run(const std::vector<Point>& first, const std::vector<Point>& last, bool reversible) {
+    assert( first.size() == last.size() );
+    _rapid_before = 0;
+    Point position = start;
+    for (unsigned int n=0;n<first.size();n++) {
+        _rapid_before += ( first[n]-position ).norm();
+        position = last[n];
+    }
+    Tour tour(first, last, start, reversible);
+    tour.greedy();
+    _moves = tour.improve(budget);
+    _rapid_after = tour.length();
+    path_order.assign( tour.item.begin()+1, tour.item.end() );
+    path_reversed.assign( tour.rev.begin()+1, tour.rev.end() );
+}
+
+/// the chains are reversed by reversing the list of point-lists, and each point-list
+void ToolpathOrder::run(MedialChainList& chains) {
+    std::vector<MedialChainList::iterator> chain;
+    std::vector<Point> first, last;
+    for (MedialChainList::iterator it=chains.begin(); it!=chains.end(); ++it) {
+        assert( !it->empty() && !it->front().empty() && !it->back().empty() );
+        chain.push_back(it);
+        first.push_back( it->front().front().p );
+        last.push_back( it->back().back().p );
+    }
+    run(first, last, true);
+    MedialChainList sorted;
+    for (unsigned int k=0;k<path_order.size();k++) {
+        sorted.splice( sorted.end(), chains, chain[ path_order[k] ] );
+        if ( path_reversed[k] ) {
+            sorted.back().reverse();
+            BOOST_FOREACH( MedialPointList& points, sorted.back() ) {
+                points.reverse();
+            }
+        }
+    }
+    chains.swap(sorted);
+}
+
+/// a MIC-list starts at its first MIC and ends at its last, and is not reversed
+void ToolpathOrder::run(std::vector<medial_axis_pocket::MICList>& components) {
+    std::vector<Point> first, last;
+    BOOST_FOREACH( const medial_axis_pocket::MICList& mics, components ) {
+        assert( !mics.empty() );
+        first.push_back( mics.front().c2 );
+        last.push_back( mics.back().c2 );
+    }
+    run(first, last, false);
+    std::vector<medial_axis_pocket::MICList> sorted( components.size() );
+    for (unsigned int k=0;k<path_order.size();k++)
+        sorted[k].swap( components[ path_order[k] ] );
+    components.swap(sorted);
+}
+
+} // end ovd namespace
+// end file toolpath_order.cpp
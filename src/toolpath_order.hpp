@@ -0,0 +1,83 @@
+/*
+ *  Copyright (c) 2010-2012 Anders Wallin (anders.e.e.wallin "at" gmail.com).
+ *
+ *  This file is part of Openvoronoi
+ *  (see https://github.com/aewallin/openvoronoi).
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <vector>
+
+#include "common/point.hpp"
+#include "medial_axis_walk.hpp"
+#include "medial_axis_pocket.hpp"
+
+namespace ovd
+{
+
+/// \brief order open toolpaths to reduce the rapid moves between them
+///
+/// each path is cut from its first point to its last point, and the tool makes a rapid move
+/// from the last point of one path to the first point of the next. a reversible path may also be cut
+/// from its last point to its first. the order (and the direction) of the paths with the shortest
+/// total rapid length is an asymmetric travelling-salesman problem, which is solved approximately:
+/// - a nearest-neighbour tour, from the start position, over the ends of the paths sorted by x
+/// - improved by 2-opt moves, that reverse a run of paths (only if the paths are reversible)
+/// - and by Or-opt moves, that move a run of one to three paths elsewhere, forward or reversed
+///
+/// the moves are tried only towards the nearest ends of other paths, found once for each end,
+/// and are applied while they shorten the rapids, until no move does or the time budget is used.
+///
+/// the paths are given by their ends with run(), or a MedialChainList from MedialAxisWalk (reversible)
+/// or the MICLists from medial_axis_pocket (not reversible) are reordered in place.
+class ToolpathOrder {
+public:
+    ToolpathOrder();
+    /// the tool position before the first path, the origin by default
+    void set_start(const Point& p) { start = p; }
+    /// \brief largest time spent improving the nearest-neighbour tour, in seconds
+    ///
+    /// the budget covers the 2-opt and Or-opt moves only. the nearest-neighbour tour and the
+    /// neighbour search before the moves are not counted.
+    void set_time_budget(double seconds) { budget = seconds; }
+    /// order paths from \a first[n] to \a last[n]
+    void run(const std::vector<Point>& first, const std::vector<Point>& last, bool reversible);
+    /// order the chains of \a chains, and reverse some of them
+    void run(MedialChainList& chains);
+    /// order the MIC-lists of \a components
+    void run(std::vector<medial_axis_pocket::MICList>& components);
+    /// the paths in machining order, as indices into the input
+    const std::vector<unsigned int>& order() const { return path_order; }
+    /// for each path in order(), true if it is cut from its last point to its first
+    const std::vector<char>& reversed() const { return path_reversed; }
+    /// total rapid length in the input order, from the start position
+    double rapid_before() const { return _rapid_before; }
+    /// total rapid length in order(), from the start position
+    double rapid_after() const { return _rapid_after; }
+    /// number of 2-opt and Or-opt moves applied
+    unsigned int moves() const { return _moves; }
+private:
+    Point start; ///< tool position before the first path
+    double budget; ///< time budget of the 2-opt and Or-opt moves, in seconds
+    std::vector<unsigned int> path_order; ///< output: paths in machining order
+    std::vector<char> path_reversed; ///< output: is the path reversed?
+    double _rapid_before; ///< rapid length of the input order
+    double _rapid_after; ///< rapid length of the output order
+    unsigned int _moves; ///< number of moves applied
+};
+
+} // end ovd namespace
+// end file toolpath_order.hpp
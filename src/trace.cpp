@@ -0,0 +1,169 @@
+/*
+ *  Copyright (c) 2010-2012 Anders Wallin (anders.e.e.wallin "at" gmail.com).
+ *
+ *  This file is part of Openvoronoi
+ *  (see https://github.com/aewallin/openvoronoi).
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <chrono>
+
+#include "trace.hpp"
+
+namespace ovd {
+namespace trace {
+
+namespace {
+
+/// \brief fixed-size ring buffer of events, written by one thread only
+struct ThreadBuffer {
+    /// create buffer for thread \a id, with \a capacity (a power of two) events
+    ThreadBuffer(unsigned int id, std::size_t capacity) : events(capacity), head(0), tid(id) {}
+    /// append an event, overwriting the oldest one if the buffer is full
+    void push(const Event& e) {
+        std::size_t h = head.load(std::memory_order_relaxed);
+        events[ h & (events.size()-1) ] = e;
+        head.store(h+1, std::memory_order_release);
+    }
+    /// number of events held
+    std::size_t size() const {
+        return std::min( head.load(std::memory_order_acquire), events.size() );
+    }
+    std::vector<Event> events;     ///< storage
+    std::atomic<std::size_t> head; ///< number of events pushed so far
+    unsigned int tid;              ///< thread number, in order of first event
+};
+
+/// \brief all thread buffers. buffers are kept until the end of the process,
+/// since a thread may exit before the trace is written.
+struct Registry {
+    ~Registry() {
+        for (unsigned int i=0;i<buffers.size();i++)
+            delete buffers[i];
+    }
+    std::mutex mutex;                   ///< protects buffers
+    std::vector<ThreadBuffer*> buffers; ///< one buffer per thread that has recorded events
+};
+
+Registry& registry() {
+    static Registry r;
+    return r;
+}
+
+std::atomic<bool> trace_enabled(true);
+std::atomic<std::size_t> buffer_size(1<<16);
+const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+thread_local ThreadBuffer* local_buffer = 0;
+
+/// the buffer of the calling thread, created and registered on first use
+ThreadBuffer* thread_buffer() {
+    if (!local_buffer) {
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        local_buffer = new ThreadBuffer( r.buffers.size(), buffer_size.load() );
+        r.buffers.push_back(local_buffer);
+    }
+    return local_buffer;
+}
+
+/// write a string literal as a JSON string
+void write_string(std::ostream& o, const char* s) {
+    o << "\"";
+    for (; *s; ++s) {
+        if ( *s=='"' || *s=='\\' )
+            o << "\\";
+        o << *s;
+    }
+    o << "\"";
+}
+
+} // end anonymous namespace
+
+void set_enabled(bool b) { trace_enabled.store(b); }
+
+bool enabled() { return trace_enabled.load(std::memory_order_relaxed); }
+
+void set_buffer_size(std::size_t n) {
+    std::size_t capacity = 1;
+    while (capacity < n)
+        capacity *= 2;
+    buffer_size.store(capacity);
+}
+
+long long now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now() - epoch ).count();
+}
+
+void record(const char* name, const char* tag, long long start, long long duration) {
+    Event e;
+    e.name = name;
+    e.tag = tag;
+    e.start = start;
+    e.duration = duration;
+    thread_buffer()->push(e);
+}
+
+std::size_t size() {
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    std::size_t n = 0;
+    for (unsigned int i=0;i<r.buffers.size();i++)
+        n += r.buffers[i]->size();
+    return n;
+}
+
+void clear() {
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    for (unsigned int i=0;i<r.buffers.size();i++)
+        r.buffers[i]->head.store(0);
+}
+
+/// events are written as complete ("ph":"X") events, with times in microseconds
+void write_chrome_trace(std::ostream& o) {
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    o << "{\"traceEvents\":[";
+    bool first = true;
+    for (unsigned int i=0;i<r.buffers.size();i++) {
+        const ThreadBuffer* b = r.buffers[i];
+        std::size_t head = b->head.load(std::memory_order_acquire);
+        std::size_t n = b->size();
+        for (std::size_t k=head-n; k<head; k++) { // oldest first
+            const Event& e = b->events[ k & (b->events.size()-1) ];
+            o << (first ? "\n" : ",\n");
+            first = false;
+            o << "{\"name\":";
+            write_string(o, e.name);
+            o << ",\"cat\":\"ovd\",\"ph\":\"X\",\"pid\":1,\"tid\":" << b->tid;
+            o << ",\"ts\":" << e.start/1000 << "." << (e.start%1000)/100 << (e.start%100)/10 << e.start%10;
+            o << ",\"dur\":" << e.duration/1000 << "." << (e.duration%1000)/100 << (e.duration%100)/10 << e.duration%10;
+            if (e.tag) {
+                o << ",\"args\":{\"tag\":";
+                write_string(o, e.tag);
+                o << "}";
+            }
+            o << "}";
+        }
+    }
+    o << "\n],\"displayTimeUnit\":\"ms\"}\n";
+}
+
+} // end trace namespace
+} // end ovd namespace
@@ -0,0 +1,142 @@
+/*
+ *  Copyright (c) 2010-2012 Anders Wallin (anders.e.e.wallin "at" gmail.com).
+ *
+ *  This file is part of Openvoronoi
+ *  (see https://github.com/aewallin/openvoronoi).
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <ostream>
+#include <cstddef>
+
+namespace ovd {
+
+/*!
+ * \namespace ovd::trace
+ * \brief scoped trace events, dumped in Chrome trace JSON format
+ *
+ * Each thread records complete events (name, optional tag, start, duration) into its own
+ * fixed-size ring buffer. Recording takes no locks, only registering a new thread does.
+ * When a buffer is full the oldest events are overwritten.
+ * write_chrome_trace() writes all buffers in the JSON format read by chrome://tracing
+ * and https://ui.perfetto.dev . It should be called while no other thread is recording.
+ *
+ * The library is instrumented with the OVD_TRACE_* macros below, which compile to
+ * nothing unless OVD_TRACE is defined (cmake option OVD_TRACE).
+ * Event names and tags must be string literals (only the pointer is stored).
+ */
+namespace trace {
+
+/// \brief one complete trace event
+struct Event {
+    const char* name; ///< event name
+    const char* tag;  ///< optional tag, written as args.tag. may be null
+    long long start;  ///< start time in nanoseconds, since the first event of the process
+    long long duration; ///< duration in nanoseconds
+};
+
+/// turn recording on/off at run-time. recording is on by default.
+void set_enabled(bool b);
+/// true if events are recorded
+bool enabled();
+/// set the number of events per thread buffer (rounded up to a power of two).
+/// only affects threads that have not recorded any events yet.
+void set_buffer_size(std::size_t n);
+/// nanoseconds since the trace epoch
+long long now();
+/// record a complete event for the calling thread
+void record(const char* name, const char* tag, long long start, long long duration);
+/// number of events currently held in all buffers
+std::size_t size();
+/// drop all recorded events
+void clear();
+/// write all recorded events as Chrome trace JSON
+void write_chrome_trace(std::ostream& o);
+
+/// \brief records an event spanning the life-time of the Scope object
+class Scope {
+public:
+    /// start an event with given \a name and optional \a tag
+    explicit Scope(const char* name, const char* tag=0) : name_(name), tag_(tag), start_( enabled() ? now() : -1 ) {}
+    ~Scope() {
+        if (start_>=0)
+            record(name_, tag_, start_, now()-start_);
+    }
+    /// set the tag, e.g. when the tag is only known at the end of the scope
+    void set_tag(const char* tag) { tag_=tag; }
+private:
+    Scope(); // don't use.
+    Scope(const Scope&);
+    Scope& operator=(const Scope&);
+    const char* name_; ///< event name
+    const char* tag_;  ///< event tag
+    long long start_;  ///< start time, or -1 when not recording
+};
+
+/// \brief records consecutive, non-overlapping step events
+///
+/// next() ends the current step (if any) and starts a new one. the last step ends
+/// when the Steps object goes out of scope, e.g. on an early return.
+class Steps {
+public:
+    Steps() : name_(0), start_(-1) {}
+    ~Steps() { close(); }
+    /// end the current step and start a new step called \a name
+    void next(const char* name) {
+        close();
+        if ( enabled() ) {
+            name_ = name;
+            start_ = now();
+        }
+    }
+private:
+    Steps(const Steps&);
+    Steps& operator=(const Steps&);
+    /// record the current step
+    void close() {
+        if (name_)
+            record(name_, 0, start_, now()-start_);
+        name_ = 0;
+    }
+    const char* name_; ///< name of current step, or null
+    long long start_;  ///< start time of current step
+};
+
+} // end trace namespace
+} // end ovd namespace
+
+#ifdef OVD_TRACE
+#define OVD_TRACE_CONCAT2(a,b) a##b
+#define OVD_TRACE_CONCAT(a,b) OVD_TRACE_CONCAT2(a,b)
+/// trace the enclosing scope
+#define OVD_TRACE_SCOPE(name) ovd::trace::Scope OVD_TRACE_CONCAT(ovd_trace_scope_,__LINE__)(name)
+/// trace the enclosing scope as \a var, so that a tag can be set later with OVD_TRACE_TAG()
+#define OVD_TRACE_NAMED_SCOPE(var,name) ovd::trace::Scope var(name)
+/// set the tag of a named scope
+#define OVD_TRACE_TAG(var,tag) var.set_tag(tag)
+/// declare a sequence of steps
+#define OVD_TRACE_STEPS(var) ovd::trace::Steps var
+/// end the previous step and start a new one
+#define OVD_TRACE_STEP(var,name) var.next(name)
+#else
+#define OVD_TRACE_SCOPE(name)
+#define OVD_TRACE_NAMED_SCOPE(var,name)
+#define OVD_TRACE_TAG(var,tag)
+#define OVD_TRACE_STEPS(var)
+#define OVD_TRACE_STEP(var,name)
+#endif
+
+// end file trace.hpp
@@ -0,0 +1,358 @@
+/*
+ *  Copyright (c) 2010-2012 Anders Wallin (anders.e.e.wallin "at" gmail.com).
+ *
+ *  This file is part of Openvoronoi
+ *  (see https://github.com/aewallin/openvoronoi).
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <cmath>
+
+#include <boost/foreach.hpp>
+#include <boost/random/mersenne_twister.hpp>
+#include <boost/random/uniform_real_distribution.hpp>
+#include <boost/random/uniform_int_distribution.hpp>
+
+#include "voronoidiagram.hpp"
+#include "common/point.hpp"
+
+namespace ovd {
+
+/// \brief a set of closed polygons, ready for insertion into a VoronoiDiagram
+///
+/// loops[0] is the outer boundary, in CCW order. any further loops are islands, in CW order.
+/// with this orientation polygon_interior_filter(true) retains the pocket between
+/// the boundary and the islands.
+struct PolygonSet {
+    std::vector<Point> points;                  ///< point sites
+    std::vector< std::pair<int,int> > segments; ///< line sites, as indices into points
+    std::vector< std::vector<int> > loops;      ///< each polygon as a list of indices into points
+
+    /// append a closed polygon, given as a list of points
+    void add_loop(const std::vector<Point>& pts) {
+        std::vector<int> loop;
+        int first = points.size();
+        for (unsigned int i=0;i<pts.size();i++) {
+            points.push_back( pts[i] );
+            loop.push_back( first+i );
+            segments.push_back( std::make_pair( first+i, first+(i+1)%pts.size() ) );
+        }
+        loops.push_back(loop);
+    }
+    /// insert all point sites, then all line sites into \a vd
+    void insert(VoronoiDiagram* vd) const {
+        std::vector<int> ids;
+        BOOST_FOREACH( const Point& p, points ) {
+            ids.push_back( vd->insert_point_site(p) );
+        }
+        for (unsigned int i=0;i<segments.size();i++)
+            vd->insert_line_site( ids[segments[i].first], ids[segments[i].second] );
+    }
+    /// brute-force O(n^2) test that no two segments intersect, apart from neighbours sharing an endpoint
+    bool is_simple() const {
+        for (unsigned int i=0;i<segments.size();i++) {
+            for (unsigned int j=i+1;j<segments.size();j++) {
+                const std::pair<int,int>& a = segments[i];
+                const std::pair<int,int>& b = segments[j];
+                bool shared = (a.first==b.first || a.first==b.second || a.second==b.first || a.second==b.second);
+                if (shared) {
+                    // neighbours may only touch at the shared endpoint, i.e. they must not overlap.
+                    int pa = (a.first==b.first || a.first==b.second) ? a.second : a.first;
+                    int pb = (b.first==a.first || b.first==a.second) ? b.second : b.first;
+                    int c  = (pa==a.second) ? a.first : a.second;
+                    Point u = points[pa]-points[c];
+                    Point v = points[pb]-points[c];
+                    if ( u.cross(v) == 0 && u.dot(v) > 0 )
+                        return false;
+                } else if ( segments_intersect(points[a.first],points[a.second],points[b.first],points[b.second]) ) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+    /// signed area of loop \a n, positive for CCW loops
+    double area(unsigned int n) const {
+        double a=0;
+        const std::vector<int>& loop = loops[n];
+        for (unsigned int i=0;i<loop.size();i++)
+            a += points[loop[i]].cross( points[ loop[(i+1)%loop.size()] ] );
+        return 0.5*a;
+    }
+    /// true if the closed segments a1-a2 and b1-b2 intersect
+    static bool segments_intersect(const Point& a1, const Point& a2, const Point& b1, const Point& b2) {
+        double d1 = (a2-a1).cross(b1-a1);
+        double d2 = (a2-a1).cross(b2-a1);
+        double d3 = (b2-b1).cross(a1-b1);
+        double d4 = (b2-b1).cross(a2-b1);
+        if ( ((d1>0 && d2<0) || (d1<0 && d2>0)) && ((d3>0 && d4<0) || (d3<0 && d4>0)) )
+            return true;
+        return (d1==0 && on_segment(a1,a2,b1)) || (d2==0 && on_segment(a1,a2,b2)) ||
+               (d3==0 && on_segment(b1,b2,a1)) || (d4==0 && on_segment(b1,b2,a2));
+    }
+    /// for a point p collinear with s1-s2, true if p lies on the segment
+    static bool on_segment(const Point& s1, const Point& s2, const Point& p) {
+        return std::min(s1.x,s2.x) <= p.x && p.x <= std::max(s1.x,s2.x) &&
+               std::min(s1.y,s2.y) <= p.y && p.y <= std::max(s1.y,s2.y);
+    }
+};
+
+/// \brief random simple-polygon generator for tests and benchmarks
+///
+/// all polygons fit within a square of half-width \a radius centered on the origin,
+/// so they can be inserted into a VoronoiDiagram with far-radius 1 for radius<=0.7.
+/// the output depends only on the seed.
+///
+/// methods:
+///  - SPACE_PARTITIONING, random points joined by recursive space partitioning (Auer & Held, "RPG", 1996)
+///  - TWO_OPT, a random permutation of random points, untangled with 2-opt moves (slow, O(n^3) worst case)
+///  - STAR, star-shaped polygon with random angles and radii
+///  - KOCH, randomized Koch snowflake, with 3*4^k vertices for the smallest k that gives at least n vertices
+class PolygonGenerator {
+public:
+    /// polygon generation method
+    enum Method {SPACE_PARTITIONING, TWO_OPT, STAR, KOCH};
+
+    /// create a generator with the given random \a seed
+    PolygonGenerator(unsigned int seed, double radius=0.7) : rng(seed), _radius(radius) {}
+
+    /// a simple polygon with (about) \a n vertices using Method \a m, and \a n_islands islands inside it
+    PolygonSet polygon(Method m, int n, int n_islands=0) {
+        PolygonSet ps;
+        std::vector<Point> boundary;
+        if (m==SPACE_PARTITIONING)
+            boundary = space_partitioning(n);
+        else if (m==TWO_OPT)
+            boundary = two_opt(n);
+        else if (m==STAR)
+            boundary = star(n, Point(0,0), _radius);
+        else
+            boundary = koch(n);
+        if ( signed_area(boundary) < 0 )
+            std::reverse( boundary.begin(), boundary.end() );
+        ps.add_loop(boundary);
+        add_islands(ps, n_islands);
+        return ps;
+    }
+
+    /// star-shaped CCW polygon with n vertices around \a c, vertex distances from \a c in [0.5*r, r]
+    std::vector<Point> star(int n, Point c, double r) {
+        std::vector<Point> pts;
+        for (int i=0;i<n;i++) {
+            double angle = 2*M_PI*( i + uniform(-0.3,0.3) )/n;
+            double rad = uniform(0.5*r, r);
+            pts.push_back( c + Point( rad*cos(angle), rad*sin(angle) ) );
+        }
+        return pts;
+    }
+
+    /// random points, joined into a simple polygon by recursive space partitioning.
+    std::vector<Point> space_partitioning(int n) {
+        std::vector<Point> pts = random_points(n);
+        // the line through the first two points splits the rest into two chains
+        Point a = pts[0];
+        Point b = pts[1];
+        std::vector<Point> left, right;
+        for (unsigned int i=2;i<pts.size();i++) {
+            if ( pts[i].is_right(a,b) )
+                right.push_back(pts[i]);
+            else
+                left.push_back(pts[i]);
+        }
+        std::vector<Point> poly;
+        poly.push_back(a);
+        partition_chain(a,b,right,poly);
+        poly.push_back(b);
+        partition_chain(b,a,left,poly);
+        return poly;
+    }
+
+    /// random points in random order, untangled with 2-opt moves until no two edges cross
+    std::vector<Point> two_opt(int n) {
+        std::vector<Point> pts = random_points(n);
+        bool crossing = true;
+        while (crossing) {
+            crossing = false;
+            for (int i=0;i<n;i++) {
+                for (int j=i+2;j<n;j++) {
+                    if ( i==0 && j==n-1 )
+                        continue; // neighbours
+                    if ( PolygonSet::segments_intersect(pts[i],pts[i+1],pts[j],pts[(j+1)%n]) ) {
+                        std::reverse( pts.begin()+i+1, pts.begin()+j+1 ); // edges (i,j) and (i+1,j+1) replace the crossing pair
+                        crossing = true;
+                    }
+                }
+            }
+        }
+        return pts;
+    }
+
+    /// randomized Koch snowflake with at least \a n vertices.
+    /// each edge is replaced by four edges with an outward bump of random height and position.
+    std::vector<Point> koch(int n) {
+        std::vector<Point> pts;
+        for (int i=0;i<3;i++) {
+            double angle = M_PI/2 + 2*M_PI*i/3;
+            pts.push_back( _radius*Point( cos(angle), sin(angle) ) );
+        }
+        while ( (int)pts.size() < n ) {
+            std::vector<Point> next;
+            for (unsigned int i=0;i<pts.size();i++) {
+                Point p1 = pts[i];
+                Point p2 = pts[(i+1)%pts.size()];
+                Point d = p2-p1;
+                // the outward normal of a CCW polygon is to the right of the edge
+                Point normal = Point(d.y, -d.x);
+                double s = uniform(0.45,0.55); // bump position
+                double h = uniform(0.15,0.28); // bump height, relative to edge length (regular Koch: 0.289)
+                next.push_back( p1 );
+                next.push_back( p1 + (s-1.0/6)*d );
+                next.push_back( p1 + s*d + h*normal );
+                next.push_back( p1 + (s+1.0/6)*d );
+            }
+            pts = next;
+        }
+        // the snowflake is larger than the initial triangle, scale it back to fit
+        double m=0;
+        BOOST_FOREACH(const Point& p, pts) {
+            m = std::max( m, std::max(fabs(p.x),fabs(p.y)) );
+        }
+        for (unsigned int i=0;i<pts.size();i++)
+            pts[i] = (_radius/m)*pts[i];
+        return pts;
+    }
+
+    /// \brief a sheet of \a rows x \a columns separate pockets, each a STAR polygon with \a n vertices and \a n_islands islands
+    ///
+    /// pocket i (row i/columns, column i%columns) is made with seed \a seed + i, scaled by \a scale,
+    /// and centered on a grid with spacing \a pitch around the origin.
+    static PolygonSet sheet(int rows, int columns, double pitch, double scale, unsigned int seed, int n, int n_islands=1) {
+        PolygonSet out;
+        for (int i=0;i<rows*columns;i++) {
+            PolygonGenerator gen(seed+i);
+            PolygonSet ps = gen.polygon(STAR, n, n_islands);
+            Point center( pitch*(i%columns - 0.5*(columns-1)), pitch*(i/columns - 0.5*(rows-1)) );
+            BOOST_FOREACH( const std::vector<int>& loop, ps.loops ) {
+                std::vector<Point> pts;
+                BOOST_FOREACH( int k, loop ) {
+                    pts.push_back( center + scale*ps.points[k] );
+                }
+                out.add_loop(pts);
+            }
+        }
+        return out;
+    }
+
+protected:
+    /// uniform random number in [lo,hi)
+    double uniform(double lo, double hi) {
+        boost::random::uniform_real_distribution<double> d(lo,hi);
+        return d(rng);
+    }
+    /// n uniform random points within the bounding square
+    std::vector<Point> random_points(int n) {
+        std::vector<Point> pts;
+        for (int i=0;i<n;i++)
+            pts.push_back( Point( uniform(-_radius,_radius), uniform(-_radius,_radius) ) );
+        return pts;
+    }
+    /// append to \a poly a chain from \a a to \a b (both excluded) through all points in \a pts.
+    /// all of \a pts lie on the same side of the line a-b.
+    void partition_chain(Point a, Point b, const std::vector<Point>& pts, std::vector<Point>& poly) {
+        if ( pts.empty() )
+            return;
+        boost::random::uniform_int_distribution<int> pick(0, pts.size()-1);
+        int ci = pick(rng);
+        Point c = pts[ci];
+        // a random line through c and a point s on a-b splits the rest into a chain a-c and a chain c-b
+        Point s = a + uniform(0.1,0.9)*(b-a);
+        std::vector<Point> side_a, side_b;
+        for (unsigned int i=0;i<pts.size();i++) {
+            if ( (int)i == ci )
+                continue;
+            if ( pts[i].is_right(s,c) == a.is_right(s,c) )
+                side_a.push_back(pts[i]);
+            else
+                side_b.push_back(pts[i]);
+        }
+        partition_chain(a,c,side_a,poly);
+        poly.push_back(c);
+        partition_chain(c,b,side_b,poly);
+    }
+    /// add up to \a n star-shaped CW islands inside the boundary loops[0], not touching the boundary or each other.
+    void add_islands(PolygonSet& ps, int n) {
+        std::vector< std::pair<Point,double> > discs; // existing islands, as (center,radius)
+        int tries = 0;
+        while ( (int)discs.size() < n && tries < 100*n ) {
+            tries++;
+            Point c( uniform(-_radius,_radius), uniform(-_radius,_radius) );
+            if ( !inside(ps, c) )
+                continue;
+            double clearance = boundary_distance(ps, c);
+            typedef std::pair<Point,double> Disc;
+            BOOST_FOREACH( const Disc& d, discs ) {
+                clearance = std::min( clearance, (c-d.first).norm() - d.second );
+            }
+            double r = std::min( 0.5*clearance, 0.2*_radius );
+            if ( r < 0.01*_radius )
+                continue;
+            std::vector<Point> island = star( 8, c, r );
+            std::reverse( island.begin(), island.end() ); // islands are CW
+            ps.add_loop( island );
+            discs.push_back( std::make_pair(c,r) );
+        }
+    }
+    /// point-in-polygon test against the boundary loops[0] (crossing number)
+    bool inside(const PolygonSet& ps, const Point& p) const {
+        bool in = false;
+        const std::vector<int>& loop = ps.loops[0];
+        for (unsigned int i=0;i<loop.size();i++) {
+            const Point& a = ps.points[loop[i]];
+            const Point& b = ps.points[loop[(i+1)%loop.size()]];
+            if ( (a.y > p.y) != (b.y > p.y) && p.x < a.x + (p.y-a.y)*(b.x-a.x)/(b.y-a.y) )
+                in = !in;
+        }
+        return in;
+    }
+    /// distance from p to the closest boundary segment
+    double boundary_distance(const PolygonSet& ps, const Point& p) const {
+        double d = 2*_radius*sqrt(2.0);
+        const std::vector<int>& loop = ps.loops[0];
+        for (unsigned int i=0;i<loop.size();i++) {
+            const Point& a = ps.points[loop[i]];
+            const Point& b = ps.points[loop[(i+1)%loop.size()]];
+            double t = std::max(0.0, std::min(1.0, (p-a).dot(b-a)/(b-a).dot(b-a) ) );
+            d = std::min( d, (p - (a + t*(b-a))).norm() );
+        }
+        return d;
+    }
+    /// signed area, positive for CCW
+    static double signed_area(const std::vector<Point>& pts) {
+        double a=0;
+        for (unsigned int i=0;i<pts.size();i++)
+            a += pts[i].cross( pts[(i+1)%pts.size()] );
+        return 0.5*a;
+    }
+
+    boost::random::mt19937 rng; ///< random number generator
+    double _radius;             ///< half-width of the bounding square
+};
+
+} // end namespace
+// end file polygon_generator.hpp
@@ -23,6 +23,7 @@
 
 #include "voronoidiagram.hpp"
 #include "common/point.hpp"
+#include "edge_sampler.hpp"
 
 #include <boost/foreach.hpp>
 
@@ -44,7 +45,7 @@ inline double scale(double d) {
 }
 
 inline svg::Color get_edge_color(ovd::HEGraph& g, ovd::HEEdge e) {
-    if ( g[e].type == ovd::LINESITE )
+    if ( g[e].type == ovd::LINESITE || g[e].type == ovd::ARCSITE )
         return svg::Color::Yellow;
     if ( g[e].type == ovd::PARABOLA )
         return svg::Color::Cyan;
@@ -115,15 +116,30 @@ inline void write_edge_to_svg(ovd::HEGraph& g, svg::Document& doc, ovd::HEEdge e
         ) {
         // edge drawn as two points
         polyline << svg::Point( src_p.x, src_p.y) << svg::Point( trg_p.x, trg_p.y );
-    } else if ( g[e].type == ovd::PARABOLA ) { 
-        double t_src = g[src].dist();
-        double t_trg = g[trg].dist();
-        double t_min = std::min(t_src,t_trg);
-        double t_max = std::max(t_src,t_trg);
+    } else if ( g[e].type == ovd::ARCSITE ) {
+        // the face is to the left of the edge, so the edge turns cw on the outside (k=+1) of the arc
+        ovd::Site* s = g[ g[e].face ].site;
+        ovd::Point c( s->x(), s->y() );
+        ovd::Point u = g[src].position - c;
+        ovd::Point v = g[trg].position - c;
+        double a = atan2( u.cross(v), u.dot(v) ); // ccw angle from src to trg
+        if ( s->k() == 1 && a > 0 )
+            a -= 2*PI;
+        else if ( s->k() == -1 && a < 0 )
+            a += 2*PI;
         int nmax=40;
         for (int n=0;n<nmax;n++) {
-            double t = t_min + ((t_max-t_min)/((nmax-1)*(nmax-1)))*n*n;
-            ovd::Point pt = scale( g[e].point(t) );
+            double an = a*n/(nmax-1);
+            ovd::Point pt = scale( c + ovd::Point( cos(an)*u.x - sin(an)*u.y, sin(an)*u.x + cos(an)*u.y ) );
+            polyline <<  svg::Point(pt.x, pt.y) ;
+        }
+    } else if ( g[e].type == ovd::PARABOLA || g[e].type == ovd::ELLIPSE || g[e].type == ovd::HYPERBOLA ) { 
+        // at most a fifth of a pixel from the edge
+        ovd::EdgeSampler sampler( 0.2/scale(1.0) );
+        ovd::MedialPointList points;
+        sampler.sample(g, e, points);
+        BOOST_FOREACH( const ovd::MedialPoint& mp, points ) {
+            ovd::Point pt = scale( mp.p );
             polyline <<  svg::Point(pt.x, pt.y) ;
         }
     }
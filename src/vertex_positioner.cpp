@@ -25,6 +25,7 @@
 #include "vertex_positioner.hpp"
 #include "voronoidiagram.hpp"
 #include "common/numeric.hpp"
+#include "trace.hpp"
 
 #include "solvers/solver_ppp.hpp"
 #include "solvers/solver_lll.hpp"
@@ -48,6 +49,7 @@ VertexPositioner::VertexPositioner(HEGraph& gi): g(gi) {
     alt_sep_solver =  new solvers::ALTSEPSolver();
     lll_para_solver = new solvers::LLLPARASolver();
     silent = false;
+    solver_name = "";
     solver_debug(false);
     errstat.clear();
 }
@@ -76,6 +78,7 @@ VertexPositioner::~VertexPositioner() {
 /// - site to the right of HEEdge e
 /// - the given new Site s
 solvers::Solution VertexPositioner::position(HEEdge e, Site* s3) {
+    OVD_TRACE_NAMED_SCOPE(trace_scope,"position");
     edge = e;
     HEFace face = g[e].face;     
     HEEdge twin = g[e].twin;
@@ -92,6 +95,7 @@ solvers::Solution VertexPositioner::position(HEEdge e, Site* s3) {
     Site* s2 = g[twin_face].site;
 
     solvers::Solution sl = position(  s1 , g[e].k, s2, g[twin].k, s3 );
+    OVD_TRACE_TAG(trace_scope,solver_name);
 
     assert( solution_on_edge(sl) );
     //assert( check_far_circle(sl) );
@@ -172,11 +176,13 @@ solvers::Solution VertexPositioner::position(Site* s1, double k1, Site* s2, doub
             double err = std::max(std::abs(d1-d2), std::max(std::abs(d2-d3), std::abs(d3-d1)));
             double mindist = std::min(d1, std::min(d2, d3));
             if (err/mindist > 0.01) {
-                std::cout << "VertexPositioner::position() Warning:\n";
-                std::cout << " Solution "<<i<<" violates equidistance constraint. Distances of solution were:\n";
-                std::cout << "  p-s1: "<<sqrt(d1)<<"\n";
-                std::cout << "  p-s2: "<<sqrt(d2)<<"\n";
-                std::cout << "  p-s3: "<<sqrt(d3)<<"\n";
+                if (!silent) {
+                    std::cout << "VertexPositioner::position() Warning:\n";
+                    std::cout << " Solution "<<i<<" violates equidistance constraint. Distances of solution were:\n";
+                    std::cout << "  p-s1: "<<sqrt(d1)<<"\n";
+                    std::cout << "  p-s2: "<<sqrt(d2)<<"\n";
+                    std::cout << "  p-s3: "<<sqrt(d3)<<"\n";
+                }
             }
             else {
                 equidistant_solutions.push_back(s);
@@ -281,6 +287,7 @@ solvers::Solution VertexPositioner::position(Site* s1, double k1, Site* s2, doub
 
 /// search numerically for a desperate solution along the solution-edge
 solvers::Solution VertexPositioner::desperate_solution(Site* s3) {
+    solver_name = "desperate";
     VertexError err_functor(g, edge, s3);
     //HEFace face = g[edge].face;     
     //HEEdge twin = g[edge].twin;
@@ -338,6 +345,9 @@ solvers::Solution VertexPositioner::desperate_solution(Site* s3) {
         } else {
             desp_k3 = (s3->k()==1) ? 1 : -1;
         }
+    } else if ( s3->isArc() ) {
+        // outside or inside the circle
+        desp_k3 = ( (p_sln - Point(s3->x(),s3->y())).norm() > s3->r() ) ? 1 : -1;
     }
     solvers::Solution desp( p_sln, t_sln, desp_k3 ); 
     return desp;
@@ -371,10 +381,10 @@ int VertexPositioner::solver_dispatch(Site* s1, double k1,
 
 
     if ( g[edge].type == SEPARATOR ) {
-        // this is a SEPARATOR edge with two LineSites adjacent.
+        // this is a SEPARATOR edge with two LineSites (or ArcSites) adjacent.
         // find the PointSite that defines the SEPARATOR, so that one LineSite and one PointSite
         // can be submitted to the Solver.
-        if ( s1->isLine() && s2->isLine() ) {
+        if ( !s1->isPoint() && !s2->isPoint() ) {
             // the parallel lineseg case      v0 --s1 --> pt -- s2 --> v1
             // find t
             if ( g[edge].has_null_face ) {
@@ -386,8 +396,8 @@ int VertexPositioner::solver_dispatch(Site* s1, double k1,
                 assert( s2->isPoint() );
                 k2 = +1;
             }
-        } else if ( s1->isPoint() && s2->isLine() ) {
-            // a normal SEPARATOR edge, defined by a PointSite and a LineSite 
+        } else if ( s1->isPoint() && !s2->isPoint() ) {
+            // a normal SEPARATOR edge, defined by a PointSite and a LineSite (or ArcSite)
             // swap sites, so SEPSolver can assume s1=line s2=point
             Site* tmp = s1;
             double k_tmp = k1;
@@ -395,42 +405,50 @@ int VertexPositioner::solver_dispatch(Site* s1, double k1,
             s2 = tmp;
             k1 = k2;
             k2 = k_tmp;
-            assert( s1->isLine() );
+            assert( !s1->isPoint() );
             assert( s2->isPoint() );
         }
-        assert( s1->isLine() && s2->isPoint() ); // we have previously set s1(line) s2(point)
+        assert( !s1->isPoint() && s2->isPoint() ); // we have previously set s1(line) s2(point)
+        solver_name = "sep";
         return sep_solver->solve(s1,k1,s2,k2,s3,k3,solns); 
     } else if ( g[edge].type == PARA_LINELINE  && s3->isLine() ) { // an edge betwee parallel LineSites
         //std::cout << " para lineline! \n";
+        solver_name = "lll_para";
         return lll_para_solver->solve( s1,k1,s2,k2,s3,k3, solns );
-    } else if ( s1->isLine() && s2->isLine() && s3->isLine() ) 
+    } else if ( s1->isLine() && s2->isLine() && s3->isLine() ) {
+        solver_name = "lll";
         return lll_solver->solve( s1,k1,s2,k2,s3,k3, solns ); // all lines.
-    else if ( s1->isPoint() && s2->isPoint() && s3->isPoint() )
+    } else if ( s1->isPoint() && s2->isPoint() && s3->isPoint() ) {
+        solver_name = "ppp";
         return ppp_solver->solve( s1,1,s2,1,s3,1, solns ); // all points, no need to specify k1,k2,k3, they are all +1
-    else if ( (s3->isLine() && s1->isPoint() ) || 
+    } else if ( (s3->isLine() && s1->isPoint() ) || 
               (s1->isLine() && s3->isPoint() ) ||
               (s3->isLine() && s2->isPoint() ) ||
-              (s2->isLine() && s3->isPoint() ) // bad coverage for this line?
+              (s2->isLine() && s3->isPoint() ) || // bad coverage for this line?
+              (s3->isArc() && (s1->isPoint() || s2->isPoint()) )
             ) {
         // if s1/s2 form a SEPARATOR-edge, this is dispatched automatically to sep-solver
         // here we detect for a separator case between
         // s1/s3
         // s2/s3
-        if (s3->isLine() && s1->isPoint() ) {
+        if (!s3->isPoint() && s1->isPoint() ) {
             if ( detect_sep_case(s3,s1) ) {
                 alt_sep_solver->set_type(0);
+                solver_name = "alt_sep";
                 return alt_sep_solver->solve(s1, k1, s2, k2, s3, k3, solns );
             }
         }
-        if (s3->isLine() && s2->isPoint() ) {
+        if (!s3->isPoint() && s2->isPoint() ) {
             if ( detect_sep_case(s3,s2) ) {
                 alt_sep_solver->set_type(1);
+                solver_name = "alt_sep";
                 return alt_sep_solver->solve(s1, k1, s2, k2, s3, k3, solns );
             }
         }
     } 
     
     // if we didn't dispatch to a solver above, we try the general solver
+    solver_name = "qll";
     return qll_solver->solve( s1,k1,s2,k2,s3,k3, solns ); // general case solver
     
 }
@@ -108,6 +108,7 @@ private:
     HEEdge edge;  ///< the edge on which we position a new vertex
     std::vector<double> errstat; ///< error-statistics
     bool silent; ///< silent mode (outputs no warnings to stdout)
+    const char* solver_name; ///< name of the solver used for the last position() call, for tracing
 };
 
 /// \brief error functor for edge-based desperate solver
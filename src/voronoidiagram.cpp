@@ -28,6 +28,7 @@
 #include "voronoidiagram.hpp"
 
 #include "checker.hpp"
+#include "trace.hpp"
 #include "common/numeric.hpp" // for diangle
 
 namespace ovd {
@@ -40,6 +41,7 @@ VoronoiDiagram::VoronoiDiagram(double far) {
     vpos = new VertexPositioner( g ); // helper-class that positions vertices
     
     far_radius=far;
+    site_bytes=0;
     initialize();
     num_psites=3;
     num_lsites=0;
@@ -95,6 +97,7 @@ void VoronoiDiagram::initialize() {
     HEEdge e3_2 =  g.add_edge( a2 , v00 ); 
     HEFace f1   =  g.add_face(); 
     g[f1].site  = new PointSite(gen3,f1, vert3);
+    site_bytes += sizeof(PointSite);
     g[f1].status = NONINCIDENT;
     //fgrid->add_face( f1, gen3 ); // for grid search
     kd_tree->insert( kd_point(gen3,f1) );
@@ -108,6 +111,7 @@ void VoronoiDiagram::initialize() {
     HEEdge e6_2 = g.add_edge( a3, v00 ); 
     HEFace f2   =  g.add_face();
     g[f2].site  = new PointSite(gen1,f2, vert1);
+    site_bytes += sizeof(PointSite);
     g[f2].status = NONINCIDENT;    
     //fgrid->add_face( f2, gen1 );
     kd_tree->insert( kd_point(gen1,f2) );
@@ -121,6 +125,7 @@ void VoronoiDiagram::initialize() {
     HEEdge e9_2 = g.add_edge( a1 , v00 ); 
     HEFace f3   =  g.add_face();
     g[f3].site  = new PointSite(gen2,f3, vert2); // this constructor needs f3...
+    site_bytes += sizeof(PointSite);
     g[f3].status = NONINCIDENT;    
     //fgrid->add_face( f3, gen2 );
     kd_tree->insert( kd_point(gen2,f3) );
@@ -162,10 +167,12 @@ void VoronoiDiagram::initialize() {
 ///
 /// \param p position of site
 /// \param step (optional, for debugging) stop at this step
-/// \return integer handle to the inserted point. use this integer when inserting lines/arcs with insert_line_site
+/// \return integer handle to the inserted point. use this integer when inserting lines/arcs with insert_line_site.
+///   -1 if an ArcSite has already been inserted, and the point is not inserted.
 ///
 /// \details
 /// \attention All PointSite:s must be inserted before any LineSite:s or ArcSite:s are inserted. 
+///   This is checked for ArcSite:s, as the solvers assume that an ArcSite is the last site at a new vertex.
 /// \attention It is an error to insert duplicate PointSite:s (i.e. points with the same x,y coordinates)
 ///
 /// All PointSite:s must be inserted before any LineSite:s or ArcSite:s are inserted.
@@ -180,7 +187,14 @@ void VoronoiDiagram::initialize() {
 /// step-7 remove IN-IN edges and IN-NEW edges, see remove_vertex_set()
 /// step-8 reset vertex/face status to be ready for next incremental operation, see reset_status()
 int VoronoiDiagram::insert_point_site(const Point& p) {
+    if ( num_asites > 0 ) {
+        std::cout << "openvoronoi error. All points must be inserted before any arcs. You are trying to add p= " << p << "\n";
+        assert( num_asites == 0 );
+        return -1;
+    }
     num_psites++;
+    OVD_TRACE_SCOPE("insert_point_site");
+    OVD_TRACE_STEPS(steps);
     if (p.norm() >= far_radius ) {
         std::cout << "openvoronoi error. All points must lie within unit-circle. You are trying to add p= " << p 
         << " with p.norm()= " << p.norm() << "\n";
@@ -189,31 +203,41 @@ int VoronoiDiagram::insert_point_site(const Point& p) {
     
     HEVertex new_vert = g.add_vertex( VoronoiVertex(p,OUT,POINTSITE) );
     PointSite* new_site =  new PointSite(p);
+    site_bytes += sizeof(PointSite);
     new_site->v = new_vert;
     vertex_map.insert( VertexMapPair(g[new_vert].index,new_vert) ); // so that we can find the descriptor later based on its index
 // step-1
+    OVD_TRACE_STEP(steps,"nearest");
     std::pair<kd_point,bool> nearest = kd_tree->nearest( kd_point(p) ); 
     assert( nearest.second );
 // step-2
+    OVD_TRACE_STEP(steps,"seed_vertex");
     HEVertex v_seed = find_seed_vertex( nearest.first.face , new_site);
     mark_vertex( v_seed, new_site );
 // step-3
+    OVD_TRACE_STEP(steps,"augment_vertex_set");
     augment_vertex_set( new_site ); // grow the tree to maximum size
 // step-4
+    OVD_TRACE_STEP(steps,"add_vertices");
     add_vertices( new_site );  // insert NEW vertices on IN-OUT edges so they becobe IN-NEW-OUT edges
 // step-5
+    OVD_TRACE_STEP(steps,"add_edges");
     HEFace newface = add_face( new_site );
     g[new_vert].face = newface; // Vertices that correspond to point-sites have their .face property set!
     BOOST_FOREACH( HEFace f, incident_faces ) { // add NEW-NEW edges on all INCIDENT faces
         add_edges(newface, f);
     }
 // step-6
+    OVD_TRACE_STEP(steps,"repair_face");
     repair_face( newface  );
     if (debug) { std::cout << " new face: "; g.print_face( newface ); }
 // step-7
+    OVD_TRACE_STEP(steps,"remove_vertex_set");
     remove_vertex_set(); // remove all IN vertices and adjacent edges
 // step-8
+    OVD_TRACE_STEP(steps,"reset_status");
     reset_status(); // reset all vertices to UNDECIDED
+    OVD_TRACE_STEP(steps,"check");
  
     assert( vd_checker->face_ok( newface ) );
     assert( vd_checker->is_valid() );
@@ -226,10 +250,11 @@ int VoronoiDiagram::insert_point_site(const Point& p) {
 /// \param idx1 int handle to startpoint of line-segment
 /// \param idx2 int handle to endpoint of line-segment
 /// \param step (optional, for debug) stop at step
+/// \return false if an ArcSite has already been inserted, and the line is not inserted
 ///
 /// \details
 /// \attention All PointSite:s must be inserted before any LineSite:s are inserted. 
-///   All LineSite:s should be inserted before any ArcSite:s are inserted.
+///   All LineSite:s must be inserted before any ArcSite:s are inserted. This is checked.
 /// \attention It is an error to insert a LineSite that intersects an existing LineSite in the diagram!
 ///
 /// The basic idea of the incremental diagram update is similar to that in insert_point_site().
@@ -253,8 +278,17 @@ int VoronoiDiagram::insert_point_site(const Point& p) {
 /// -# remove ::SPLIT vertices
 /// -# reset vertex/face status to be ready for next incremental operation, see reset_status()
 bool VoronoiDiagram::insert_line_site(int idx1, int idx2, int step) {
+    if ( num_asites > 0 ) {
+        std::cout << "openvoronoi error. All lines must be inserted before any arcs. You are trying to add the line "
+                  << idx1 << " - " << idx2 << "\n";
+        assert( num_asites == 0 );
+        return false;
+    }
     num_lsites++;
     int current_step=1;
+    OVD_TRACE_SCOPE("insert_line_site");
+    OVD_TRACE_STEPS(steps);
+    OVD_TRACE_STEP(steps,"find_endpoints");
     // find the vertices corresponding to idx1 and idx2
     HEVertex start=HEVertex(), end=HEVertex();
     boost::tie(start,end) = find_endpoints(idx1,idx2);
@@ -290,11 +324,13 @@ bool VoronoiDiagram::insert_line_site(int idx1, int idx2, int step) {
     pos_site = new LineSite( g[end  ].position, g[start].position , +1);
     neg_site = new LineSite( g[start].position, g[end  ].position , -1);
     //}
+    site_bytes += 2*sizeof(LineSite);
 
     if (step==current_step) 
         return false;
     current_step++;
 
+    OVD_TRACE_STEP(steps,"seed_vertex");
     HEFace seed_face = g[start].face; // assumes this point-site has a face!
     
     // on the face of start-point, find the seed vertex
@@ -306,6 +342,7 @@ bool VoronoiDiagram::insert_line_site(int idx1, int idx2, int step) {
         return false; 
     current_step++;
 
+    OVD_TRACE_STEP(steps,"augment_vertex_set");
     augment_vertex_set( pos_site  ); // it should not matter if we use pos_site or neg_site here
     // todo(?) sanity checks:
     // check that end_face is INCIDENT? 
@@ -316,6 +353,7 @@ bool VoronoiDiagram::insert_line_site(int idx1, int idx2, int step) {
         return false; 
     current_step++;
 
+    OVD_TRACE_STEP(steps,"null_faces");
     // process the null-faces here
     HEVertex seg_start, seg_end; // new segment end-point vertices. these are created here.
     HEFace start_null_face, end_null_face; // either existing or new null-faces at endpoints
@@ -342,6 +380,7 @@ bool VoronoiDiagram::insert_line_site(int idx1, int idx2, int step) {
         return false; 
     current_step++;
     
+    OVD_TRACE_STEP(steps,"site_edges");
     // create LINESITE pseudo edges and faces
     HEFace pos_face, neg_face; 
     HEEdge pos_edge, neg_edge;
@@ -379,12 +418,14 @@ bool VoronoiDiagram::insert_line_site(int idx1, int idx2, int step) {
         return false; 
     current_step++;
 
+    OVD_TRACE_STEP(steps,"add_vertices");
     add_vertices( pos_site );  // add NEW vertices on all IN-OUT edges.
 
     if (step==current_step) 
         return false; 
     current_step++;
 
+    OVD_TRACE_STEP(steps,"separators");
     { // add SEPARATORS
         // find SEPARATOR targets first
         typedef boost::tuple<HEEdge, HEVertex, HEEdge,bool> SepTarget;
@@ -430,6 +471,7 @@ bool VoronoiDiagram::insert_line_site(int idx1, int idx2, int step) {
         return false; 
     current_step++;
 
+    OVD_TRACE_STEP(steps,"add_edges");
 // add non-separator edges by calling add_edges on all INCIDENT faces
     {
         if(debug) std::cout << "adding edges.\n";
@@ -449,6 +491,7 @@ bool VoronoiDiagram::insert_line_site(int idx1, int idx2, int step) {
         return false; 
     current_step++;
 
+    OVD_TRACE_STEP(steps,"remove_vertex_set");
 // new vertices and edges inserted. remove the delete-set, repair faces.
 
     remove_vertex_set();
@@ -470,12 +513,13 @@ bool VoronoiDiagram::insert_line_site(int idx1, int idx2, int step) {
         return false; 
     current_step++;
 
+    OVD_TRACE_STEP(steps,"remove_split_vertex");
     // we are done and can remove split-vertices
     BOOST_FOREACH(HEFace f, incident_faces) {
         remove_split_vertex(f);
     }
     reset_status();
-
+    OVD_TRACE_STEP(steps,"check");
 
     assert( vd_checker->face_ok( start_null_face ) );
     assert( vd_checker->face_ok( end_null_face ) );
@@ -487,6 +531,16 @@ bool VoronoiDiagram::insert_line_site(int idx1, int idx2, int step) {
 }
 
 /// \brief insert a circular arc Site into the diagram
+///
+/// the end-points must already be inserted as point-sites. arcs must be inserted after all point- and
+/// line-sites: insert_point_site() and insert_line_site() refuse new sites once an arc is inserted.
+///
+/// an arc may be tangent to the adjacent line or arc at an end-point, e.g. a fillet between two lines,
+/// or the half-circle end of a slot. the separator of the arc then runs along the separator of its neighbour,
+/// and several voronoi-vertices meet at the arc center, or along the shared separator, with a clearance-disk
+/// that touches the arc exactly. augment_vertex_set() keeps such vertices OUT of the delete-tree,
+/// remove_center_apex() removes an apex at the center before the insertion, and remove_center_vertices()
+/// joins the separators to a single vertex at the center afterwards.
 /// \param idx1 index of start vertex
 /// \param idx2 index of end vertex
 /// \param center center Point of arc
@@ -495,6 +549,9 @@ bool VoronoiDiagram::insert_line_site(int idx1, int idx2, int step) {
 void VoronoiDiagram::insert_arc_site(int idx1, int idx2, const Point& center, bool cw, int step) {
     num_asites++;
     int current_step=1;
+    OVD_TRACE_SCOPE("insert_arc_site");
+    OVD_TRACE_STEPS(steps);
+    OVD_TRACE_STEP(steps,"find_endpoints");
     // find the vertices corresponding to idx1 and idx2
     HEVertex start=HEVertex(), end=HEVertex();
     boost::tie(start,end) = find_endpoints(idx1,idx2);
@@ -514,15 +571,10 @@ void VoronoiDiagram::insert_arc_site(int idx1, int idx2, const Point& center, bo
         return; 
     current_step++;
     
-    ArcSite* pos_site;
-    ArcSite* neg_site;
-    if (cw) {
-        pos_site = new ArcSite( g[end  ].position, g[start].position , center, cw);
-        neg_site = new ArcSite( g[start].position, g[end  ].position , center, !cw);
-    } else {
-        pos_site = new ArcSite( g[start].position, g[end].position , center, !cw);
-        neg_site = new ArcSite( g[end].position, g[start].position , center, cw);
-    }
+    // the pos_site is on the outside (k=+1) and the neg_site on the inside (k=-1) of the arc
+    ArcSite* pos_site = new ArcSite( g[start].position, g[end].position , center, cw, +1);
+    ArcSite* neg_site = new ArcSite( g[start].position, g[end].position , center, cw, -1);
+    site_bytes += 2*sizeof(ArcSite);
     
     if (debug) {
         std::cout << " pos site =  " << pos_site->str2() << "\n";
@@ -533,6 +585,9 @@ void VoronoiDiagram::insert_arc_site(int idx1, int idx2, const Point& center, bo
         return; 
     current_step++;
 
+    OVD_TRACE_STEP(steps,"seed_vertex");
+    remove_center_apex( g[start].face, center );
+    remove_center_apex( g[end].face, center );
     HEFace seed_face = g[start].face; // assumes this point-site has a face!
     // on the face of start-point, find the seed vertex
     HEVertex v_seed = find_seed_vertex(seed_face, pos_site ) ;
@@ -543,6 +598,7 @@ void VoronoiDiagram::insert_arc_site(int idx1, int idx2, const Point& center, bo
         return; 
     current_step++;
     
+    OVD_TRACE_STEP(steps,"augment_vertex_set");
     augment_vertex_set( pos_site  ); // it should not matter if we use pos_site or neg_site here
     // todo(?) sanity checks:
     // check that end_face is INCIDENT? 
@@ -553,6 +609,7 @@ void VoronoiDiagram::insert_arc_site(int idx1, int idx2, const Point& center, bo
         return; 
     current_step++;
     
+    OVD_TRACE_STEP(steps,"null_faces");
     // process the null-faces here
     HEVertex seg_start, seg_end; // new segment end-point vertices. these are created here.
     HEFace start_null_face, end_null_face; // either existing or new null-faces at endpoints
@@ -567,13 +624,13 @@ void VoronoiDiagram::insert_arc_site(int idx1, int idx2, const Point& center, bo
 
     Point left = 0.5*(src_se+trg_se) + (trg_se-src_se).xy_perp(); // this is used below and in find_null_face()
     // returns new seg_start/end vertices, new or existing null-faces, and separator endpoints (if separators should be added)
-    Point dir1,dir2;
+    // dir1 is the tangent of the arc at start, pointing into the arc.
+    // dir2 is the tangent at end, pointing back into the arc.
+    Point dir1 = (g[start].position - center).xy_perp();
+    Point dir2 = -1*(g[end].position - center).xy_perp();
     if (cw) {
-        dir1 = (g[start].position - center).xy_perp();
-        dir2 = -1*(g[end].position - center).xy_perp();
-    } else {
-        dir1 = -1*(g[start].position - center).xy_perp();
-        dir2 = (g[end].position - center).xy_perp();
+        dir1 = -1*dir1;
+        dir2 = -1*dir2;
     }
     if (debug) std::cout << "find_null_face( " << g[start].index << " )\n";
     
@@ -592,30 +649,32 @@ void VoronoiDiagram::insert_arc_site(int idx1, int idx2, const Point& center, bo
         return;
     current_step++;
 
+    OVD_TRACE_STEP(steps,"site_edges");
     // create pseudo edges (sites) and faces
     HEFace pos_face, neg_face; 
     HEEdge pos_edge, neg_edge;
     {
-        if (cw)
+        // the outside of a CW arc is to the left of start->end
+        if (cw) {
+            boost::tie( pos_edge, neg_edge) = g.add_twin_edges( seg_start, seg_end );
+            g[pos_edge].inserted_direction = true;
+            g[neg_edge].inserted_direction = false;
+        } else {
             boost::tie( pos_edge, neg_edge) = g.add_twin_edges( seg_end  ,seg_start );
-        else
-            boost::tie( neg_edge, pos_edge) = g.add_twin_edges( seg_end  ,seg_start );
-
-        g[pos_edge].inserted_direction = false;
-        g[neg_edge].inserted_direction = true;
+            g[pos_edge].inserted_direction = false;
+            g[neg_edge].inserted_direction = true;
+        }
         g[pos_edge].type = ARCSITE;
         g[neg_edge].type = ARCSITE;
         g[pos_edge].k = +1;
         g[neg_edge].k = -1;
-        pos_face = add_face( pos_site ); //  this face to the left of start->end edge    
-        neg_face = add_face( neg_site ); //  this face is to the left of end->start edge
+        pos_face = add_face( pos_site ); //  this face to the left of pos_edge
+        neg_face = add_face( neg_site ); //  this face is to the left of neg_edge
         g[pos_face].edge = pos_edge;
         g[neg_face].edge = neg_edge;
         g[pos_edge].face = pos_face;
         g[neg_edge].face = neg_face;
         
-        //if (debug) std::cout << "created ARCSITE edge " << g[seg_end].index << " -[f" <<  << "]- << g[seg_start].index << "\n";  
-        
         // associate sites with ARCSITE edges
         pos_site->e = pos_edge;
         neg_site->e = neg_edge;
@@ -627,12 +686,14 @@ void VoronoiDiagram::insert_arc_site(int idx1, int idx2, const Point& center, bo
         return; 
     current_step++;
 
+    OVD_TRACE_STEP(steps,"add_vertices");
     add_vertices( pos_site );  // add NEW vertices on all IN-OUT edges.
     
     if (step==current_step) 
         return; 
     current_step++;
 
+    OVD_TRACE_STEP(steps,"separators");
     { // add SEPARATORS
     
         // find SEPARATOR targets first
@@ -679,6 +740,7 @@ void VoronoiDiagram::insert_arc_site(int idx1, int idx2, const Point& center, bo
         return; 
     current_step++;
     
+    OVD_TRACE_STEP(steps,"add_edges");
 // add non-separator edges by calling add_edges on all INCIDENT faces
     {
         if(debug) std::cout << "adding edges.\n";
@@ -698,6 +760,7 @@ void VoronoiDiagram::insert_arc_site(int idx1, int idx2, const Point& center, bo
         return; 
     current_step++;
 
+    OVD_TRACE_STEP(steps,"remove_vertex_set");
 // new vertices and edges inserted. remove the delete-set, repair faces.
 
     remove_vertex_set();
@@ -719,12 +782,14 @@ void VoronoiDiagram::insert_arc_site(int idx1, int idx2, const Point& center, bo
         return; 
     current_step++;
 
+    OVD_TRACE_STEP(steps,"remove_split_vertex");
     // we are done and can remove split-vertices
     BOOST_FOREACH(HEFace f, incident_faces) {
         remove_split_vertex(f);
     }
+    remove_center_vertices();
     reset_status();
-
+    OVD_TRACE_STEP(steps,"check");
 
     assert( vd_checker->face_ok( start_null_face ) );
     assert( vd_checker->face_ok( end_null_face ) );
@@ -987,7 +1052,9 @@ VoronoiDiagram::find_null_face(HEVertex start, HEVertex other, Point left, Point
     if (new_site->isLine() ) {
         k3_sign = left.is_right( g[start].position , g[other].position); 
     } else if (new_site->isArc()) {
-        k3_sign = Point(new_site->x(),new_site->y()).is_right( g[start].position , g[other].position );
+        // dir is the tangent into the arc. the outside (k=+1) of a CW arc is to the left of
+        // the tangent at the start-point, and to the right of the tangent at the end-point.
+        k3_sign = ( new_site->cw() == (g[start].position == new_site->start()) );
     } else {
         assert(0);
     }
@@ -1290,7 +1357,10 @@ void VoronoiDiagram::augment_vertex_set(  Site* site ) {
         boost::tie( v, h ) = vertexQueue.top();
         assert( g.g[v].status == UNDECIDED );
         vertexQueue.pop(); 
-        if ( h < 0.0 ) { // try to mark IN if h<0 and passes (C4) and (C5) tests and in_region(). otherwise mark OUT
+        // an ArcSite tangent to its neighbour touches the clearance-disks of vertices along the shared separator,
+        // where h is zero up to rounding. those vertices stay OUT, see insert_arc_site()
+        double h_in = site->isArc() ? -1e-9 : 0.0;
+        if ( h < h_in ) { // try to mark IN if h<0 and passes (C4) and (C5) tests and in_region(). otherwise mark OUT
             if ( predicate_c4(v) || !predicate_c5(v) || !site->in_region(g[v].position) ) {
                 g[v].status = OUT; // C4 or C5 violated, so mark OUT
                 if (debug) std::cout << g[v].index << " marked OUT (topo): c4="<< predicate_c4(v) << " c5=" << !predicate_c5(v) << " r=" << !site->in_region(g[v].position) << " h=" << h << "\n";
@@ -1373,7 +1443,7 @@ void VoronoiDiagram::mark_adjacent_faces( HEVertex v, Site* site) {
 
     BOOST_FOREACH( HEFace adj_face, new_adjacent_faces ) {
         if ( g[adj_face].status != INCIDENT ) {
-            if ( site->isLine() )
+            if ( !site->isPoint() )
                 add_split_vertex(adj_face, site);
 
             g[adj_face].status = INCIDENT;
@@ -1429,15 +1499,23 @@ void VoronoiDiagram::add_split_vertex(HEFace f, Site* s) {
     Site* fs = g[f].site;
     
     // don't search for split-vertex on the start or end face
-    if (fs->isPoint() && s->isLine()) {
+    if (fs->isPoint() && !s->isPoint()) {
         if ( fs->position() == s->start() || fs->position() == s->end() ) // FIXME: don't compare Points, instead compare vertex-index!
             return;
     }
         
-    if ( fs->isPoint() && s->isLine() && s->in_region( fs->position() ) ) {
+    if ( fs->isPoint() && !s->isPoint() && s->in_region( fs->position() ) ) {
         // 1) find the correct edge
         Point pt1 = fs->position();
-        Point pt2 = pt1-Point( s->a(), s->b() ); 
+        Point pt2;
+        if ( s->isLine() ) {
+            pt2 = pt1-Point( s->a(), s->b() ); 
+        } else {
+            // the split-line of an ArcSite goes through its center
+            pt2 = Point( s->x(), s->y() );
+            if ( pt1 == pt2 )
+                return;
+        }
         
         assert( (pt1-pt2).norm() > 0 ); 
         
@@ -1446,7 +1524,7 @@ void VoronoiDiagram::add_split_vertex(HEFace f, Site* s) {
         // and trg on the other side of pt1-pt2
         
         BOOST_FOREACH(HEEdge split_edge, split_edges) {
-            if ( (g[split_edge].type == SEPARATOR) || (g[split_edge].type == LINESITE) )
+            if ( (g[split_edge].type == SEPARATOR) || (g[split_edge].type == LINESITE) || (g[split_edge].type == ARCSITE) )
                 return; // don't place split points on linesites or separators(?)
 
             // find a point = src + u*(trg-src)
@@ -1544,6 +1622,73 @@ void VoronoiDiagram::remove_split_vertex(HEFace f) {
     assert( vd_checker->face_ok( f ) );
 }
 
+/// \brief remove the ::APEX vertices at the center \a c of an ArcSite, next to another vertex at the center
+///
+/// the bisector of the end-points of a half-circle has its apex at the center. where the arc is tangent to
+/// its neighbours, voronoi-vertices lie at the center too (see remove_center_vertices()), and the apex splits
+/// an edge that already ends at the center, or an edge of zero length. in_circle() cannot decide such an apex,
+/// as it is equally far from all points of the arc. the clearance along the edge is smallest at the vertex
+/// at the center, so the apex is not needed and is removed before the arc is inserted.
+/// \param f the face of an end-point of the arc
+/// \param c the arc center
+void VoronoiDiagram::remove_center_apex(HEFace f, const Point& c) {
+    VertexVector verts = g.face_vertices(f);
+    BOOST_FOREACH( HEVertex v, verts ) {
+        if ( g[v].type != APEX || (g[v].position - c).norm() > 1e-6 )
+            continue;
+        bool next_to_center = false;
+        BOOST_FOREACH( HEEdge e, g.out_edge_itr(v) ) {
+            if ( (g[ g.target(e) ].position - c).norm() < 1e-6 )
+                next_to_center = true;
+        }
+        if ( next_to_center ) {
+            if (debug) std::cout << " removing apex " << g[v].index << " at the arc center " << c << "\n";
+            g.remove_deg2_vertex(v);
+        }
+    }
+}
+
+/// \brief remove the ::NORMAL vertices of degree two left at the center of a tangent ArcSite
+///
+/// where an ArcSite is tangent to the adjacent site at an end-point (e.g. a fillet between two lines),
+/// the separator of the arc runs along the separator of the neighbour, to the arc center.
+/// there the separators of both end-points meet, and the center is a vertex of several coincident voronoi-vertices.
+/// one of them can be left with only the separator and a zero-length edge to another vertex at the center.
+/// the zero-length edge is contracted, so that the separator ends at the other vertex.
+void VoronoiDiagram::remove_center_vertices() {
+    VertexVector center_vertices;
+    BOOST_FOREACH( HEVertex v, modified_vertices ) {
+        if ( g[v].type == NORMAL && g.degree(v) == 4 )
+            center_vertices.push_back(v);
+    }
+    BOOST_FOREACH( HEVertex v, center_vertices ) {
+        EdgeVector v_edges = g.out_edges(v);
+        assert( v_edges.size() == 2 );
+        // the zero-length edge, and the separator
+        HEEdge zero = v_edges[0], sep = v_edges[1];
+        if ( (g[g.target(sep)].position - g[v].position).norm() < (g[g.target(zero)].position - g[v].position).norm() )
+            std::swap(zero,sep);
+        HEVertex center = g.target(zero);
+        HEVertex endp = g.target(sep);
+        if (debug) {
+            std::cout << " removing center vertex " << g[v].index << " at " << g[v].position << ", next to "
+                      << g[center].index << " at distance " << (g[center].position - g[v].position).norm() << "\n";
+        }
+        assert( (g[center].position - g[v].position).norm() < 1e-6 );
+        EdgeProps sep_out, sep_in;
+        sep_out = g[sep];            // from v to the end-point
+        sep_in = g[ g[sep].twin ];   // from the end-point to v
+        g.remove_deg2_vertex(v);
+        modified_vertices.erase(v);
+        BOOST_FOREACH( HEEdge e, g.out_edge_itr(center) ) {
+            if ( g.target(e) == endp ) {
+                g[e] = sep_out;
+                g[ g[e].twin ] = sep_in;
+            }
+        }
+    }
+}
+
 /// \brief add ::NEW vertices on ::IN-::OUT edges
 /// 
 /// generate new voronoi-vertices on all IN-OUT edges 
@@ -1552,6 +1697,8 @@ void VoronoiDiagram::add_vertices( Site* new_site ) {
     if (debug) std::cout << "add_vertices(): \n";
     assert( !v0.empty() );
     EdgeVector q_edges = find_in_out_edges();       // new vertices generated on these IN-OUT edges
+    // only an ArcSite tangent to LineSites or ArcSites at both end-points has no IN-OUT edges
+    assert( !q_edges.empty() || new_site->isArc() );
     for( unsigned int m=0; m<q_edges.size(); ++m )  {   
         if (debug) {
             HEVertex src = g.source(q_edges[m]);
@@ -1706,13 +1853,14 @@ void VoronoiDiagram::add_edge(EdgeData ed, HEFace newface, HEFace newface2) {
                 assert( !g[new_source].position.is_right( new_site->start(), new_site->end() ) );
                 assert( !g[new_target].position.is_right( new_site->start(), new_site->end() ) );
         }
-    } else if (f_site->isLine() && new_site->isArc() )  { // LA
-        Point pt2 = Point( new_site->x(), new_site->y() );
-        Point pt1 = f_site->apex_point(pt2);
-        src_sign = g[new_source].position.is_right( pt1, pt2 );
-        trg_sign = g[new_target].position.is_right( pt1, pt2 );
-        // if one vertex is on a null-face, we cannot trust the sign
-        if ( g[new_source].dist() == 0 || g[new_target].dist() == 0 ) {
+    } else if ( (f_site->isLine() || f_site->isArc()) && new_site->isArc() )  { // LA or AA
+        // the sides of these bisectors depend on the offset-directions of both sites,
+        // so instead of a geometric predicate we pick the branch that passes through each vertex
+        src_sign = !edge_branch( f_site, new_site, new_source );
+        trg_sign = !edge_branch( f_site, new_site, new_target );
+        // if one vertex is on a null-face, we cannot trust the sign.
+        // if both are, the edge runs between the two intersections of the sites, one on each branch.
+        if ( (g[new_source].dist() == 0) != (g[new_target].dist() == 0) ) {
             if ( g[new_source].dist() > g[new_target].dist() ) {
                 src_sign = trg_sign;
             } else {
@@ -1815,12 +1963,30 @@ void VoronoiDiagram::add_edge(EdgeData ed, HEFace newface, HEFace newface2) {
     // position the apex
         double min_t = g[e1].minimum_t(f_site,new_site);
         g[apex].position = g[e1].point(min_t);
+        if ( g[e1].type == ELLIPSE && !( f_site->in_region(g[apex].position) && new_site->in_region(g[apex].position) ) ) {
+            // an ELLIPSE has a second apex at its maximum t-value
+            g[apex].position = g[e1].point( g[e1].maximum_t() );
+        }
         g[apex].init_dist(f_site->apex_point(g[apex].position));
         modified_vertices.insert( apex );
     }
 }
 
 
+/// \brief return the sqrt() sign of the edge between \a s1 and \a s2 that passes through \a v
+///
+/// the parametrization set by EdgeProps::set_parameters(s1,s2,sign) is evaluated with both signs
+/// at the clearance-disk radius of \a v, and the sign giving the point closest to \a v is returned.
+bool VoronoiDiagram::edge_branch(Site* s1, Site* s2, HEVertex v) {
+    EdgeProps e;
+    e.set_parameters(s1, s2, true);
+    double t = g[v].dist();
+    double err_pos = ( e.point(t) - g[v].position ).norm();
+    e.sign = !e.sign;
+    double err_neg = ( e.point(t) - g[v].position ).norm();
+    return (err_pos <= err_neg);
+}
+
 /// \brief find the target of a new ::SEPARATOR edge
 /// \param f the HEFace on which we search for the target vertex
 /// \param endp the end-point of the null-face with the ::SEPARATOR source
@@ -2137,7 +2303,8 @@ EdgeVector VoronoiDiagram::find_in_out_edges() {
         }
     }
     if (debug) std::cout << "find_in_out_edges() " << output.size() << " IN-OUT edges \n";
-    assert( !output.empty() );
+    // output can be empty when an ArcSite is tangent to LineSites or ArcSites at both end-points.
+    // then all NEW vertices are existing SEPARATOR targets, set in process_null_edge(). add_vertices() checks the site.
     return output;
 }
 
@@ -2225,11 +2392,13 @@ int VoronoiDiagram::num_new_vertices(HEFace f) {
 
 /// filter the graph using given Filter \a flt
 void VoronoiDiagram::filter( Filter* flt) {
+    OVD_TRACE_SCOPE("filter");
     flt->set_graph(&g);
     BOOST_FOREACH(HEEdge e, g.edges() ) {
         if ( ! (*flt)(e) )
             g[e].valid = false;
     }
+    g.mark_changed();
 }
 
 /// \brief reset filtering by setting all edges valid
@@ -2237,6 +2406,7 @@ void VoronoiDiagram::filter_reset() { // this sets valid=true for all edges
     BOOST_FOREACH(HEEdge e, g.edges() ) {
         g[e].valid = true;
     }
+    g.mark_changed();
 }
     
 /// run topology/geometry check on diagram
@@ -2250,6 +2420,52 @@ bool VoronoiDiagram::check() {
     }
 }
 
+/// \brief return the memory used by the diagram, in bytes
+///
+/// graph figures are computed from element counts and record sizes, see half_edge_diagram::vertex_bytes().
+/// scratch containers are those used during site insertion (vertexQueue, incident_faces, modified_vertices, v0).
+MemoryUsage VoronoiDiagram::memory_usage() const {
+    MemoryUsage m;
+    m.vertices = g.vertex_bytes();
+    m.half_edges = g.half_edge_bytes();
+    m.out_edge_lists = g.adjacency_bytes();
+    m.faces = g.face_bytes();
+    m.sites = site_bytes;
+    m.kdtree = kd_tree->memory_usage();
+    // std::map and std::set nodes carry a color and three link-pointers
+    std::size_t tree_node = 4*sizeof(void*);
+    m.vertex_map = vertex_map.size()*( tree_node + sizeof(VertexMapPair) );
+    m.scratch = vertexQueue.size()*sizeof(VertexDetPair) +
+                incident_faces.capacity()*sizeof(HEFace) +
+                modified_vertices.size()*( tree_node + sizeof(HEVertex) ) +
+                v0.capacity()*sizeof(HEVertex);
+    int n_sites = num_point_sites() + num_line_sites() + num_arc_sites();
+    m.bytes_per_site = (n_sites>0) ? (double)m.total()/n_sites : 0;
+    return m;
+}
+
+/// total number of bytes
+std::size_t MemoryUsage::total() const {
+    return vertices + half_edges + out_edge_lists + faces + sites + kdtree + vertex_map + scratch;
+}
+
+/// string with the memory breakdown, one item per line
+std::string MemoryUsage::str() const {
+    std::ostringstream o;
+    o << "MemoryUsage \n";
+    o << " vertices       = " << vertices << "\n";
+    o << " half_edges     = " << half_edges << "\n";
+    o << " out_edge_lists = " << out_edge_lists << "\n";
+    o << " faces          = " << faces << "\n";
+    o << " sites          = " << sites << "\n";
+    o << " kdtree         = " << kdtree << "\n";
+    o << " vertex_map     = " << vertex_map << "\n";
+    o << " scratch        = " << scratch << "\n";
+    o << " total          = " << total() << "\n";
+    o << " bytes_per_site = " << bytes_per_site << "\n";
+    return o.str();
+}
+
 /// string repr
 std::string VoronoiDiagram::print() const {
     std::ostringstream o;
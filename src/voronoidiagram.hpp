@@ -120,6 +120,23 @@ struct kd_point {
 /// type of the KD-tree used for nearest-neighbor search
 typedef kdtree::KDTree<kd_point> kd_type; 
 
+/// \brief memory used by a VoronoiDiagram, in bytes. see VoronoiDiagram::memory_usage()
+struct MemoryUsage {
+    MemoryUsage() : vertices(0), half_edges(0), out_edge_lists(0), faces(0),
+                    sites(0), kdtree(0), vertex_map(0), scratch(0), bytes_per_site(0) {}
+    std::size_t vertices;       ///< vertex records
+    std::size_t half_edges;     ///< half-edge records, including the edge parametrization
+    std::size_t out_edge_lists; ///< per-vertex out-edge and in-edge lists
+    std::size_t faces;          ///< face records
+    std::size_t sites;          ///< Site objects
+    std::size_t kdtree;         ///< kd-tree nodes
+    std::size_t vertex_map;     ///< VoronoiDiagram::vertex_map
+    std::size_t scratch;        ///< temporary containers used during site insertion
+    double bytes_per_site;      ///< total() divided by the number of input sites
+    std::size_t total() const;
+    std::string str() const;
+};
+
 /// \brief Voronoi diagram.
 ///
 /// see http://en.wikipedia.org/wiki/Voronoi_diagram
@@ -149,6 +166,7 @@ public:
     /// return number of faces in graph
     int num_faces() const { return g.num_faces(); }
     int num_split_vertices() const;
+    MemoryUsage memory_usage() const;
     /// return reference to graph \todo not elegant. only used by vd2svg ?
     HEGraph& get_graph_reference() {return g;}
     
@@ -221,6 +239,7 @@ protected:
     void   add_edges(HEFace new_f1, HEFace f);        
     void   add_edges(HEFace new_f1, HEFace f, HEFace new_f2, std::pair<HEVertex,HEVertex> seg);
     void   add_edge(EdgeData ed, HEFace new1, HEFace new2=0);
+    bool   edge_branch(Site* s1, Site* s2, HEVertex v);
     void   add_separator(HEFace f, HEFace nf, boost::tuple<HEEdge, HEVertex, HEEdge,bool> target, HEVertex endp, Site* s1, Site* s2);
     void   add_split_vertex(HEFace f, Site* s);
     boost::tuple<HEVertex,HEFace,HEVertex,HEVertex,HEFace> find_null_face(HEVertex start, HEVertex other, Point l, Point dir, Site* new_site);
@@ -233,6 +252,8 @@ protected:
                                  std::pair<HEFace,HEFace> null_faces );
     void remove_vertex_set();
     void remove_split_vertex(HEFace f);
+    void remove_center_apex(HEFace f, const Point& c);
+    void remove_center_vertices();
     void reset_status();
     int num_new_vertices(HEFace f);
 // HELPER-CLASSES
@@ -253,6 +274,7 @@ protected:
     FaceVector incident_faces; ///< temporary variable for ::INCIDENT faces, will be reset to ::NONINCIDENT after a site has been inserted
     std::set<HEVertex> modified_vertices; ///< temporary variable for in-vertices, out-vertices that need to be reset after a site has been inserted
     VertexVector v0; ///< IN-vertices, i.e. to-be-deleted
+    std::size_t site_bytes; ///< bytes allocated for Site objects, reported by memory_usage()
     bool debug; ///< turn debug output on/off
     bool silent; ///< no warnings emitted when silent==true
 private:
@@ -0,0 +1,417 @@
+/*
+ *  Copyright (c) 2010-2012 Anders Wallin (anders.e.e.wallin "at" gmail.com).
+ *
+ *  This file is part of Openvoronoi
+ *  (see https://github.com/aewallin/openvoronoi).
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <algorithm>
+#include <cmath>
+
+#include <boost/foreach.hpp>
+
+#include "zigzag_pocket.hpp"
+#include "trace.hpp"
+
+namespace ovd
+{
+
+namespace {
+
+/// \brief one offset loop, in the frame where the scan-lines are horizontal
+struct Loop {
+    std::vector<OffsetVertex> v; ///< v[0] is the start point, v[k] the end of element k
+    std::vector<double> s;       ///< s[k] is the length along the loop to v[k]
+    /// number of elements
+    unsigned int size() const { return v.size()-1; }
+};
+
+/// \brief a part of an offset-element that is monotone in y
+struct Piece {
+    double y0;          ///< smallest y
+    double y1;          ///< largest y
+    Point p0;           ///< start of the line
+    Point p1;           ///< end of the line
+    double d0;          ///< angle from the element start to the start of the arc
+    double d1;          ///< angle from the element start to the end of the arc
+    unsigned int loop;  ///< index of the loop
+    unsigned int k;     ///< index of the element in the loop
+    /// sort by y0
+    bool operator<(const Piece& other) const { return y0 < other.y0; }
+};
+
+/// \brief an intersection of a scan-line and the boundary
+struct Hit {
+    Point p;            ///< the intersection
+    unsigned int loop;  ///< loop
+    unsigned int k;     ///< element of the loop
+    double s;           ///< length along the loop to p
+    /// sort by x
+    bool operator<(const Hit& other) const { return p.x < other.p.x; }
+};
+
+/// \brief the part of a scan-line inside the boundary
+struct Interval {
+    Hit a;              ///< left end
+    Hit b;              ///< right end
+    unsigned int cell;  ///< the cell of this interval
+};
+
+/// \brief a point where a cell can be entered: the first or last pass, on the left or right
+struct Corner {
+    Point p;            ///< position
+    unsigned int cell;  ///< the cell
+    int corner;         ///< bit 0: on the last pass, bit 1: on the right end
+    Corner(const Point& pi, unsigned int c, int k) : p(pi), cell(c), corner(k) {}
+    /// sort by x
+    bool operator<(const Corner& other) const { return p.x < other.p.x; }
+};
+
+/// rotate \a p by the angle with cosine \a c and sine \a s
+Point rotate(const Point& p, double c, double s) {
+    return Point( c*p.x - s*p.y, s*p.x + c*p.y );
+}
+
+/// \brief builds the passes and links of a zig-zag toolpath, in the rotated frame
+class ZigZag {
+public:
+    /// \param boundary offset loops, \param angle scan-direction
+    ZigZag(const OffsetLoops& boundary, double angle) : cos_a( cos(angle) ), sin_a( sin(angle) ) {
+        BOOST_FOREACH(const OffsetLoop& loop, boundary) {
+            loops.push_back( Loop() );
+            Loop& l = loops.back();
+            BOOST_FOREACH(const OffsetVertex& ov, loop.vertices) {
+                OffsetVertex v(ov);
+                v.p = rotate(ov.p, cos_a, -sin_a);
+                v.c = rotate(ov.c, cos_a, -sin_a);
+                l.s.push_back( l.v.empty() ? 0 : l.s.back() + v.length( l.v.back().p ) );
+                l.v.push_back(v);
+            }
+            if ( l.v.size() < 2 )
+                loops.pop_back();
+        }
+        for (unsigned int n=0;n<loops.size();n++) {
+            for (unsigned int k=1;k<=loops[n].size();k++)
+                split(n,k);
+        }
+        std::sort( pieces.begin(), pieces.end() );
+    }
+    /// the intervals of scan-lines at most \a stepover apart
+    void scan(double stepover) {
+        if ( pieces.empty() )
+            return;
+        double y_min = pieces.front().y0;
+        double y_max = y_min;
+        BOOST_FOREACH(const Piece& p, pieces) {
+            y_max = std::max(y_max, p.y1);
+        }
+        unsigned int n = std::max( 1.0, ceil( (y_max-y_min)/stepover ) );
+        double spacing = (y_max-y_min)/n;
+        std::vector<unsigned int> active;
+        std::size_t next = 0;
+        lines.resize(n);
+        for (unsigned int i=0;i<n;i++) {
+            double y = y_min + spacing*(i+0.5);
+            while ( next < pieces.size() && pieces[next].y0 <= y )
+                active.push_back(next++);
+            std::vector<Hit> hits;
+            std::size_t kept = 0;
+            for (std::size_t j=0;j<active.size();j++) {
+                const Piece& p = pieces[ active[j] ];
+                if ( p.y1 <= y ) // the piece is below this and all later scan-lines
+                    continue;
+                active[kept++] = active[j];
+                hits.push_back( hit(p,y) );
+            }
+            active.resize(kept);
+            std::sort( hits.begin(), hits.end() );
+            for (std::size_t j=0;j+1<hits.size();j+=2) {
+                if ( hits[j].p.x < hits[j+1].p.x ) {
+                    Interval iv;
+                    iv.a = hits[j];
+                    iv.b = hits[j+1];
+                    lines[i].push_back(iv);
+                }
+            }
+        }
+    }
+    /// \brief group the intervals into cells, in increasing scan-line order
+    ///
+    /// an interval continues the cell of the interval on the previous scan-line if they overlap,
+    /// and neither overlaps another interval.
+    void make_cells() {
+        for (unsigned int i=0;i<lines.size();i++) {
+            std::vector<Interval>& line = lines[i];
+            for (unsigned int j=0;j<line.size();j++) {
+                int previous = (i > 0) ? only_overlap( lines[i-1], line[j] ) : -1;
+                if ( previous != -1 && only_overlap( line, lines[i-1][previous] ) == (int)j ) {
+                    line[j].cell = lines[i-1][previous].cell;
+                } else {
+                    line[j].cell = cells.size();
+                    cells.push_back( std::vector<const Interval*>() );
+                }
+                cells[ line[j].cell ].push_back( &line[j] );
+            }
+        }
+    }
+    /// \brief the cells as ZigZagPaths, ordered by nearest-neighbour from the bottom left of the first cell
+    ///
+    /// the corners are sorted by x, and the search for the nearest corner goes out in both directions
+    /// from the x of the current position, until the distance in x alone is larger than the best found.
+    void order(std::vector<ZigZagPath>& out) {
+        std::vector<Corner> corners;
+        for (unsigned int n=0;n<cells.size();n++) {
+            for (int corner=0;corner<4;corner++) {
+                const Interval* first = (corner & 1) ? cells[n].back() : cells[n].front();
+                corners.push_back( Corner( (corner & 2) ? first->b.p : first->a.p, n, corner ) );
+            }
+        }
+        std::sort( corners.begin(), corners.end() );
+        std::vector<bool> done( cells.size(), false );
+        unsigned int c = 0;
+        bool top = false, right = false;
+        for (unsigned int n=0;n<cells.size();n++) {
+            done[c] = true;
+            out.push_back( ZigZagPath() );
+            cut( cells[c], top, right, out.back() );
+            Point position = out.back().moves.back().p;
+            double best_dist = -1;
+            std::size_t start = std::lower_bound( corners.begin(), corners.end(), Corner(position,0,0) ) - corners.begin();
+            for (std::size_t i=start; i<corners.size(); i++) { // to the right
+                if ( best_dist >= 0 && corners[i].p.x - position.x > best_dist )
+                    break;
+                nearest( corners[i], position, done, best_dist, c, top, right );
+            }
+            for (std::size_t i=start; i-- > 0; ) { // to the left
+                if ( best_dist >= 0 && position.x - corners[i].p.x > best_dist )
+                    break;
+                nearest( corners[i], position, done, best_dist, c, top, right );
+            }
+        }
+        BOOST_FOREACH(ZigZagPath& path, out) { // back to the frame of the diagram
+            BOOST_FOREACH(OffsetVertex& v, path.moves) {
+                v.p = rotate(v.p, cos_a, sin_a);
+                v.c = rotate(v.c, cos_a, sin_a);
+            }
+        }
+    }
+private:
+    /// split element \a k of loop \a n into pieces, at the top and bottom of arcs
+    void split(unsigned int n, unsigned int k) {
+        const Loop& l = loops[n];
+        const Point& start = l.v[k-1].p;
+        const OffsetVertex& e = l.v[k];
+        Piece p;
+        p.loop = n;
+        p.k = k;
+        if ( e.r <= 0 ) {
+            if ( start.y == e.p.y ) // a line along the scan-direction is never crossed
+                return;
+            p.p0 = start;
+            p.p1 = e.p;
+            p.y0 = std::min(start.y, e.p.y);
+            p.y1 = std::max(start.y, e.p.y);
+            p.d0 = p.d1 = 0;
+            pieces.push_back(p);
+            return;
+        }
+        double sweep = arc_sweep(start, e.p, e.c, e.cw);
+        double a0 = atan2( start.y-e.c.y, start.x-e.c.x );
+        std::vector<double> d; // angles from the start, where the arc is split
+        d.push_back(0);
+        double extremes[2] = { M_PI/2, -M_PI/2 };
+        for (int i=0;i<2;i++) {
+            double to = fmod( extremes[i] - a0 + 4*M_PI, 2*M_PI ); // in [0, 2pi), counter-clockwise
+            if ( sweep < 0 && to > 0 )
+                to -= 2*M_PI;
+            if ( fabs(to) > 0 && fabs(to) < fabs(sweep) )
+                d.push_back(to);
+        }
+        d.push_back(sweep);
+        std::sort( d.begin(), d.end() );
+        for (unsigned int i=0;i+1<d.size();i++) {
+            // the ends of the element are exact, so that adjacent pieces meet at the same y
+            double y_a = (d[i] == 0) ? start.y : (d[i] == sweep) ? e.p.y : e.c.y + e.r*sin(a0+d[i]);
+            double y_b = (d[i+1] == 0) ? start.y : (d[i+1] == sweep) ? e.p.y : e.c.y + e.r*sin(a0+d[i+1]);
+            if ( y_a == y_b )
+                continue;
+            p.y0 = std::min(y_a, y_b);
+            p.y1 = std::max(y_a, y_b);
+            p.d0 = d[i];
+            p.d1 = d[i+1];
+            pieces.push_back(p);
+        }
+    }
+    /// the intersection of piece \a p with the scan-line at \a y
+    Hit hit(const Piece& p, double y) const {
+        const Loop& l = loops[p.loop];
+        const Point& start = l.v[p.k-1].p;
+        const OffsetVertex& e = l.v[p.k];
+        Hit h;
+        h.loop = p.loop;
+        h.k = p.k;
+        if ( e.r <= 0 ) {
+            h.p = Point( p.p0.x + (y-p.p0.y)*(p.p1.x-p.p0.x)/(p.p1.y-p.p0.y), y );
+            h.s = l.s[p.k-1] + (h.p-start).norm();
+            return h;
+        }
+        // the piece lies between a top and a bottom of the circle, on one side of the center
+        double a0 = atan2( start.y-e.c.y, start.x-e.c.x );
+        double mid = a0 + 0.5*(p.d0+p.d1);
+        double dy = std::max( -e.r, std::min( e.r, y-e.c.y ) );
+        double dx = sqrt( std::max( 0.0, e.r*e.r - dy*dy ) );
+        h.p = Point( e.c.x + ( (cos(mid) > 0) ? dx : -dx ), y );
+        double d = atan2( h.p.y-e.c.y, h.p.x-e.c.x ) - (a0+p.d0); // angle from the start of the piece
+        d -= 2*M_PI*floor( (d+M_PI)/(2*M_PI) );
+        d = std::max( std::min(p.d0,p.d1), std::min( std::max(p.d0,p.d1), p.d0+d ) );
+        h.s = l.s[p.k-1] + e.r*fabs(d);
+        return h;
+    }
+    /// \brief the only interval of \a line that overlaps \a iv, or -1
+    ///
+    /// the intervals of a scan-line are disjoint and sorted by x, so the first one that ends
+    /// after the start of \a iv is found by bisection, and only it and the one after it are checked.
+    int only_overlap(const std::vector<Interval>& line, const Interval& iv) const {
+        unsigned int lo = 0, hi = line.size();
+        while ( lo < hi ) {
+            unsigned int mid = (lo+hi)/2;
+            if ( line[mid].b.p.x <= iv.a.p.x )
+                lo = mid+1;
+            else
+                hi = mid;
+        }
+        if ( lo == line.size() || line[lo].a.p.x >= iv.b.p.x )
+            return -1;
+        if ( lo+1 < line.size() && line[lo+1].a.p.x < iv.b.p.x )
+            return -1;
+        return lo;
+    }
+    /// if \a k is closer to \a position than \a best_dist, and its cell is not \a done, make it the best corner
+    void nearest(const Corner& k, const Point& position, const std::vector<bool>& done,
+                 double& best_dist, unsigned int& c, bool& top, bool& right) const {
+        if ( done[k.cell] )
+            return;
+        double d = ( k.p - position ).norm();
+        if ( best_dist < 0 || d < best_dist ) {
+            best_dist = d;
+            c = k.cell;
+            top = (k.corner & 1);
+            right = (k.corner & 2);
+        }
+    }
+    /// add the passes of \a cell to \a path, from the top or the bottom, starting on the right or the left
+    void cut(const std::vector<const Interval*>& cell, bool top, bool right, ZigZagPath& path) {
+        path.passes = cell.size();
+        for (unsigned int i=0;i<cell.size();i++) {
+            const Interval* iv = top ? cell[cell.size()-1-i] : cell[i];
+            if ( i == 0 )
+                path.moves.push_back( OffsetVertex( (right ? iv->b : iv->a).p ) );
+            path.moves.push_back( OffsetVertex( (right ? iv->a : iv->b).p ) );
+            if ( i+1 < cell.size() ) { // link to the next pass, on the side where this pass ends
+                const Interval* next = top ? cell[cell.size()-2-i] : cell[i+1];
+                link( right ? iv->a : iv->b, right ? next->a : next->b, path );
+            }
+            right = !right;
+        }
+    }
+    /// \brief move from \a a to \a b, along the boundary if they are on the same loop
+    ///
+    /// the shorter way around the loop is taken.
+    void link(const Hit& a, const Hit& b, ZigZagPath& path) {
+        if ( a.p == b.p )
+            return;
+        if ( a.loop != b.loop ) {
+            path.moves.push_back( OffsetVertex(b.p) );
+            return;
+        }
+        const Loop& l = loops[a.loop];
+        double length = l.s.back();
+        double forward = b.s - a.s;
+        if ( forward < 0 )
+            forward += length;
+        unsigned int n = l.size();
+        if ( forward <= length - forward ) {
+            unsigned int k = a.k;
+            if ( !( k == b.k && b.s >= a.s ) ) {
+                add(l, k, l.v[k].p, false, path); // to the end of element k
+                for ( k = k%n+1; k != b.k; k = k%n+1 )
+                    add(l, k, l.v[k].p, false, path);
+            }
+            add(l, b.k, b.p, false, path);
+        } else {
+            unsigned int k = a.k;
+            if ( !( k == b.k && b.s <= a.s ) ) {
+                add(l, k, l.v[k-1].p, true, path); // to the start of element k
+                for ( k = (k+n-2)%n+1; k != b.k; k = (k+n-2)%n+1 )
+                    add(l, k, l.v[k-1].p, true, path);
+            }
+            add(l, b.k, b.p, true, path);
+        }
+    }
+    /// add a move along element \a k of \a l to \a p, \a reverse if against the direction of the loop
+    void add(const Loop& l, unsigned int k, const Point& p, bool reverse, ZigZagPath& path) {
+        if ( path.moves.back().p == p )
+            return;
+        const OffsetVertex& e = l.v[k];
+        if ( e.r <= 0 )
+            path.moves.push_back( OffsetVertex(p) );
+        else
+            path.moves.push_back( OffsetVertex(p, e.r, e.c, reverse ? !e.cw : e.cw, e.f) );
+    }
+
+    double cos_a;  ///< cosine of the scan-direction
+    double sin_a;  ///< sine of the scan-direction
+    std::vector<Loop> loops;   ///< the boundary
+    std::vector<Piece> pieces; ///< monotone pieces of the boundary, sorted by y0
+    std::vector< std::vector<Interval> > lines; ///< the intervals of each scan-line
+    std::vector< std::vector<const Interval*> > cells; ///< the intervals of each cell, by scan-line
+};
+
+} // end anonymous namespace
+
+ZigZagPocket::ZigZagPocket(HEGraph& gi) : g(gi) { }
+
+void ZigZagPocket::run(double radius, double stepover, double angle) {
+    Offset of(g);
+    run( of.offset(radius), stepover, angle );
+}
+
+void ZigZagPocket::run(const OffsetLoops& boundary, double stepover, double angle) {
+    OVD_TRACE_SCOPE("zigzag_pocket");
+    cells.clear();
+    ZigZag zz(boundary, angle);
+    zz.scan(stepover);
+    zz.make_cells();
+    zz.order(cells);
+}
+
+double ZigZagPocket::cut_length() const {
+    double length = 0;
+    BOOST_FOREACH( const ZigZagPath& path, cells ) {
+        for (unsigned int k=1;k<path.moves.size();k++)
+            length += path.moves[k].length( path.moves[k-1].p );
+    }
+    return length;
+}
+
+double ZigZagPocket::rapid_length() const {
+    double length = 0;
+    for (unsigned int n=1;n<cells.size();n++)
+        length += ( cells[n].moves.front().p - cells[n-1].moves.back().p ).norm();
+    return length;
+}
+
+} // end ovd namespace
+// end file zigzag_pocket.cpp
@@ -0,0 +1,77 @@
+/*
+ *  Copyright (c) 2010-2012 Anders Wallin (anders.e.e.wallin "at" gmail.com).
+ *
+ *  This file is part of Openvoronoi
+ *  (see https://github.com/aewallin/openvoronoi).
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <vector>
+
+#include "graph.hpp"
+#include "offset.hpp"
+
+namespace ovd
+{
+
+/// \brief one cell of a zig-zag toolpath, cut without lifting the tool
+struct ZigZagPath {
+    /// the start point, followed by lines and arcs, in the format of OffsetLoop::vertices
+    std::vector<OffsetVertex> moves;
+    unsigned int passes; ///< number of scan-line passes in the cell
+};
+
+/// \brief zig-zag (direction-parallel) pocketing toolpath
+///
+/// the tool-center must stay where the clearance-disk radius is at least the tool radius.
+/// the boundary of that region is the offset of the (filtered) vd at the tool radius.
+/// the region is cut by scan-lines spaced at most one stepover apart, at a given angle.
+///
+/// the offset-elements are split into lines and arcs that are monotone along the scan-direction,
+/// and swept in scan-line order, so each scan-line/boundary intersection is found in constant time from
+/// the elements that span the scan-line. no polygon clipping is done.
+///
+/// the intervals of consecutive scan-lines that overlap one-to-one form a monotone cell.
+/// each cell is cut in one ZigZagPath: passes along the scan-lines in alternating directions,
+/// linked by moves along the boundary. the cells are ordered by a nearest-neighbour search
+/// over the four corners where a cell can be entered, to reduce the rapid moves between them.
+class ZigZagPocket {
+public:
+    /// \param gi vd-graph, filtered so that the pocket interior is valid
+    ZigZagPocket(HEGraph& gi);
+    /// \brief build the toolpath for a tool of radius \a radius
+    /// \param radius tool radius
+    /// \param stepover largest distance between scan-lines
+    /// \param angle direction of the scan-lines, in radians from the x-axis
+    void run(double radius, double stepover, double angle=0);
+    /// \brief build the toolpath inside the offset loops \a boundary
+    ///
+    /// e.g. from an Offset restricted to one pocket with Offset::set_region()
+    void run(const OffsetLoops& boundary, double stepover, double angle=0);
+    /// the cells, in machining order
+    const std::vector<ZigZagPath>& paths() const { return cells; }
+    /// total length of the cutting moves: passes and links
+    double cut_length() const;
+    /// total length of the rapid moves between cells
+    double rapid_length() const;
+private:
+    ZigZagPocket(); // don't use.
+    HEGraph& g; ///< vd-graph
+    std::vector<ZigZagPath> cells; ///< output
+};
+
+} // end ovd namespace
+// end file zigzag_pocket.hpp